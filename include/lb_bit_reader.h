@@ -0,0 +1,139 @@
+#ifndef LB_BIT_READER_H
+#define LB_BIT_READER_H
+
+#include "lb_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reads values of arbitrary bit width (1-64) written by a LB_BitWriter.
+typedef struct LB_BitReader {
+    LB_Reader *reader;
+    // Bits that have been read from the underlying reader but not consumed yet.
+    uint64_t bits;
+    // Number of buffered bits.
+    uint32_t count;
+} LB_BitReader;
+
+LB_INLINE void lbBitReaderInit(LB_BitReader *bit_reader, LB_Reader *reader) {
+    *bit_reader = (LB_BitReader) {
+        .reader = reader,
+        .bits = 0,
+        .count = 0,
+    };
+}
+
+LB_INLINE LB_ReaderError lbBitReaderRefill(LB_BitReader *bit_reader, const uint32_t count) {
+    LB_Reader *reader = bit_reader->reader;
+    if (reader->_.mode == LB_READER_MODE_BUFFER) {
+        // Pull as many whole bytes as fit, the surplus is returned by `lbBitReaderFinish`.
+        LB_ReaderBuffer *buffer = &reader->_.buffer;
+        const uint8_t *data = (const uint8_t *) buffer->data + buffer->position;
+        size_t byte_count = (63 - bit_reader->count) / 8;
+        if (byte_count > buffer->length - buffer->position) {
+            byte_count = buffer->length - buffer->position;
+        }
+
+        for (size_t i = 0; i < byte_count; i++) {
+            bit_reader->bits |= (uint64_t) data[i] << bit_reader->count;
+            bit_reader->count += 8;
+        }
+
+        buffer->position += byte_count;
+        return bit_reader->count < count ? LB_READER_ERROR_END : LB_READER_ERROR_NONE;
+    }
+
+    // Other modes cannot give bytes back, so only read what is needed.
+    while (bit_reader->count < count) {
+        uint8_t byte;
+        const LB_ReaderError e = lbRead(reader, &byte, sizeof(byte));
+        if (e) {
+            return e;
+        }
+
+        bit_reader->bits |= (uint64_t) byte << bit_reader->count;
+        bit_reader->count += 8;
+    }
+
+    return LB_READER_ERROR_NONE;
+}
+
+/**
+ * Read `count` bits written by `lbWriteBits`.
+ *
+ * @param bit_reader The LB_BitReader to read from.
+ * @param count The number of bits to read, between 0 and 64.
+ * @param out_error A pointer to a LB_ReaderError, set if not NULL and LB_READER_SAFETY.
+ * @return The value, or 0 on error.
+ */
+LB_INLINE uint64_t lbReadBits(LB_BitReader *bit_reader, const uint32_t count, LB_ReaderError *out_error) {
+    if (count > 56) {
+        // A 64-bit buffer cannot always hold that many bits plus a partial byte.
+        const uint64_t low = lbReadBits(bit_reader, 32, out_error);
+#ifdef LB_READER_SAFETY
+        if (out_error != NULL && *out_error) {
+            return 0;
+        }
+#endif
+        return low | (lbReadBits(bit_reader, count - 32, out_error) << 32);
+    }
+
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    if (bit_reader->count < count) {
+        e = lbBitReaderRefill(bit_reader, count);
+    }
+
+#ifdef LB_READER_SAFETY
+    if (out_error != NULL) {
+        *out_error = e;
+    }
+#endif
+    if (e) {
+        return 0;
+    }
+
+    const uint64_t value = bit_reader->bits & (((uint64_t) 1 << count) - 1);
+    bit_reader->bits >>= count;
+    bit_reader->count -= count;
+    return value;
+}
+
+LB_INLINE int lbReadBit(LB_BitReader *bit_reader, LB_ReaderError *out_error) {
+    return (int) lbReadBits(bit_reader, 1, out_error);
+}
+
+/**
+ * Discard the padding of the current byte and hand unused whole bytes back to the
+ * underlying reader. Must be called before the underlying reader is used directly again.
+ */
+LB_INLINE void lbBitReaderFinish(LB_BitReader *bit_reader) {
+    LB_Reader *reader = bit_reader->reader;
+    if (reader->_.mode == LB_READER_MODE_BUFFER) {
+        reader->_.buffer.position -= bit_reader->count / 8;
+    }
+
+    bit_reader->bits = 0;
+    bit_reader->count = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif //LB_BIT_READER_H
+
+#if defined(LB_BIT_READER_IMPLEMENTATION) && !defined(LB_BUFFER_STATIC)
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void lbBitReaderInit(LB_BitReader *bit_reader, LB_Reader *reader);
+LB_ReaderError lbBitReaderRefill(LB_BitReader *bit_reader, uint32_t count);
+uint64_t lbReadBits(LB_BitReader *bit_reader, uint32_t count, LB_ReaderError *out_error);
+int lbReadBit(LB_BitReader *bit_reader, LB_ReaderError *out_error);
+void lbBitReaderFinish(LB_BitReader *bit_reader);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //LB_BIT_READER_IMPLEMENTATION
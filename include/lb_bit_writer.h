@@ -0,0 +1,111 @@
+#ifndef LB_BIT_WRITER_H
+#define LB_BIT_WRITER_H
+
+#include "lb_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Packs values of arbitrary bit width (1-64) into the underlying LB_Writer.
+// Bits are emitted least significant first, so the resulting byte stream is
+// little endian regardless of the host.
+typedef struct LB_BitWriter {
+    LB_Writer *writer;
+    // Pending bits that have not been written yet, starting at bit 0.
+    uint64_t bits;
+    // Number of pending bits, always less than 64.
+    uint32_t count;
+} LB_BitWriter;
+
+LB_INLINE void lbBitWriterInit(LB_BitWriter *bit_writer, LB_Writer *writer) {
+    *bit_writer = (LB_BitWriter) {
+        .writer = writer,
+        .bits = 0,
+        .count = 0,
+    };
+}
+
+LB_INLINE LB_WriterError lbBitWriterEmit(LB_BitWriter *bit_writer, const uint64_t bits, const uint32_t byte_count) {
+    uint8_t bytes[8];
+    for (uint32_t i = 0; i < byte_count; i++) {
+        bytes[i] = (uint8_t) (bits >> (i * 8));
+    }
+
+    return lbWrite(bit_writer->writer, bytes, byte_count);
+}
+
+/**
+ * Write the lowest `count` bits of `value`. Bits above `count` are ignored.       <br>
+ * Whole 64-bit words are passed to the underlying writer as they fill up.
+ *
+ * @param bit_writer The LB_BitWriter to write to.
+ * @param value The value to write.
+ * @param count The number of bits to write, between 0 and 64.
+ * @return LB_WriterError The error of the underlying writer, if any.
+ */
+LB_INLINE LB_WriterError lbWriteBits(LB_BitWriter *bit_writer, uint64_t value, const uint32_t count) {
+#ifdef LB_WRITER_SAFETY
+    if (count > 64) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+#endif
+
+    if (count < 64) {
+        value &= ((uint64_t) 1 << count) - 1;
+    }
+
+    const uint32_t free_bits = 64 - bit_writer->count;
+    if (count < free_bits) {
+        bit_writer->bits |= value << bit_writer->count;
+        bit_writer->count += count;
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    // The word is full, emit it and keep whatever did not fit.
+    const uint64_t word = bit_writer->bits | (value << bit_writer->count);
+    bit_writer->bits = free_bits == 64 ? 0 : value >> free_bits;
+    bit_writer->count = count - free_bits;
+    return lbBitWriterEmit(bit_writer, word, 8);
+}
+
+LB_INLINE LB_WriterError lbWriteBit(LB_BitWriter *bit_writer, const int value) {
+    return lbWriteBits(bit_writer, value ? 1 : 0, 1);
+}
+
+/**
+ * Write all pending bits to the underlying writer, padding the last byte with zeros.  <br>
+ * Must be called before the underlying writer is used directly again.
+ */
+LB_INLINE LB_WriterError lbBitWriterFlush(LB_BitWriter *bit_writer) {
+    if (bit_writer->count == 0) {
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    const uint64_t bits = bit_writer->bits;
+    const uint32_t byte_count = (bit_writer->count + 7) / 8;
+    bit_writer->bits = 0;
+    bit_writer->count = 0;
+    return lbBitWriterEmit(bit_writer, bits, byte_count);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif //LB_BIT_WRITER_H
+
+#if defined(LB_BIT_WRITER_IMPLEMENTATION) && !defined(LB_BUFFER_STATIC)
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void lbBitWriterInit(LB_BitWriter *bit_writer, LB_Writer *writer);
+LB_WriterError lbBitWriterEmit(LB_BitWriter *bit_writer, uint64_t bits, uint32_t byte_count);
+LB_WriterError lbWriteBits(LB_BitWriter *bit_writer, uint64_t value, uint32_t count);
+LB_WriterError lbWriteBit(LB_BitWriter *bit_writer, int value);
+LB_WriterError lbBitWriterFlush(LB_BitWriter *bit_writer);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //LB_BIT_WRITER_IMPLEMENTATION
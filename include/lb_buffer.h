@@ -4,6 +4,11 @@
 #ifdef LB_BUFFER_IMPLEMENTATION
 #define LB_WRITER_IMPLEMENTATION
 #define LB_READER_IMPLEMENTATION
+#define LB_STATS_IMPLEMENTATION
+#define LB_PROFILE_IMPLEMENTATION
+#define LB_CPU_IMPLEMENTATION
+#define LB_COPY_IMPLEMENTATION
+#define LB_STRIDED_IMPLEMENTATION
 #endif
 
 #ifdef LB_BUFFER_NO_SAFETY
@@ -13,5 +18,14 @@
 
 #include "lb_writer.h"
 #include "lb_reader.h"
+#include "lb_cpu.h"
+#include "lb_copy.h"
+#include "lb_strided.h"
+
+// The histogram export needs the complete writer and reader types, so its implementation comes after both.
+#ifdef LB_BUFFER_IMPLEMENTATION
+#define LB_HISTOGRAM_IMPLEMENTATION
+#include "lb_histogram.h"
+#endif
 
 #endif //LB_BUFFER_H
@@ -0,0 +1,481 @@
+#ifndef LB_BUFFER_HPP
+#define LB_BUFFER_HPP
+
+/*
+ * C++20 wrapper with the backend, byte order and safety level resolved at compile time.
+ *
+ * The C API dispatches on `_.mode` at run time on every call. Here the mode is a template parameter, so a buffer
+ * writer with checks disabled compiles every typed write down to a (byte swapped) store and a pointer bump.
+ *
+ *     lb::Writer<lb::BufferBE> writer(data, sizeof(data));
+ *     writer.write<uint32_t>(42);
+ *     writer.write(std::span<const float>(values));
+ *
+ *     lb::Reader<lb::BufferBE> reader(data, writer.position());
+ *     LB_ReaderError error = LB_READER_ERROR_NONE;
+ *     const uint32_t value = reader.read<uint32_t>(&error);
+ *
+ * Errors are the LB_WriterError and LB_ReaderError bit flags of the C API. Header-only: no implementation macro is
+ * needed, the C functions used here are inline.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "lb_buffer.h"
+
+namespace lb {
+
+enum class Backend {
+    // A caller-owned buffer of fixed length.
+    Buffer,
+    // A malloc'd buffer owned by the writer, doubled whenever it is full. Writers only.
+    Dynamic,
+    // A FILE* owned by the caller.
+    File,
+};
+
+enum class Safety {
+    // Bounds are checked and reported as LB_WRITER_ERROR_FULL / LB_READER_ERROR_END.
+    Checked,
+    // The caller guarantees every access is in bounds. Dynamic writers still grow.
+    Unchecked,
+};
+
+template <Backend B, std::endian E = std::endian::little, Safety S = Safety::Checked>
+struct Mode {
+    static constexpr Backend backend = B;
+    static constexpr std::endian endian = E;
+    static constexpr Safety safety = S;
+};
+
+using BufferLE = Mode<Backend::Buffer, std::endian::little>;
+using BufferBE = Mode<Backend::Buffer, std::endian::big>;
+using DynamicLE = Mode<Backend::Dynamic, std::endian::little>;
+using DynamicBE = Mode<Backend::Dynamic, std::endian::big>;
+using FileLE = Mode<Backend::File, std::endian::little>;
+using FileBE = Mode<Backend::File, std::endian::big>;
+
+// Types that can be written and read directly. bool is excluded, its representation is not portable.
+template <class T>
+concept Scalar = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+template <Scalar T>
+constexpr T byteswap(const T value) noexcept {
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else if constexpr (std::is_integral_v<T>) {
+#if defined(__cpp_lib_byteswap) && __cpp_lib_byteswap >= 202110L
+        return std::byteswap(value);
+#else
+        using U = std::make_unsigned_t<T>;
+        if constexpr (sizeof(T) == 2) {
+            return static_cast<T>(__builtin_bswap16(static_cast<U>(value)));
+        } else if constexpr (sizeof(T) == 4) {
+            return static_cast<T>(__builtin_bswap32(static_cast<U>(value)));
+        } else {
+            static_assert(sizeof(T) == 8, "unsupported integer width");
+            return static_cast<T>(__builtin_bswap64(static_cast<U>(value)));
+        }
+#endif
+    } else {
+        using U = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+        static_assert(sizeof(T) == sizeof(U), "unsupported floating point width");
+        return std::bit_cast<T>(byteswap(std::bit_cast<U>(value)));
+    }
+}
+
+// Convert between native byte order and `E`, in either direction.
+template <std::endian E, Scalar T>
+constexpr T toEndian(const T value) noexcept {
+    if constexpr (E == std::endian::native) {
+        return value;
+    } else {
+        return byteswap(value);
+    }
+}
+
+template <class M>
+class Writer {
+public:
+    static constexpr Backend backend = M::backend;
+    static constexpr std::endian endian = M::endian;
+    static constexpr Safety safety = M::safety;
+
+    Writer(void *data, const size_t length) noexcept requires(backend == Backend::Buffer)
+        : data_(static_cast<uint8_t *>(data)), length_(length) {
+    }
+
+    // If the allocation fails every write returns LB_WRITER_ERROR_FULL, see valid().
+    explicit Writer(const size_t initial_capacity = 64) noexcept requires(backend == Backend::Dynamic)
+        : data_(static_cast<uint8_t *>(std::malloc(initial_capacity ? initial_capacity : 1))),
+          length_(data_ ? (initial_capacity ? initial_capacity : 1) : 0) {
+    }
+
+    explicit Writer(FILE *file) noexcept requires(backend == Backend::File) : file_(file) {
+    }
+
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    Writer(Writer &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), length_(std::exchange(other.length_, 0)),
+          position_(std::exchange(other.position_, 0)), file_(std::exchange(other.file_, nullptr)),
+          streaming_threshold_(other.streaming_threshold_) {
+    }
+
+    // Swaps, so `other` releases this writer's old buffer.
+    Writer &operator=(Writer &&other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(length_, other.length_);
+        std::swap(position_, other.position_);
+        std::swap(file_, other.file_);
+        std::swap(streaming_threshold_, other.streaming_threshold_);
+        return *this;
+    }
+
+    // Writes of at least `threshold` bytes use non-temporal stores, 0 turns it off. See lbWriterSetStreaming.
+    void setStreaming(const size_t threshold) noexcept requires(backend != Backend::File) {
+        streaming_threshold_ = threshold;
+    }
+
+    ~Writer() {
+        if constexpr (backend == Backend::Dynamic) {
+            std::free(data_);
+        }
+    }
+
+    [[nodiscard]] bool valid() const noexcept {
+        if constexpr (backend == Backend::File) {
+            return file_ != nullptr;
+        } else {
+            return data_ != nullptr;
+        }
+    }
+
+    LB_WriterError write(const void *value, const size_t length) noexcept {
+        if constexpr (backend == Backend::File) {
+            return LB_FILE_WRITE(value, length, file_) == 1 || length == 0 ? LB_WRITER_ERROR_NONE
+                                                                             : LB_WRITER_ERROR_FULL;
+        } else {
+            if (const LB_WriterError e = reserve(length)) {
+                return e;
+            }
+
+            if (streaming_threshold_ && length >= streaming_threshold_) [[unlikely]] {
+                lbWriterStreamCopy(data_ + position_, value, length);
+            } else {
+                std::memcpy(data_ + position_, value, length);
+            }
+            position_ += length;
+            return LB_WRITER_ERROR_NONE;
+        }
+    }
+
+    template <Scalar T>
+    LB_WriterError write(const T value) noexcept {
+        const T ordered = toEndian<endian>(value);
+        if constexpr (backend == Backend::File) {
+            return write(&ordered, sizeof(T));
+        } else {
+            // Never worth streaming, so skip the threshold check.
+            if (const LB_WriterError e = reserve(sizeof(T))) {
+                return e;
+            }
+
+            std::memcpy(data_ + position_, &ordered, sizeof(T));
+            position_ += sizeof(T);
+            return LB_WRITER_ERROR_NONE;
+        }
+    }
+
+    // Bulk write; elements are swapped on the way out if the byte order differs from the host's.
+    template <class T, size_t N>
+        requires Scalar<std::remove_const_t<T>>
+    LB_WriterError write(const std::span<T, N> values) noexcept {
+        using U = std::remove_const_t<T>;
+        if constexpr (endian == std::endian::native || sizeof(U) == 1) {
+            return write(values.data(), values.size_bytes());
+        } else if constexpr (backend == Backend::File) {
+            U chunk[256 / sizeof(U)];
+            for (size_t i = 0; i < values.size(); i += std::size(chunk)) {
+                const size_t count = std::min(std::size(chunk), values.size() - i);
+                for (size_t j = 0; j < count; j++) {
+                    chunk[j] = byteswap(values[i + j]);
+                }
+                if (const LB_WriterError e = write(chunk, count * sizeof(U))) {
+                    return e;
+                }
+            }
+            return LB_WRITER_ERROR_NONE;
+        } else {
+            if (const LB_WriterError e = reserve(values.size_bytes())) {
+                return e;
+            }
+
+            uint8_t *target = data_ + position_;
+            for (size_t i = 0; i < values.size(); i++) {
+                const U swapped = byteswap(values[i]);
+                std::memcpy(target + i * sizeof(U), &swapped, sizeof(U));
+            }
+            position_ += values.size_bytes();
+            return LB_WRITER_ERROR_NONE;
+        }
+    }
+
+    // Buffer writers can seek up to their length, dynamic writers grow to reach `position`.
+    LB_WriterError seek(const size_t position) noexcept {
+        if constexpr (backend == Backend::File) {
+            return LB_FILE_SEEK(file_, position, SEEK_SET) == 0 ? LB_WRITER_ERROR_NONE : LB_WRITER_ERROR_FULL;
+        } else {
+            if (position > length_) {
+                if constexpr (backend == Backend::Dynamic) {
+                    if (const LB_WriterError e = grow(position)) {
+                        return e;
+                    }
+                } else if constexpr (safety == Safety::Checked) {
+                    return LB_WRITER_ERROR_FULL;
+                }
+            }
+
+            position_ = position;
+            return LB_WRITER_ERROR_NONE;
+        }
+    }
+
+    [[nodiscard]] size_t position() const noexcept {
+        if constexpr (backend == Backend::File) {
+            return static_cast<size_t>(LB_FILE_TELL(file_));
+        } else {
+            return position_;
+        }
+    }
+
+    // The capacity of a buffer, the current size of a file.
+    [[nodiscard]] size_t length() const noexcept {
+        if constexpr (backend == Backend::File) {
+            const LB_FileOffset position = LB_FILE_TELL(file_);
+            LB_FILE_SEEK(file_, 0, SEEK_END);
+            const LB_FileOffset end = LB_FILE_TELL(file_);
+            LB_FILE_SEEK(file_, position, SEEK_SET);
+            return static_cast<size_t>(end);
+        } else {
+            return length_;
+        }
+    }
+
+    [[nodiscard]] size_t remaining() const noexcept {
+        return length() - position();
+    }
+
+    // The written bytes of a buffer writer, nullptr for files.
+    [[nodiscard]] uint8_t *data() const noexcept {
+        return data_;
+    }
+
+    [[nodiscard]] std::span<const uint8_t> written() const noexcept requires(backend != Backend::File) {
+        return {data_, position_};
+    }
+
+private:
+    LB_WriterError grow(const size_t length) noexcept {
+        size_t new_length = length_ ? length_ * 2 : length;
+        while (new_length < length) {
+            new_length *= 2;
+        }
+
+        void *data = std::realloc(data_, new_length);
+        if (data == nullptr) {
+            return LB_WRITER_ERROR_FULL;
+        }
+
+        data_ = static_cast<uint8_t *>(data);
+        length_ = new_length;
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    // Make room for `length` more bytes at the current position.
+    LB_WriterError reserve(const size_t length) noexcept {
+        if constexpr (backend == Backend::Dynamic) {
+            if (length > length_ - position_) [[unlikely]] {
+                return grow(position_ + length);
+            }
+        } else if constexpr (safety == Safety::Checked) {
+            if (length > length_ - position_) [[unlikely]] {
+                return LB_WRITER_ERROR_FULL;
+            }
+        }
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    uint8_t *data_ = nullptr;
+    size_t length_ = 0;
+    size_t position_ = 0;
+    FILE *file_ = nullptr;
+    size_t streaming_threshold_ = 0;
+};
+
+template <class M>
+class Reader {
+public:
+    static constexpr Backend backend = M::backend;
+    static constexpr std::endian endian = M::endian;
+    static constexpr Safety safety = M::safety;
+    static_assert(backend != Backend::Dynamic, "readers only support the Buffer and File backends");
+
+    Reader(const void *data, const size_t length) noexcept requires(backend == Backend::Buffer)
+        : data_(static_cast<const uint8_t *>(data)), length_(length) {
+    }
+
+    explicit Reader(std::span<const uint8_t> data) noexcept requires(backend == Backend::Buffer)
+        : Reader(data.data(), data.size()) {
+    }
+
+    // Measures the length and position of `file` once and tracks the position from then on, see lbReaderInitFile.
+    explicit Reader(FILE *file) noexcept requires(backend == Backend::File) : file_(file) {
+        LB_Reader reader;
+        if (file != nullptr && lbReaderInitFile(&reader, file) == LB_READER_INIT_NONE) {
+            length_ = reader._.file.length;
+            position_ = reader._.file.position;
+        }
+    }
+
+    LB_ReaderError read(void *out_value, const size_t length) noexcept {
+        if constexpr (backend == Backend::File) {
+            if (length == 0 || LB_FILE_READ(out_value, length, file_) == 1) [[likely]] {
+                position_ += length;
+                return LB_READER_ERROR_NONE;
+            }
+
+            // Part of the value may have been consumed, see lbReaderFileResync.
+            if (length_ != SIZE_MAX) {
+                if (const LB_FileOffset position = LB_FILE_TELL(file_); position >= 0) {
+                    position_ = static_cast<size_t>(position);
+                }
+            }
+            return LB_READER_ERROR_END;
+        } else {
+            if constexpr (safety == Safety::Checked) {
+                if (length > length_ - position_) [[unlikely]] {
+                    return LB_READER_ERROR_END;
+                }
+            }
+
+            std::memcpy(out_value, data_ + position_, length);
+            position_ += length;
+            return LB_READER_ERROR_NONE;
+        }
+    }
+
+    // On error 0 is returned and the error is or'ed into `out_error` if it is not null, so one variable collects the
+    // errors of a sequence of reads. The C typed readers assign `*out_error` instead, on success too.
+    template <Scalar T>
+    T read(LB_ReaderError *out_error = nullptr) noexcept {
+        T value;
+        if (const LB_ReaderError e = read(&value, sizeof(T))) [[unlikely]] {
+            if (out_error) {
+                *out_error |= e;
+            }
+            return T{};
+        }
+
+        return toEndian<endian>(value);
+    }
+
+    // Bulk read; elements are swapped on the way in if the byte order differs from the host's.
+    template <Scalar T, size_t N>
+    LB_ReaderError read(const std::span<T, N> out_values) noexcept {
+        if (const LB_ReaderError e = read(out_values.data(), out_values.size_bytes())) {
+            return e;
+        }
+
+        if constexpr (endian != std::endian::native && sizeof(T) > 1) {
+            for (T &value : out_values) {
+                value = byteswap(value);
+            }
+        }
+        return LB_READER_ERROR_NONE;
+    }
+
+    LB_ReaderError seek(const size_t position) noexcept {
+        if constexpr (backend == Backend::File) {
+            if (LB_FILE_SEEK(file_, position, SEEK_SET) != 0) {
+                return LB_READER_ERROR_END;
+            }
+
+            position_ = position;
+            return LB_READER_ERROR_NONE;
+        } else {
+            if constexpr (safety == Safety::Checked) {
+                if (position > length_) {
+                    return LB_READER_ERROR_END;
+                }
+            }
+
+            position_ = position;
+            return LB_READER_ERROR_NONE;
+        }
+    }
+
+    [[nodiscard]] size_t position() const noexcept {
+        return position_;
+    }
+
+    // For files, the length when the reader was constructed, SIZE_MAX for streams without one.
+    [[nodiscard]] size_t length() const noexcept {
+        return length_;
+    }
+
+    [[nodiscard]] size_t remaining() const noexcept {
+        if constexpr (backend == Backend::File) {
+            if (length_ == SIZE_MAX) {
+                return SIZE_MAX;
+            }
+            return position_ < length_ ? length_ - position_ : 0;
+        } else {
+            return length_ - position_;
+        }
+    }
+
+    // Skip `length` bytes as if they had been read; LB_READER_ERROR_END, without moving, if fewer remain.
+    LB_ReaderError skip(const size_t length) noexcept {
+        if constexpr (backend == Backend::File) {
+            if (length > remaining()) {
+                return LB_READER_ERROR_END;
+            }
+            if (LB_FILE_SEEK(file_, length, SEEK_CUR) != 0) {
+                return LB_READER_ERROR_END;
+            }
+
+            position_ += length;
+            return LB_READER_ERROR_NONE;
+        } else {
+            if constexpr (safety == Safety::Checked) {
+                if (length > length_ - position_) {
+                    return LB_READER_ERROR_END;
+                }
+            }
+
+            position_ += length;
+            return LB_READER_ERROR_NONE;
+        }
+    }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t length_ = 0;
+    size_t position_ = 0;
+    FILE *file_ = nullptr;
+};
+
+} // namespace lb
+
+#endif //LB_BUFFER_HPP
@@ -0,0 +1,246 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_COPY_H
+#define LB_COPY_H
+
+/*
+ * Copying from a LB_Reader to a LB_Writer without a round trip through a temporary buffer.
+ *
+ * Between two files on Linux the kernel moves the bytes itself: copy_file_range when both are seekable (which can
+ * share extents on filesystems that support it), otherwise sendfile, which also accepts a pipe or socket as the
+ * destination. Memory backed readers are written straight from their memory, and file readers read straight into a
+ * buffer writer's memory. Everything else, and whatever the kernel refuses, falls back to copying in 64 KiB blocks.
+ *
+ * Define LB_COPY_IMPLEMENTATION (implied by LB_BUFFER_IMPLEMENTATION) in exactly one translation unit.
+ */
+
+#include "lb_writer.h"
+#include "lb_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Copy the next `length` bytes of `reader` to `writer`, advancing both. <br>
+ * Both FILE streams may be used normally afterwards, the kernel path keeps their positions in sync.
+ *
+ * @return LB_WRITER_ERROR_FULL if the writer cannot take `length` more bytes, a write fails or the copy block cannot be
+ *         allocated,
+ *         LB_WRITER_ERROR_INVALID_VALUE if the reader ends first. Bytes already copied stay copied.
+ */
+LB_WriterError lbWriterCopyFrom(LB_Writer *writer, LB_Reader *reader, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_COPY_H
+
+#if defined(LB_COPY_IMPLEMENTATION) && !defined(LB_COPY_IMPLEMENTED)
+#define LB_COPY_IMPLEMENTED
+
+// copy_file_range and sendfile need the Linux and glibc extensions to be visible.
+#if defined(__linux__) && (defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE))
+#define LB_COPY_KERNEL
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LB_COPY_BLOCK 65536
+
+#ifdef LB_COPY_KERNEL
+// Let the kernel copy up to `length` bytes between two files, returning how many it did. 0 means not at all.
+static size_t lbCopyKernel(FILE *out, FILE *in, const size_t length) {
+    // The reader's stdio buffer is ahead of its logical position and the writer's holds unwritten bytes, so work from
+    // the logical positions with the writer flushed, and seek both streams afterwards.
+    const LB_FileOffset in_position = LB_FILE_TELL(in);
+    if (in_position < 0 || fflush(out) != 0) {
+        return 0;
+    }
+
+    const LB_FileOffset out_position = LB_FILE_TELL(out);
+    const int in_fd = fileno(in);
+    const int out_fd = fileno(out);
+    int64_t in_offset = in_position;
+    int64_t out_offset = out_position;
+    size_t copied = 0;
+
+#ifdef SYS_copy_file_range
+    while (out_position >= 0 && copied < length) {
+        const long result = syscall(SYS_copy_file_range, in_fd, &in_offset, out_fd, &out_offset, length - copied, 0);
+        if (result <= 0) {
+            break;
+        }
+        copied += (size_t) result;
+    }
+#endif
+
+    // Unseekable destinations, and filesystems copy_file_range refuses. sendfile writes at the descriptor's offset,
+    // which after the flush is the writer's position, unless copy_file_range got partway.
+    if (copied > 0 && copied < length && lseek(out_fd, (off_t) out_offset, SEEK_SET) < 0) {
+        return copied;
+    }
+
+    off_t sendfile_offset = (off_t) in_offset;
+    while (copied < length) {
+        const ssize_t result = sendfile(out_fd, in_fd, &sendfile_offset, length - copied);
+        if (result <= 0) {
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        copied += (size_t) result;
+    }
+
+    if (copied > 0) {
+        LB_FILE_SEEK(in, in_position + (LB_FileOffset) copied, SEEK_SET);
+        if (out_position >= 0) {
+            LB_FILE_SEEK(out, out_position + (LB_FileOffset) copied, SEEK_SET);
+        }
+    }
+
+    return copied;
+}
+#endif
+
+// Paths that bypass lbRead or lbWrite make the same stats, profile and probe hooks themselves.
+LB_WriterError lbWriterCopyFrom(LB_Writer *writer, LB_Reader *reader, size_t length) {
+    // Memory backed readers: write straight from their memory.
+    if (reader->_.mode == LB_READER_MODE_BUFFER) {
+        LB_ReaderBuffer *buffer = &reader->_.buffer;
+        LB_STATS_ADD(read_calls, 1);
+        LB_PROFILE_RECORD(LB_PROFILE_OP_READ, length);
+        LB_STATS_ADD(read_bytes, length);
+        if (length > buffer->length - buffer->position) {
+            LB_STATS_ERRORS(read_errors, LB_READER_ERROR_END);
+            LB_PROBE2(read_error, LB_READER_ERROR_END, length);
+            return LB_WRITER_ERROR_INVALID_VALUE;
+        }
+
+        const LB_WriterError e = lbWrite(writer, (const uint8_t *) buffer->data + buffer->position, length);
+        if (e == LB_WRITER_ERROR_NONE) {
+            buffer->position += length;
+        }
+        return e;
+    }
+
+    if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        LB_ReaderSegments *segments = &reader->_.segments;
+        LB_STATS_ADD(read_calls, 1);
+        LB_PROFILE_RECORD(LB_PROFILE_OP_READ, length);
+        LB_STATS_ADD(read_bytes, length);
+        if (length > segments->length - segments->position) {
+            LB_STATS_ERRORS(read_errors, LB_READER_ERROR_END);
+            LB_PROBE2(read_error, LB_READER_ERROR_END, length);
+            return LB_WRITER_ERROR_INVALID_VALUE;
+        }
+
+        while (length > 0) {
+            const LB_ReaderSegment *segment = &segments->segments[segments->index];
+            const size_t available = segment->length - segments->offset;
+            if (available == 0) {
+                segments->index++;
+                segments->offset = 0;
+                continue;
+            }
+
+            const size_t count = length < available ? length : available;
+            const LB_WriterError e = lbWrite(writer, (const uint8_t *) segment->data + segments->offset, count);
+            if (e) {
+                return e;
+            }
+
+            lbReaderSkip(reader, count);
+            length -= count;
+        }
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    // File readers into a buffer writer: read straight into its memory. The read is counted by lbRead, the write here.
+    if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+        LB_WriterBuffer *buffer = &writer->_.buffer;
+        LB_STATS_ADD(write_calls, 1);
+        LB_PROFILE_RECORD(LB_PROFILE_OP_WRITE, length);
+        LB_STATS_ADD(write_bytes, length);
+        if (length > buffer->length - buffer->position) {
+            const LB_WriterError e = lbWriterGrow(writer, buffer->position + length);
+            if (e) {
+                LB_STATS_ERRORS(write_errors, e);
+                LB_PROBE2(write_error, e, length);
+                return e;
+            }
+        }
+
+        if (lbRead(reader, (uint8_t *) buffer->data + buffer->position, length)) {
+            return LB_WRITER_ERROR_INVALID_VALUE;
+        }
+        buffer->position += length;
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    // File to file.
+    if (length > lbReaderRemaining(reader)) {
+        LB_STATS_ERRORS(read_errors, LB_READER_ERROR_END);
+        LB_PROBE2(read_error, LB_READER_ERROR_END, length);
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+#ifdef LB_COPY_KERNEL
+    // Counted as one read and one write of everything the kernel copied, the rest goes through lbRead and lbWrite.
+    const size_t copied = lbCopyKernel(writer->_.file, reader->_.file.handle, length);
+    if (copied > 0) {
+        LB_STATS_ADD(read_calls, 1);
+        LB_PROFILE_RECORD(LB_PROFILE_OP_READ, copied);
+        LB_STATS_ADD(read_bytes, copied);
+        LB_PROBE2(file_read, copied, 1);
+        LB_STATS_ADD(write_calls, 1);
+        LB_PROFILE_RECORD(LB_PROFILE_OP_WRITE, copied);
+        LB_STATS_ADD(write_bytes, copied);
+        LB_PROBE2(file_write, copied, 1);
+        reader->_.file.position += copied;
+        length -= copied;
+    }
+#endif
+
+    if (length == 0) {
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    // On the heap, the caller's stack may be small.
+    const size_t block_length = length < LB_COPY_BLOCK ? length : LB_COPY_BLOCK;
+    uint8_t *block = (uint8_t *) malloc(block_length);
+    if (block == NULL) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    LB_WriterError e = LB_WRITER_ERROR_NONE;
+    while (length > 0) {
+        const size_t count = length < block_length ? length : block_length;
+        if (lbRead(reader, block, count)) {
+            e = LB_WRITER_ERROR_INVALID_VALUE;
+            break;
+        }
+
+        e = lbWrite(writer, block, count);
+        if (e) {
+            break;
+        }
+        length -= count;
+    }
+
+    free(block);
+    return e;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_COPY_IMPLEMENTATION
@@ -0,0 +1,674 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_CPU_H
+#define LB_CPU_H
+
+/*
+ * Runtime CPU feature detection and kernel dispatch.
+ *
+ * Features are detected once, on first use, through cpuid (x86) or the auxiliary vector (AArch64 Linux). The best
+ * supported tier selects a table of kernels, compiled with per-function target attributes so the library never needs
+ * -march flags. Set the environment variable LB_BUFFER_CPU to scalar, sse42, avx2, avx512 or neon to cap the tier,
+ * for example to test every code path on one machine.
+ *
+ * Define LB_CPU_IMPLEMENTATION (implied by LB_BUFFER_IMPLEMENTATION) in exactly one translation unit.
+ */
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+typedef enum LB_CpuFeature {
+    LB_CPU_FEATURE_SSE2 = 0x1,
+    LB_CPU_FEATURE_SSSE3 = 0x2,
+    LB_CPU_FEATURE_SSE41 = 0x4,
+    LB_CPU_FEATURE_SSE42 = 0x8,
+    LB_CPU_FEATURE_POPCNT = 0x10,
+    // Only reported when the OS saves the YMM state.
+    LB_CPU_FEATURE_AVX = 0x20,
+    LB_CPU_FEATURE_AVX2 = 0x40,
+    LB_CPU_FEATURE_FMA = 0x80,
+    LB_CPU_FEATURE_F16C = 0x100,
+    LB_CPU_FEATURE_BMI1 = 0x200,
+    LB_CPU_FEATURE_BMI2 = 0x400,
+    // Only reported when the OS saves the ZMM state.
+    LB_CPU_FEATURE_AVX512F = 0x800,
+    LB_CPU_FEATURE_AVX512BW = 0x1000,
+    LB_CPU_FEATURE_AVX512VL = 0x2000,
+    LB_CPU_FEATURE_NEON = 0x4000,
+    LB_CPU_FEATURE_ARM_CRC32 = 0x8000,
+} LB_CpuFeature;
+
+// Kernel tiers, each requiring a set of features. Dispatch picks the highest supported tier.
+typedef enum LB_CpuTier {
+    LB_CPU_TIER_SCALAR,
+    // SSSE3, SSE4.1, SSE4.2 and POPCNT.
+    LB_CPU_TIER_SSE42,
+    // AVX, AVX2, FMA, F16C, BMI1 and BMI2, the x86-64-v3 level.
+    LB_CPU_TIER_AVX2,
+    // AVX512F, AVX512BW and AVX512VL on top of the AVX2 tier.
+    LB_CPU_TIER_AVX512,
+    LB_CPU_TIER_NEON,
+    LB_CPU_TIER_COUNT,
+} LB_CpuTier;
+
+// The dispatched kernels. Every tier provides every entry, falling back to the scalar version where it has nothing
+// better.
+typedef struct LB_CpuKernels {
+    LB_CpuTier tier;
+    // codes[i] = clamp((values[i] - min) * scale + 0.5, 0, max_code), computed in double.
+    void (*quantize_f32)(const float *values, uint32_t *out_codes, size_t count, double min, double scale,
+                         uint32_t max_code);
+    // values[i] = (float) (min + codes[i] * step), computed in double.
+    void (*dequantize_f32)(const uint32_t *codes, float *out_values, size_t count, double min, double step);
+    // Copy the 4 or 8 byte values at base, base + stride, base + 2 * stride... contiguously into `out`, byte-swapping
+    // each when `swap` is set. Neither side needs to be aligned.
+    void (*gather_32)(const void *base, size_t stride, void *out, size_t count, int swap);
+    void (*gather_64)(const void *base, size_t stride, void *out, size_t count, int swap);
+    // The reverse: copy contiguous `values` to base, base + stride, base + 2 * stride...
+    void (*scatter_32)(const void *values, void *base, size_t stride, size_t count, int swap);
+    void (*scatter_64)(const void *values, void *base, size_t stride, size_t count, int swap);
+} LB_CpuKernels;
+
+// The LB_CpuFeature bits supported by this CPU and OS.
+uint32_t lbCpuFeatures(void);
+
+// The highest tier this CPU supports, ignoring LB_BUFFER_CPU.
+LB_CpuTier lbCpuDetectedTier(void);
+
+// The tier in use.
+LB_CpuTier lbCpuTier(void);
+
+// The kernels of the tier in use.
+const LB_CpuKernels *lbCpuKernels(void);
+
+/**
+ * Switch to the highest supported tier not above `tier`. <br>
+ * Intended for tests and benchmarks; kernels already loaded by other threads keep running on the previous table.
+ *
+ * @return The tier now in use.
+ */
+LB_CpuTier lbCpuSetTier(LB_CpuTier tier);
+
+const char *lbCpuTierName(LB_CpuTier tier);
+const char *lbCpuFeatureName(LB_CpuFeature feature);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_CPU_H
+
+#if defined(LB_CPU_IMPLEMENTATION) && !defined(LB_CPU_IMPLEMENTED)
+#define LB_CPU_IMPLEMENTED
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LB_CPU_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define LB_CPU_TARGET(features)
+#else
+#include <cpuid.h>
+#define LB_CPU_TARGET(features) __attribute__((target(features)))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LB_CPU_ARM64
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void lbCpuQuantizeF32Scalar(const float *values, uint32_t *out_codes, const size_t count, const double min,
+                                   const double scale, const uint32_t max_code) {
+    const double max = (double) max_code;
+    for (size_t i = 0; i < count; i++) {
+        double scaled = ((double) values[i] - min) * scale + 0.5;
+        scaled = scaled > 0.0 ? scaled : 0.0;
+        scaled = scaled < max ? scaled : max;
+        out_codes[i] = (uint32_t) scaled;
+    }
+}
+
+static void lbCpuDequantizeF32Scalar(const uint32_t *codes, float *out_values, const size_t count, const double min,
+                                     const double step) {
+    for (size_t i = 0; i < count; i++) {
+        out_values[i] = (float) (min + (double) codes[i] * step);
+    }
+}
+
+// Compilers turn these into a single bswap or rev.
+static uint32_t lbCpuSwap32(const uint32_t value) {
+    return (value >> 24) | ((value >> 8) & 0xFF00u) | ((value << 8) & 0xFF0000u) | (value << 24);
+}
+
+static uint64_t lbCpuSwap64(const uint64_t value) {
+    return ((uint64_t) lbCpuSwap32((uint32_t) value) << 32) | lbCpuSwap32((uint32_t) (value >> 32));
+}
+
+static void lbCpuGather32Scalar(const void *base, const size_t stride, void *out, const size_t count, const int swap) {
+    const uint8_t *in = (const uint8_t *) base;
+    uint8_t *bytes = (uint8_t *) out;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t value;
+        memcpy(&value, in + i * stride, sizeof(value));
+        value = swap ? lbCpuSwap32(value) : value;
+        memcpy(bytes + i * sizeof(value), &value, sizeof(value));
+    }
+}
+
+static void lbCpuGather64Scalar(const void *base, const size_t stride, void *out, const size_t count, const int swap) {
+    const uint8_t *in = (const uint8_t *) base;
+    uint8_t *bytes = (uint8_t *) out;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t value;
+        memcpy(&value, in + i * stride, sizeof(value));
+        value = swap ? lbCpuSwap64(value) : value;
+        memcpy(bytes + i * sizeof(value), &value, sizeof(value));
+    }
+}
+
+static void lbCpuScatter32Scalar(const void *values, void *base, const size_t stride, const size_t count,
+                                 const int swap) {
+    const uint8_t *bytes = (const uint8_t *) values;
+    uint8_t *out = (uint8_t *) base;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t value;
+        memcpy(&value, bytes + i * sizeof(value), sizeof(value));
+        value = swap ? lbCpuSwap32(value) : value;
+        memcpy(out + i * stride, &value, sizeof(value));
+    }
+}
+
+static void lbCpuScatter64Scalar(const void *values, void *base, const size_t stride, const size_t count,
+                                 const int swap) {
+    const uint8_t *bytes = (const uint8_t *) values;
+    uint8_t *out = (uint8_t *) base;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t value;
+        memcpy(&value, bytes + i * sizeof(value), sizeof(value));
+        value = swap ? lbCpuSwap64(value) : value;
+        memcpy(out + i * stride, &value, sizeof(value));
+    }
+}
+
+#ifdef LB_CPU_X86
+// The vector kernels use the same operations in the same order as the scalar ones, so results are bit identical.
+
+LB_CPU_TARGET("avx2")
+static void lbCpuQuantizeF32Avx2(const float *values, uint32_t *out_codes, const size_t count, const double min,
+                                 const double scale, const uint32_t max_code) {
+    // _mm256_cvttpd_epi32 is signed, codes at or above 2^31 need the scalar path.
+    if (max_code > INT32_MAX) {
+        lbCpuQuantizeF32Scalar(values, out_codes, count, min, scale, max_code);
+        return;
+    }
+
+    const __m256d min_v = _mm256_set1_pd(min);
+    const __m256d scale_v = _mm256_set1_pd(scale);
+    const __m256d half_v = _mm256_set1_pd(0.5);
+    const __m256d zero_v = _mm256_setzero_pd();
+    const __m256d max_v = _mm256_set1_pd((double) max_code);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d scaled = _mm256_cvtps_pd(_mm_loadu_ps(values + i));
+        scaled = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(scaled, min_v), scale_v), half_v);
+        // max_pd returns the second operand for NaN, matching the scalar `scaled > 0.0 ? scaled : 0.0`.
+        scaled = _mm256_min_pd(_mm256_max_pd(scaled, zero_v), max_v);
+        _mm_storeu_si128((__m128i *) (out_codes + i), _mm256_cvttpd_epi32(scaled));
+    }
+
+    lbCpuQuantizeF32Scalar(values + i, out_codes + i, count - i, min, scale, max_code);
+}
+
+LB_CPU_TARGET("avx2")
+static void lbCpuDequantizeF32Avx2(const uint32_t *codes, float *out_values, const size_t count, const double min,
+                                   const double step) {
+    const __m256d min_v = _mm256_set1_pd(min);
+    const __m256d step_v = _mm256_set1_pd(step);
+    // Unsigned to double: convert `code - 2^31` as signed, then add 2^31 back. Both steps are exact.
+    const __m128i bias_i = _mm_set1_epi32(INT32_MIN);
+    const __m256d bias_d = _mm256_set1_pd(2147483648.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i code = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (codes + i)), bias_i);
+        const __m256d value = _mm256_add_pd(_mm256_cvtepi32_pd(code), bias_d);
+        _mm_storeu_ps(out_values + i, _mm256_cvtpd_ps(_mm256_add_pd(min_v, _mm256_mul_pd(value, step_v))));
+    }
+
+    lbCpuDequantizeF32Scalar(codes + i, out_values + i, count - i, min, step);
+}
+
+LB_CPU_TARGET("avx512f")
+static void lbCpuQuantizeF32Avx512(const float *values, uint32_t *out_codes, const size_t count, const double min,
+                                   const double scale, const uint32_t max_code) {
+    const __m512d min_v = _mm512_set1_pd(min);
+    const __m512d scale_v = _mm512_set1_pd(scale);
+    const __m512d half_v = _mm512_set1_pd(0.5);
+    const __m512d zero_v = _mm512_setzero_pd();
+    const __m512d max_v = _mm512_set1_pd((double) max_code);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d scaled = _mm512_cvtps_pd(_mm256_loadu_ps(values + i));
+        scaled = _mm512_add_pd(_mm512_mul_pd(_mm512_sub_pd(scaled, min_v), scale_v), half_v);
+        scaled = _mm512_min_pd(_mm512_max_pd(scaled, zero_v), max_v);
+        _mm256_storeu_si256((__m256i *) (out_codes + i), _mm512_cvttpd_epu32(scaled));
+    }
+
+    lbCpuQuantizeF32Scalar(values + i, out_codes + i, count - i, min, scale, max_code);
+}
+
+LB_CPU_TARGET("avx512f")
+static void lbCpuDequantizeF32Avx512(const uint32_t *codes, float *out_values, const size_t count, const double min,
+                                     const double step) {
+    const __m512d min_v = _mm512_set1_pd(min);
+    const __m512d step_v = _mm512_set1_pd(step);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m512d value = _mm512_cvtepu32_pd(_mm256_loadu_si256((const __m256i *) (codes + i)));
+        _mm256_storeu_ps(out_values + i, _mm512_cvtpd_ps(_mm512_add_pd(min_v, _mm512_mul_pd(value, step_v))));
+    }
+
+    lbCpuDequantizeF32Scalar(codes + i, out_values + i, count - i, min, step);
+}
+
+// The gathers address lanes with offsets from one base pointer, so the stride has to fit the offset width.
+
+LB_CPU_TARGET("avx2")
+static void lbCpuGather32Avx2(const void *base, const size_t stride, void *out, const size_t count, const int swap) {
+    if (stride > INT32_MAX / 7) {
+        lbCpuGather32Scalar(base, stride, out, count, swap);
+        return;
+    }
+
+    const int s = (int) stride;
+    const __m256i offsets = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    const __m256i reverse = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                             3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const uint8_t *in = (const uint8_t *) base;
+    uint8_t *bytes = (uint8_t *) out;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = _mm256_i32gather_epi32((const int *) (in + i * stride), offsets, 1);
+        if (swap) {
+            value = _mm256_shuffle_epi8(value, reverse);
+        }
+        _mm256_storeu_si256((__m256i *) (bytes + i * 4), value);
+    }
+
+    lbCpuGather32Scalar(in + i * stride, stride, bytes + i * 4, count - i, swap);
+}
+
+LB_CPU_TARGET("avx2")
+static void lbCpuGather64Avx2(const void *base, const size_t stride, void *out, const size_t count, const int swap) {
+    if (stride > INT64_MAX / 3) {
+        lbCpuGather64Scalar(base, stride, out, count, swap);
+        return;
+    }
+
+    const long long s = (long long) stride;
+    const __m256i offsets = _mm256_setr_epi64x(0, s, 2 * s, 3 * s);
+    const __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                             7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const uint8_t *in = (const uint8_t *) base;
+    uint8_t *bytes = (uint8_t *) out;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i value = _mm256_i64gather_epi64((const long long *) (in + i * stride), offsets, 1);
+        if (swap) {
+            value = _mm256_shuffle_epi8(value, reverse);
+        }
+        _mm256_storeu_si256((__m256i *) (bytes + i * 8), value);
+    }
+
+    lbCpuGather64Scalar(in + i * stride, stride, bytes + i * 8, count - i, swap);
+}
+
+LB_CPU_TARGET("avx512f,avx512bw")
+static void lbCpuGather32Avx512(const void *base, const size_t stride, void *out, const size_t count, const int swap) {
+    if (stride > INT32_MAX / 15) {
+        lbCpuGather32Avx2(base, stride, out, count, swap);
+        return;
+    }
+
+    const int s = (int) stride;
+    const __m512i offsets = _mm512_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s, 8 * s, 9 * s, 10 * s,
+                                              11 * s, 12 * s, 13 * s, 14 * s, 15 * s);
+    const __m512i reverse = _mm512_broadcast_i32x4(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    const uint8_t *in = (const uint8_t *) base;
+    uint8_t *bytes = (uint8_t *) out;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i value = _mm512_i32gather_epi32(offsets, in + i * stride, 1);
+        if (swap) {
+            value = _mm512_shuffle_epi8(value, reverse);
+        }
+        _mm512_storeu_si512(bytes + i * 4, value);
+    }
+
+    lbCpuGather32Avx2(in + i * stride, stride, bytes + i * 4, count - i, swap);
+}
+
+LB_CPU_TARGET("avx512f,avx512bw")
+static void lbCpuGather64Avx512(const void *base, const size_t stride, void *out, const size_t count, const int swap) {
+    if (stride > INT64_MAX / 7) {
+        lbCpuGather64Scalar(base, stride, out, count, swap);
+        return;
+    }
+
+    const long long s = (long long) stride;
+    const __m512i offsets = _mm512_setr_epi64(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    const __m512i reverse = _mm512_broadcast_i32x4(_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+    const uint8_t *in = (const uint8_t *) base;
+    uint8_t *bytes = (uint8_t *) out;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i value = _mm512_i64gather_epi64(offsets, in + i * stride, 1);
+        if (swap) {
+            value = _mm512_shuffle_epi8(value, reverse);
+        }
+        _mm512_storeu_si512(bytes + i * 8, value);
+    }
+
+    lbCpuGather64Scalar(in + i * stride, stride, bytes + i * 8, count - i, swap);
+}
+
+// Scatters store lanes in order, so overlapping strides end with the same bytes as the scalar loop.
+
+LB_CPU_TARGET("avx512f,avx512bw")
+static void lbCpuScatter32Avx512(const void *values, void *base, const size_t stride, const size_t count,
+                                 const int swap) {
+    if (stride > INT32_MAX / 15) {
+        lbCpuScatter32Scalar(values, base, stride, count, swap);
+        return;
+    }
+
+    const int s = (int) stride;
+    const __m512i offsets = _mm512_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s, 8 * s, 9 * s, 10 * s,
+                                              11 * s, 12 * s, 13 * s, 14 * s, 15 * s);
+    const __m512i reverse = _mm512_broadcast_i32x4(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    const uint8_t *bytes = (const uint8_t *) values;
+    uint8_t *out = (uint8_t *) base;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i value = _mm512_loadu_si512(bytes + i * 4);
+        if (swap) {
+            value = _mm512_shuffle_epi8(value, reverse);
+        }
+        _mm512_i32scatter_epi32(out + i * stride, offsets, value, 1);
+    }
+
+    lbCpuScatter32Scalar(bytes + i * 4, out + i * stride, stride, count - i, swap);
+}
+
+LB_CPU_TARGET("avx512f,avx512bw")
+static void lbCpuScatter64Avx512(const void *values, void *base, const size_t stride, const size_t count,
+                                 const int swap) {
+    if (stride > INT64_MAX / 7) {
+        lbCpuScatter64Scalar(values, base, stride, count, swap);
+        return;
+    }
+
+    const long long s = (long long) stride;
+    const __m512i offsets = _mm512_setr_epi64(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    const __m512i reverse = _mm512_broadcast_i32x4(_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+    const uint8_t *bytes = (const uint8_t *) values;
+    uint8_t *out = (uint8_t *) base;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i value = _mm512_loadu_si512(bytes + i * 8);
+        if (swap) {
+            value = _mm512_shuffle_epi8(value, reverse);
+        }
+        _mm512_i64scatter_epi64(out + i * stride, offsets, value, 1);
+    }
+
+    lbCpuScatter64Scalar(bytes + i * 8, out + i * stride, stride, count - i, swap);
+}
+#endif
+
+static const LB_CpuKernels lb_cpu_kernels[LB_CPU_TIER_COUNT] = {
+    {LB_CPU_TIER_SCALAR, lbCpuQuantizeF32Scalar, lbCpuDequantizeF32Scalar, lbCpuGather32Scalar, lbCpuGather64Scalar,
+     lbCpuScatter32Scalar, lbCpuScatter64Scalar},
+    // The conversions need 4 doubles per vector to stay exact, and without gathers the strided copies are loads and
+    // stores of single values either way, so SSE4.2 has nothing over scalar code yet.
+    {LB_CPU_TIER_SSE42, lbCpuQuantizeF32Scalar, lbCpuDequantizeF32Scalar, lbCpuGather32Scalar, lbCpuGather64Scalar,
+     lbCpuScatter32Scalar, lbCpuScatter64Scalar},
+#ifdef LB_CPU_X86
+    // AVX2 has gathers but no scatters.
+    {LB_CPU_TIER_AVX2, lbCpuQuantizeF32Avx2, lbCpuDequantizeF32Avx2, lbCpuGather32Avx2, lbCpuGather64Avx2,
+     lbCpuScatter32Scalar, lbCpuScatter64Scalar},
+    {LB_CPU_TIER_AVX512, lbCpuQuantizeF32Avx512, lbCpuDequantizeF32Avx512, lbCpuGather32Avx512, lbCpuGather64Avx512,
+     lbCpuScatter32Avx512, lbCpuScatter64Avx512},
+#else
+    {LB_CPU_TIER_AVX2, lbCpuQuantizeF32Scalar, lbCpuDequantizeF32Scalar, lbCpuGather32Scalar, lbCpuGather64Scalar,
+     lbCpuScatter32Scalar, lbCpuScatter64Scalar},
+    {LB_CPU_TIER_AVX512, lbCpuQuantizeF32Scalar, lbCpuDequantizeF32Scalar, lbCpuGather32Scalar, lbCpuGather64Scalar,
+     lbCpuScatter32Scalar, lbCpuScatter64Scalar},
+#endif
+    {LB_CPU_TIER_NEON, lbCpuQuantizeF32Scalar, lbCpuDequantizeF32Scalar, lbCpuGather32Scalar, lbCpuGather64Scalar,
+     lbCpuScatter32Scalar, lbCpuScatter64Scalar},
+};
+
+static const uint32_t lb_cpu_tier_features[LB_CPU_TIER_COUNT] = {
+    0,
+    LB_CPU_FEATURE_SSE2 | LB_CPU_FEATURE_SSSE3 | LB_CPU_FEATURE_SSE41 | LB_CPU_FEATURE_SSE42 | LB_CPU_FEATURE_POPCNT,
+    LB_CPU_FEATURE_SSE2 | LB_CPU_FEATURE_SSSE3 | LB_CPU_FEATURE_SSE41 | LB_CPU_FEATURE_SSE42 | LB_CPU_FEATURE_POPCNT |
+        LB_CPU_FEATURE_AVX | LB_CPU_FEATURE_AVX2 | LB_CPU_FEATURE_FMA | LB_CPU_FEATURE_F16C | LB_CPU_FEATURE_BMI1 |
+        LB_CPU_FEATURE_BMI2,
+    LB_CPU_FEATURE_SSE2 | LB_CPU_FEATURE_SSSE3 | LB_CPU_FEATURE_SSE41 | LB_CPU_FEATURE_SSE42 | LB_CPU_FEATURE_POPCNT |
+        LB_CPU_FEATURE_AVX | LB_CPU_FEATURE_AVX2 | LB_CPU_FEATURE_FMA | LB_CPU_FEATURE_F16C | LB_CPU_FEATURE_BMI1 |
+        LB_CPU_FEATURE_BMI2 | LB_CPU_FEATURE_AVX512F | LB_CPU_FEATURE_AVX512BW | LB_CPU_FEATURE_AVX512VL,
+    LB_CPU_FEATURE_NEON,
+};
+
+static const char *const lb_cpu_tier_names[LB_CPU_TIER_COUNT] = {"scalar", "sse42", "avx2", "avx512", "neon"};
+
+// Bit 31 marks the features as detected, so a CPU without any feature is not detected again on every call.
+#define LB_CPU_DETECTED 0x80000000u
+static uint32_t lb_cpu_features = 0;
+static const LB_CpuKernels *lb_cpu_active = NULL;
+
+#ifdef LB_CPU_X86
+static void lbCpuId(const uint32_t leaf, const uint32_t subleaf, uint32_t out_registers[4]) {
+#ifdef _MSC_VER
+    int registers[4];
+    __cpuidex(registers, (int) leaf, (int) subleaf);
+    memcpy(out_registers, registers, sizeof(registers));
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &out_registers[0], &out_registers[1], &out_registers[2], &out_registers[3])) {
+        memset(out_registers, 0, 4 * sizeof(uint32_t));
+    }
+#endif
+}
+
+static uint64_t lbCpuXcr0(void) {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t eax;
+    uint32_t edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t) edx << 32) | eax;
+#endif
+}
+#endif
+
+static uint32_t lbCpuDetect(void) {
+    uint32_t features = 0;
+#ifdef LB_CPU_X86
+    uint32_t r[4];
+    lbCpuId(0, 0, r);
+    const uint32_t max_leaf = r[0];
+
+    lbCpuId(1, 0, r);
+    const uint32_t ecx1 = r[2];
+    const uint32_t edx1 = r[3];
+    features |= edx1 & (1u << 26) ? LB_CPU_FEATURE_SSE2 : 0;
+    features |= ecx1 & (1u << 9) ? LB_CPU_FEATURE_SSSE3 : 0;
+    features |= ecx1 & (1u << 19) ? LB_CPU_FEATURE_SSE41 : 0;
+    features |= ecx1 & (1u << 20) ? LB_CPU_FEATURE_SSE42 : 0;
+    features |= ecx1 & (1u << 23) ? LB_CPU_FEATURE_POPCNT : 0;
+
+    // The YMM and ZMM registers are only usable if the OS saves them on context switches.
+    const int os_xsave = (ecx1 & (1u << 27)) != 0;
+    const uint64_t xcr0 = os_xsave ? lbCpuXcr0() : 0;
+    const int os_ymm = (xcr0 & 0x6) == 0x6;
+    const int os_zmm = (xcr0 & 0xE6) == 0xE6;
+    if (os_ymm) {
+        features |= ecx1 & (1u << 28) ? LB_CPU_FEATURE_AVX : 0;
+        features |= ecx1 & (1u << 12) ? LB_CPU_FEATURE_FMA : 0;
+        features |= ecx1 & (1u << 29) ? LB_CPU_FEATURE_F16C : 0;
+    }
+
+    if (max_leaf >= 7) {
+        lbCpuId(7, 0, r);
+        const uint32_t ebx7 = r[1];
+        features |= ebx7 & (1u << 3) ? LB_CPU_FEATURE_BMI1 : 0;
+        features |= ebx7 & (1u << 8) ? LB_CPU_FEATURE_BMI2 : 0;
+        if (os_ymm) {
+            features |= ebx7 & (1u << 5) ? LB_CPU_FEATURE_AVX2 : 0;
+        }
+        if (os_zmm) {
+            features |= ebx7 & (1u << 16) ? LB_CPU_FEATURE_AVX512F : 0;
+            features |= ebx7 & (1u << 30) ? LB_CPU_FEATURE_AVX512BW : 0;
+            features |= ebx7 & (1u << 31) ? LB_CPU_FEATURE_AVX512VL : 0;
+        }
+    }
+#elif defined(LB_CPU_ARM64)
+    // Advanced SIMD is mandatory on AArch64.
+    features |= LB_CPU_FEATURE_NEON;
+#if defined(__linux__) && defined(HWCAP_CRC32)
+    features |= getauxval(AT_HWCAP) & HWCAP_CRC32 ? LB_CPU_FEATURE_ARM_CRC32 : 0;
+#elif defined(__ARM_FEATURE_CRC32)
+    features |= LB_CPU_FEATURE_ARM_CRC32;
+#endif
+#endif
+    return features;
+}
+
+static LB_CpuTier lbCpuBestTier(const uint32_t features, const LB_CpuTier limit) {
+    for (int tier = limit; tier > LB_CPU_TIER_SCALAR; tier--) {
+        if ((features & lb_cpu_tier_features[tier]) == lb_cpu_tier_features[tier]) {
+            return (LB_CpuTier) tier;
+        }
+    }
+
+    return LB_CPU_TIER_SCALAR;
+}
+
+static LB_CpuTier lbCpuEnvironmentTier(void) {
+    const char *name = getenv("LB_BUFFER_CPU");
+    if (name != NULL) {
+        for (int tier = 0; tier < LB_CPU_TIER_COUNT; tier++) {
+            if (strcmp(name, lb_cpu_tier_names[tier]) == 0) {
+                return (LB_CpuTier) tier;
+            }
+        }
+    }
+
+    return (LB_CpuTier) (LB_CPU_TIER_COUNT - 1);
+}
+
+uint32_t lbCpuFeatures(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    uint32_t features = __atomic_load_n(&lb_cpu_features, __ATOMIC_RELAXED);
+    if (!(features & LB_CPU_DETECTED)) {
+        features = lbCpuDetect() | LB_CPU_DETECTED;
+        __atomic_store_n(&lb_cpu_features, features, __ATOMIC_RELAXED);
+    }
+#else
+    uint32_t features = lb_cpu_features;
+    if (!(features & LB_CPU_DETECTED)) {
+        features = lbCpuDetect() | LB_CPU_DETECTED;
+        lb_cpu_features = features;
+    }
+#endif
+    return features & ~LB_CPU_DETECTED;
+}
+
+LB_CpuTier lbCpuDetectedTier(void) {
+    return lbCpuBestTier(lbCpuFeatures(), (LB_CpuTier) (LB_CPU_TIER_COUNT - 1));
+}
+
+static void lbCpuActivate(const LB_CpuKernels *kernels) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&lb_cpu_active, kernels, __ATOMIC_RELEASE);
+#else
+    lb_cpu_active = kernels;
+#endif
+}
+
+const LB_CpuKernels *lbCpuKernels(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    const LB_CpuKernels *kernels = __atomic_load_n(&lb_cpu_active, __ATOMIC_ACQUIRE);
+#else
+    const LB_CpuKernels *kernels = lb_cpu_active;
+#endif
+    if (kernels == NULL) {
+        // Racing threads compute the same table.
+        kernels = &lb_cpu_kernels[lbCpuBestTier(lbCpuFeatures(), lbCpuEnvironmentTier())];
+        lbCpuActivate(kernels);
+    }
+
+    return kernels;
+}
+
+LB_CpuTier lbCpuTier(void) {
+    return lbCpuKernels()->tier;
+}
+
+LB_CpuTier lbCpuSetTier(const LB_CpuTier tier) {
+    const LB_CpuTier limit = (unsigned) tier < LB_CPU_TIER_COUNT ? tier : (LB_CpuTier) (LB_CPU_TIER_COUNT - 1);
+    const LB_CpuTier selected = lbCpuBestTier(lbCpuFeatures(), limit);
+    lbCpuActivate(&lb_cpu_kernels[selected]);
+    return selected;
+}
+
+const char *lbCpuTierName(const LB_CpuTier tier) {
+    return (unsigned) tier < LB_CPU_TIER_COUNT ? lb_cpu_tier_names[tier] : "unknown";
+}
+
+const char *lbCpuFeatureName(const LB_CpuFeature feature) {
+    switch (feature) {
+        case LB_CPU_FEATURE_SSE2: return "sse2";
+        case LB_CPU_FEATURE_SSSE3: return "ssse3";
+        case LB_CPU_FEATURE_SSE41: return "sse4.1";
+        case LB_CPU_FEATURE_SSE42: return "sse4.2";
+        case LB_CPU_FEATURE_POPCNT: return "popcnt";
+        case LB_CPU_FEATURE_AVX: return "avx";
+        case LB_CPU_FEATURE_AVX2: return "avx2";
+        case LB_CPU_FEATURE_FMA: return "fma";
+        case LB_CPU_FEATURE_F16C: return "f16c";
+        case LB_CPU_FEATURE_BMI1: return "bmi1";
+        case LB_CPU_FEATURE_BMI2: return "bmi2";
+        case LB_CPU_FEATURE_AVX512F: return "avx512f";
+        case LB_CPU_FEATURE_AVX512BW: return "avx512bw";
+        case LB_CPU_FEATURE_AVX512VL: return "avx512vl";
+        case LB_CPU_FEATURE_NEON: return "neon";
+        case LB_CPU_FEATURE_ARM_CRC32: return "crc32";
+        default: return "unknown";
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_CPU_IMPLEMENTATION
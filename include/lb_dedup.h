@@ -0,0 +1,506 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_DEDUP_H
+#define LB_DEDUP_H
+
+#include "lb_writer.h"
+#include "lb_reader.h"
+#include "lb_paged_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Content-defined chunking with deduplication.
+ *
+ * A LB_DedupWriter cuts the bytes it is given into chunks wherever a gear hash over the last
+ * bytes matches a bit pattern, so chunk boundaries move with the content instead of with byte
+ * offsets. Every chunk is looked up in a LB_DedupStore and only stored if it is new. For each
+ * chunk, its id is appended to the manifest as a little endian u32, and the manifest is closed
+ * by LB_DEDUP_MANIFEST_END.
+ */
+#define LB_DEDUP_MANIFEST_END 0xFFFFFFFFu
+
+#define LB_DEDUP_DEFAULT_MIN_SIZE 2048
+#define LB_DEDUP_DEFAULT_AVERAGE_SIZE 8192
+#define LB_DEDUP_DEFAULT_MAX_SIZE 65536
+
+// Error codes for initializing a LB_DedupStore or LB_DedupWriter.
+typedef enum LB_DedupInitError {
+    // No error.
+    LB_DEDUP_INIT_NONE = 0x0,
+    // The store or writer is NULL.
+    LB_DEDUP_INIT_NULL = 0x1,
+    // The average size is not a power of two, or the sizes are not ordered min <= average <= max.
+    LB_DEDUP_INIT_INVALID_SIZES = 0x2,
+    // Memory could not be allocated.
+    LB_DEDUP_INIT_ALLOCATION_FAILED = 0x4,
+} LB_DedupInitError;
+
+#ifdef __cplusplus
+// A bit flag enum, see lb_writer.h.
+extern "C++" {
+inline LB_DedupInitError operator|(const LB_DedupInitError a, const LB_DedupInitError b) {
+    return (LB_DedupInitError) ((int) a | (int) b);
+}
+
+inline LB_DedupInitError &operator|=(LB_DedupInitError &a, const LB_DedupInitError b) {
+    return a = a | b;
+}
+}
+#endif
+
+const char* lbDedupInitErrorName(LB_DedupInitError e);
+const char* lbDedupInitErrorMessage(LB_DedupInitError e);
+
+typedef struct LB_DedupChunk {
+    uint64_t hash;
+    const void *data;
+    size_t length;
+} LB_DedupChunk;
+
+typedef struct LB_DedupStore {
+    // Chunk data, freed all at once with the store.
+    LB_PagedArena *arena;
+    LB_DedupChunk *chunks;
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+    // Open addressing table of chunk ids keyed by chunk hash, UINT32_MAX marks an empty slot.
+    uint32_t *index;
+    uint32_t index_capacity;
+    size_t min_size;
+    size_t max_size;
+    // log2(average_size) bits at the top of the word. Bit k of the gear hash only depends on the last k + 1 bytes, so
+    // the high bits are the ones that see the whole 64 byte window.
+    uint64_t mask;
+    uint64_t gear[256];
+} LB_DedupStore;
+
+typedef struct LB_DedupWriter {
+    LB_DedupStore *store;
+    LB_Writer *manifest;
+    // The chunk that is currently being cut, at most `max_size` bytes.
+    uint8_t *pending;
+    size_t pending_length;
+    uint64_t hash;
+} LB_DedupWriter;
+
+/**
+ * Initialize a LB_DedupStore. All writers that share a store must agree on its chunk sizes.
+ *
+ * @param min_size No boundary is placed before this many bytes.
+ * @param average_size The expected chunk size, must be a power of two.
+ * @param max_size A boundary is forced after this many bytes.
+ */
+LB_DedupInitError lbDedupStoreInit(LB_DedupStore *store, size_t min_size, size_t average_size, size_t max_size);
+void lbDedupStoreFree(LB_DedupStore *store);
+
+// Store a chunk, or find the id of an identical chunk that is already stored. Returns UINT32_MAX on failure.
+uint32_t lbDedupStoreAdd(LB_DedupStore *store, const void *data, size_t length);
+
+/**
+ * Persist the chunks with ids in [first_id, chunk_count) as `u32 length, bytes` records, so that
+ * each call only writes the chunks that were added since the last one.
+ */
+LB_WriterError lbDedupStoreWrite(const LB_DedupStore *store, LB_Writer *writer, uint32_t first_id);
+
+// Append the chunks written by `lbDedupStoreWrite`, ids continue where the store left off.
+LB_ReaderError lbDedupStoreRead(LB_DedupStore *store, LB_Reader *reader);
+
+LB_DedupInitError lbDedupWriterInit(LB_DedupWriter *dedup_writer, LB_DedupStore *store, LB_Writer *manifest);
+void lbDedupWriterFree(LB_DedupWriter *dedup_writer);
+
+// Chunk and store `length` bytes. May be called any number of times per stream.
+LB_WriterError lbDedupWrite(LB_DedupWriter *dedup_writer, const void *data, size_t length);
+
+// Store the last chunk and close the manifest. The writer can be reused for the next stream afterwards.
+LB_WriterError lbDedupWriterFinish(LB_DedupWriter *dedup_writer);
+
+/**
+ * Read a manifest and initialize a segmented LB_Reader over the stored chunks, without copying them.  <br>
+ * `*out_segments` is allocated with malloc and must be freed once `out_reader` is no longer used.
+ */
+LB_ReaderError lbDedupReaderInit(const LB_DedupStore *store, LB_Reader *manifest, LB_Reader *out_reader, LB_ReaderSegment **out_segments);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_DEDUP_H
+
+#ifdef LB_DEDUP_IMPLEMENTATION
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* lbDedupInitErrorName(const LB_DedupInitError e) {
+    switch (e) {
+        case LB_DEDUP_INIT_NONE:
+            return "LB_DEDUP_INIT_NONE";
+        case LB_DEDUP_INIT_NULL:
+            return "LB_DEDUP_INIT_NULL";
+        case LB_DEDUP_INIT_INVALID_SIZES:
+            return "LB_DEDUP_INIT_INVALID_SIZES";
+        case LB_DEDUP_INIT_ALLOCATION_FAILED:
+            return "LB_DEDUP_INIT_ALLOCATION_FAILED";
+        default:
+            return "LB_DEDUP_INIT_UNKNOWN";
+    }
+}
+
+const char* lbDedupInitErrorMessage(const LB_DedupInitError e) {
+    switch (e) {
+        case LB_DEDUP_INIT_NONE:
+            return "No error.";
+        case LB_DEDUP_INIT_NULL:
+            return "The store or writer is NULL.";
+        case LB_DEDUP_INIT_INVALID_SIZES:
+            return "The average size is not a power of two, or the sizes are not ordered min <= average <= max.";
+        case LB_DEDUP_INIT_ALLOCATION_FAILED:
+            return "Memory could not be allocated.";
+        default:
+            return "Unknown error.";
+    }
+}
+
+static uint64_t lbDedupMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t lbDedupHash(const void *data, const size_t length) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    uint64_t hash = lbDedupMix(length ^ 0x9E3779B97F4A7C15ull);
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = lbDedupMix(hash ^ word) + 0x9E3779B97F4A7C15ull;
+    }
+
+    uint64_t tail = 0;
+    for (; i < length; i++) {
+        tail = (tail << 8) | bytes[i];
+    }
+
+    return lbDedupMix(hash ^ tail);
+}
+
+LB_DedupInitError lbDedupStoreInit(LB_DedupStore *store, const size_t min_size, const size_t average_size, const size_t max_size) {
+    LB_DedupInitError e = LB_DEDUP_INIT_NONE;
+    if (store == NULL) {
+        e |= LB_DEDUP_INIT_NULL;
+    }
+
+    if (average_size == 0 || (average_size & (average_size - 1)) != 0 || min_size > average_size || average_size > max_size) {
+        e |= LB_DEDUP_INIT_INVALID_SIZES;
+    }
+
+    if (e) {
+        return e;
+    }
+
+    memset(store, 0, sizeof(*store));
+    store->arena = lbPagedArenaNew(max_size * 16);
+    store->index_capacity = 1024;
+    store->index = (uint32_t *) malloc(store->index_capacity * sizeof(uint32_t));
+    if (store->arena == NULL || store->index == NULL) {
+        lbDedupStoreFree(store);
+        return LB_DEDUP_INIT_ALLOCATION_FAILED;
+    }
+
+    memset(store->index, 0xFF, store->index_capacity * sizeof(uint32_t));
+    store->min_size = min_size;
+    store->max_size = max_size;
+    uint32_t average_bits = 0;
+    while (((size_t) 1 << average_bits) < average_size) {
+        average_bits++;
+    }
+    store->mask = average_bits ? (uint64_t) (average_size - 1) << (64 - average_bits) : 0;
+    for (uint32_t i = 0; i < 256; i++) {
+        store->gear[i] = lbDedupMix(i + 1);
+    }
+
+    return LB_DEDUP_INIT_NONE;
+}
+
+void lbDedupStoreFree(LB_DedupStore *store) {
+    if (store->arena != NULL) {
+        lbPagedArenaFree(store->arena);
+    }
+
+    free(store->chunks);
+    free(store->index);
+    store->arena = NULL;
+    store->chunks = NULL;
+    store->index = NULL;
+}
+
+static int lbDedupStoreGrowIndex(LB_DedupStore *store) {
+    const uint32_t capacity = store->index_capacity * 2;
+    uint32_t *index = (uint32_t *) malloc(capacity * sizeof(uint32_t));
+    if (index == NULL) {
+        return 0;
+    }
+
+    memset(index, 0xFF, capacity * sizeof(uint32_t));
+    for (uint32_t id = 0; id < store->chunk_count; id++) {
+        uint32_t slot = (uint32_t) store->chunks[id].hash & (capacity - 1);
+        while (index[slot] != UINT32_MAX) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        index[slot] = id;
+    }
+
+    free(store->index);
+    store->index = index;
+    store->index_capacity = capacity;
+    return 1;
+}
+
+uint32_t lbDedupStoreAdd(LB_DedupStore *store, const void *data, const size_t length) {
+    const uint64_t hash = lbDedupHash(data, length);
+    const uint32_t mask = store->index_capacity - 1;
+    uint32_t slot = (uint32_t) hash & mask;
+    while (store->index[slot] != UINT32_MAX) {
+        const LB_DedupChunk *chunk = &store->chunks[store->index[slot]];
+        // The hash only narrows the search, chunks are only shared if their bytes match.
+        if (chunk->hash == hash && chunk->length == length && memcmp(chunk->data, data, length) == 0) {
+            return store->index[slot];
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    if (store->chunk_count == UINT32_MAX - 1) {
+        return UINT32_MAX;
+    }
+
+    if (store->chunk_count == store->chunk_capacity) {
+        const uint32_t capacity = store->chunk_capacity ? store->chunk_capacity * 2 : 64;
+        LB_DedupChunk *chunks = (LB_DedupChunk *) realloc(store->chunks, capacity * sizeof(LB_DedupChunk));
+        if (chunks == NULL) {
+            return UINT32_MAX;
+        }
+
+        store->chunks = chunks;
+        store->chunk_capacity = capacity;
+    }
+
+    void *copy = lbPagedArenaAlloc(store->arena, length ? length : 1);
+    if (copy == NULL) {
+        return UINT32_MAX;
+    }
+
+    memcpy(copy, data, length);
+    const uint32_t id = store->chunk_count++;
+    store->chunks[id] = (LB_DedupChunk) { .hash = hash, .data = copy, .length = length };
+    store->index[slot] = id;
+
+    // Keep the load factor at or below one half.
+    if (store->chunk_count * 2 > store->index_capacity && !lbDedupStoreGrowIndex(store)) {
+        return UINT32_MAX;
+    }
+
+    return id;
+}
+
+LB_WriterError lbDedupStoreWrite(const LB_DedupStore *store, LB_Writer *writer, const uint32_t first_id) {
+    for (uint32_t id = first_id; id < store->chunk_count; id++) {
+        const LB_DedupChunk *chunk = &store->chunks[id];
+        LB_WriterError e = lbWriteU32LE(writer, (uint32_t) chunk->length);
+        if (!e && chunk->length > 0) {
+            e = lbWrite(writer, chunk->data, chunk->length);
+        }
+
+        if (e) {
+            return e;
+        }
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
+
+LB_ReaderError lbDedupStoreRead(LB_DedupStore *store, LB_Reader *reader) {
+    uint8_t *scratch = (uint8_t *) malloc(store->max_size);
+    if (scratch == NULL) {
+        return LB_READER_ERROR_DATA_NULL;
+    }
+
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    while (lbReaderRemaining(reader) > 0) {
+        // Streams without a length (lbReaderRemaining is SIZE_MAX) end wherever the data does, look ahead one byte.
+        if (reader->_.mode == LB_READER_MODE_FILE && reader->_.file.length == SIZE_MAX) {
+            const int next = getc(reader->_.file.handle);
+            if (next == EOF || ungetc(next, reader->_.file.handle) == EOF) {
+                break;
+            }
+        }
+
+        const uint32_t length = lbReadU32LE(reader, &e);
+        if (e) {
+            break;
+        }
+
+        if (length > store->max_size) {
+            e = LB_READER_ERROR_INVALID_VALUE;
+            break;
+        }
+
+        if (length > 0 && (e = lbRead(reader, scratch, length))) {
+            break;
+        }
+
+        // The writer's store never holds duplicates, so every chunk must get the next id.
+        const uint32_t expected = store->chunk_count;
+        if (lbDedupStoreAdd(store, scratch, length) != expected) {
+            e = LB_READER_ERROR_INVALID_VALUE;
+            break;
+        }
+    }
+
+    free(scratch);
+    return e;
+}
+
+LB_DedupInitError lbDedupWriterInit(LB_DedupWriter *dedup_writer, LB_DedupStore *store, LB_Writer *manifest) {
+    if (dedup_writer == NULL || store == NULL || manifest == NULL) {
+        return LB_DEDUP_INIT_NULL;
+    }
+
+    uint8_t *pending = (uint8_t *) malloc(store->max_size);
+    if (pending == NULL) {
+        return LB_DEDUP_INIT_ALLOCATION_FAILED;
+    }
+
+    *dedup_writer = (LB_DedupWriter) {
+        .store = store,
+        .manifest = manifest,
+        .pending = pending,
+        .pending_length = 0,
+        .hash = 0,
+    };
+    return LB_DEDUP_INIT_NONE;
+}
+
+void lbDedupWriterFree(LB_DedupWriter *dedup_writer) {
+    free(dedup_writer->pending);
+    dedup_writer->pending = NULL;
+}
+
+static LB_WriterError lbDedupWriterCommit(LB_DedupWriter *dedup_writer) {
+    const uint32_t id = lbDedupStoreAdd(dedup_writer->store, dedup_writer->pending, dedup_writer->pending_length);
+    dedup_writer->pending_length = 0;
+    dedup_writer->hash = 0;
+    if (id == UINT32_MAX) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    return lbWriteU32LE(dedup_writer->manifest, id);
+}
+
+LB_WriterError lbDedupWrite(LB_DedupWriter *dedup_writer, const void *data, size_t length) {
+    const LB_DedupStore *store = dedup_writer->store;
+    const uint8_t *bytes = (const uint8_t *) data;
+    while (length > 0) {
+        const size_t room = store->max_size - dedup_writer->pending_length;
+        const size_t limit = length < room ? length : room;
+        uint64_t hash = dedup_writer->hash;
+        size_t i = 0;
+        int boundary = 0;
+
+        // Bytes before the minimum size can never end a chunk, skip hashing all but the last 64 of them,
+        // which are all that the gear hash depends on.
+        const size_t skip = dedup_writer->pending_length + 64 < store->min_size ? store->min_size - 64 - dedup_writer->pending_length : 0;
+        i = skip < limit ? skip : limit;
+
+        for (; i < limit; i++) {
+            hash = (hash << 1) + store->gear[bytes[i]];
+            if (dedup_writer->pending_length + i + 1 >= store->min_size && (hash & store->mask) == 0) {
+                i++;
+                boundary = 1;
+                break;
+            }
+        }
+
+        memcpy(dedup_writer->pending + dedup_writer->pending_length, bytes, i);
+        dedup_writer->pending_length += i;
+        dedup_writer->hash = hash;
+        bytes += i;
+        length -= i;
+
+        if (boundary || dedup_writer->pending_length == store->max_size) {
+            const LB_WriterError e = lbDedupWriterCommit(dedup_writer);
+            if (e) {
+                return e;
+            }
+        }
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
+
+LB_WriterError lbDedupWriterFinish(LB_DedupWriter *dedup_writer) {
+    if (dedup_writer->pending_length > 0) {
+        const LB_WriterError e = lbDedupWriterCommit(dedup_writer);
+        if (e) {
+            return e;
+        }
+    }
+
+    return lbWriteU32LE(dedup_writer->manifest, LB_DEDUP_MANIFEST_END);
+}
+
+LB_ReaderError lbDedupReaderInit(const LB_DedupStore *store, LB_Reader *manifest, LB_Reader *out_reader, LB_ReaderSegment **out_segments) {
+    size_t count = 0;
+    size_t capacity = 64;
+    LB_ReaderSegment *segments = (LB_ReaderSegment *) malloc(capacity * sizeof(LB_ReaderSegment));
+    if (segments == NULL) {
+        return LB_READER_ERROR_DATA_NULL;
+    }
+
+    for (;;) {
+        LB_ReaderError e = LB_READER_ERROR_NONE;
+        const uint32_t id = lbReadU32LE(manifest, &e);
+        if (!e && id != LB_DEDUP_MANIFEST_END && id >= store->chunk_count) {
+            e = LB_READER_ERROR_INVALID_VALUE;
+        }
+
+        if (e) {
+            free(segments);
+            return e;
+        }
+
+        if (id == LB_DEDUP_MANIFEST_END) {
+            break;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            LB_ReaderSegment *grown = (LB_ReaderSegment *) realloc(segments, capacity * sizeof(LB_ReaderSegment));
+            if (grown == NULL) {
+                free(segments);
+                return LB_READER_ERROR_DATA_NULL;
+            }
+
+            segments = grown;
+        }
+
+        segments[count++] = (LB_ReaderSegment) { .data = store->chunks[id].data, .length = store->chunks[id].length };
+    }
+
+    lbReaderInitSegmented(out_reader, segments, count);
+    *out_segments = segments;
+    return LB_READER_ERROR_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_DEDUP_IMPLEMENTATION
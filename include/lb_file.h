@@ -0,0 +1,107 @@
+#ifndef LB_FILE_H
+#define LB_FILE_H
+
+/*
+ * stdio access for the file modes of LB_Writer and LB_Reader: 64-bit offsets, and optionally unlocked calls.
+ *
+ * fseek and ftell take a long, which is 32 bits on Windows and on 32-bit targets, capping files at 2 GB. These map to
+ * _fseeki64 / _ftelli64 on MSVC, fseeko64 / ftello64 when _LARGEFILE64_SOURCE is defined, and fseeko / ftello on
+ * POSIX systems otherwise. On 32-bit Linux, build with -D_FILE_OFFSET_BITS=64 so that off_t is 64 bits wide, as
+ * CMakeLists.txt does.
+ *
+ * LB_FILE_SEEK returns 0 on success like fseek, LB_FILE_TELL returns -1 on failure like ftell. LB_FILE_STAT tells
+ * regular files apart from pipes, sockets, terminals and devices, where seeking may fail or report a length of 0.
+ *
+ * Every stdio call takes the FILE lock. lbWriterSetUnlocked and lbReaderSetUnlocked make the reads and writes of one
+ * writer or reader use the unlocked variants instead (fread_unlocked, putc_unlocked, _fread_nolock...) where the
+ * platform has them. The caller then guarantees that no other thread uses the stream at the same time: either it is
+ * only ever used from one thread, or every sequence of operations is bracketed by lbWriterLock / lbWriterUnlock
+ * (lbReaderLock / lbReaderUnlock), which take the lock once for the whole sequence. Other code can keep using the
+ * same FILE* as long as it does the same. The choice is made per stream at run time, not with a macro, so code built
+ * either way links against the same library.
+ */
+
+#ifdef __cplusplus
+#include <cstdio>
+#else
+#include <stdio.h>
+#endif
+
+#if defined(_MSC_VER)
+typedef long long LB_FileOffset;
+#define LB_FILE_SEEK(file, offset, whence) _fseeki64((file), (LB_FileOffset) (offset), (whence))
+#define LB_FILE_TELL(file) _ftelli64(file)
+#elif defined(_LARGEFILE64_SOURCE) && defined(__GLIBC__)
+typedef off64_t LB_FileOffset;
+#define LB_FILE_SEEK(file, offset, whence) fseeko64((file), (LB_FileOffset) (offset), (whence))
+#define LB_FILE_TELL(file) ftello64(file)
+#elif (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200112L) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__OpenBSD__) || defined(__NetBSD__)
+typedef off_t LB_FileOffset;
+#define LB_FILE_SEEK(file, offset, whence) fseeko((file), (LB_FileOffset) (offset), (whence))
+#define LB_FILE_TELL(file) ftello(file)
+#else
+typedef long LB_FileOffset;
+#define LB_FILE_SEEK(file, offset, whence) fseek((file), (LB_FileOffset) (offset), (whence))
+#define LB_FILE_TELL(file) ftell(file)
+#endif
+
+// LB_FILE_STAT fills a LB_FileStatus like fstat, returning 0 on success. Not defined where there is no equivalent.
+#if defined(_MSC_VER)
+#include <sys/types.h>
+#include <sys/stat.h>
+typedef struct _stat64 LB_FileStatus;
+#define LB_FILE_STAT(file, status) _fstat64(_fileno(file), (status))
+#define LB_FILE_STATUS_REGULAR(status) (((status)->st_mode & _S_IFMT) == _S_IFREG)
+#elif (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200112L) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__OpenBSD__) || defined(__NetBSD__)
+#include <sys/stat.h>
+typedef struct stat LB_FileStatus;
+#define LB_FILE_STAT(file, status) fstat(fileno(file), (status))
+#define LB_FILE_STATUS_REGULAR(status) S_ISREG((status)->st_mode)
+#endif
+
+#if defined(_MSC_VER)
+#define LB_FILE_LOCK(file) _lock_file(file)
+#define LB_FILE_UNLOCK(file) _unlock_file(file)
+#elif (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 199506L) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__OpenBSD__) || defined(__NetBSD__)
+#define LB_FILE_POSIX_LOCKS
+#define LB_FILE_LOCK(file) flockfile(file)
+#define LB_FILE_UNLOCK(file) funlockfile(file)
+#else
+#define LB_FILE_LOCK(file) ((void) (file))
+#define LB_FILE_UNLOCK(file) ((void) (file))
+#endif
+
+// Transfer `length` bytes, evaluating to 1 on success and 0 otherwise, like fread(data, length, 1, file).
+#define LB_FILE_READ(data, length, file) fread((data), (length), 1, (file))
+#define LB_FILE_WRITE(data, length, file) fwrite((data), (length), 1, (file))
+#define LB_FILE_PUTC(byte, file) putc((byte), (file))
+#define LB_FILE_FLUSH(file) fflush(file)
+
+// The same without taking the FILE lock, where the platform can.
+#if defined(_MSC_VER)
+#define LB_FILE_READ_UNLOCKED(data, length, file) _fread_nolock((data), (length), 1, (file))
+#define LB_FILE_WRITE_UNLOCKED(data, length, file) _fwrite_nolock((data), (length), 1, (file))
+#define LB_FILE_PUTC_UNLOCKED(byte, file) _putc_nolock((byte), (file))
+#define LB_FILE_FLUSH_UNLOCKED(file) _fflush_nolock(file)
+#elif defined(__GLIBC__) && (defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE))
+#define LB_FILE_READ_UNLOCKED(data, length, file) fread_unlocked((data), (length), 1, (file))
+#define LB_FILE_WRITE_UNLOCKED(data, length, file) fwrite_unlocked((data), (length), 1, (file))
+#define LB_FILE_PUTC_UNLOCKED(byte, file) putc_unlocked((byte), (file))
+#define LB_FILE_FLUSH_UNLOCKED(file) fflush_unlocked(file)
+#elif defined(LB_FILE_POSIX_LOCKS)
+// POSIX only has the single character functions unlocked.
+#define LB_FILE_READ_UNLOCKED(data, length, file) LB_FILE_READ(data, length, file)
+#define LB_FILE_WRITE_UNLOCKED(data, length, file) LB_FILE_WRITE(data, length, file)
+#define LB_FILE_PUTC_UNLOCKED(byte, file) putc_unlocked((byte), (file))
+#define LB_FILE_FLUSH_UNLOCKED(file) LB_FILE_FLUSH(file)
+#else
+#define LB_FILE_READ_UNLOCKED(data, length, file) LB_FILE_READ(data, length, file)
+#define LB_FILE_WRITE_UNLOCKED(data, length, file) LB_FILE_WRITE(data, length, file)
+#define LB_FILE_PUTC_UNLOCKED(byte, file) LB_FILE_PUTC(byte, file)
+#define LB_FILE_FLUSH_UNLOCKED(file) LB_FILE_FLUSH(file)
+#endif
+
+#endif //LB_FILE_H
@@ -0,0 +1,449 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_HISTOGRAM_H
+#define LB_HISTOGRAM_H
+
+/*
+ * Opt-in latency histograms for the slow paths: file writes and reads, dynamic buffer growth, flushes and arena
+ * page allocation.
+ *
+ * Define LB_BUFFER_HISTOGRAMS for every translation unit to enable them, and LB_HISTOGRAM_IMPLEMENTATION (implied by
+ * LB_BUFFER_IMPLEMENTATION) in exactly one. The implementation needs the complete LB_Writer and LB_Reader types:
+ * either include this header before lb_writer.h, or include it again after lb_writer.h and lb_reader.h. Without
+ * LB_BUFFER_HISTOGRAMS every hook expands to nothing.
+ *
+ * Buckets are logarithmic with LB_HISTOGRAM_SUB_BUCKETS linear steps per power of two, so every bucket is within
+ * 12.5% of its value. Every thread records into its own shard, and snapshots merge all shards, including those of
+ * threads that have exited. Shards are never freed.
+ */
+
+#ifdef LB_BUFFER_HISTOGRAMS
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+extern "C" {
+#else
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// "LBHG" read as a little endian u32, the first field of the binary export.
+#define LB_HISTOGRAM_MAGIC 0x4748424Cu
+#define LB_HISTOGRAM_VERSION 1
+#define LB_HISTOGRAM_SUB_BUCKET_BITS 3
+#define LB_HISTOGRAM_SUB_BUCKETS (1u << LB_HISTOGRAM_SUB_BUCKET_BITS)
+// Values of 2^LB_HISTOGRAM_MAX_BITS nanoseconds (about 18 minutes) and above land in the last bucket.
+#define LB_HISTOGRAM_MAX_BITS 40
+#define LB_HISTOGRAM_BUCKETS ((LB_HISTOGRAM_MAX_BITS - LB_HISTOGRAM_SUB_BUCKET_BITS + 1) * LB_HISTOGRAM_SUB_BUCKETS)
+
+#ifdef __cplusplus
+#define LB_HISTOGRAM_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define LB_HISTOGRAM_THREAD_LOCAL __declspec(thread)
+#else
+#define LB_HISTOGRAM_THREAD_LOCAL _Thread_local
+#endif
+
+typedef enum LB_HistogramKind {
+    // fwrite calls of file mode writers.
+    LB_HISTOGRAM_FILE_WRITE,
+    // fread calls of file mode readers.
+    LB_HISTOGRAM_FILE_READ,
+    // realloc calls growing a dynamic buffer.
+    LB_HISTOGRAM_GROW,
+    // lbWriterFlush.
+    LB_HISTOGRAM_FLUSH,
+    // New pages of a LB_PagedArena.
+    LB_HISTOGRAM_ARENA_PAGE,
+    LB_HISTOGRAM_KIND_COUNT,
+} LB_HistogramKind;
+
+typedef struct LB_HistogramShard LB_HistogramShard;
+struct LB_Writer;
+struct LB_Reader;
+
+// A merged histogram, all values in nanoseconds.
+typedef struct LB_Histogram {
+    uint64_t counts[LB_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+} LB_Histogram;
+
+extern LB_HISTOGRAM_THREAD_LOCAL LB_HistogramShard *lb_histogram_shard;
+
+const char *lbHistogramKindName(LB_HistogramKind kind);
+
+// Monotonic time in nanoseconds.
+inline uint64_t lbHistogramNow(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t) ((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+#else
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+inline uint32_t lbHistogramBucket(const uint64_t value) {
+    if (value < LB_HISTOGRAM_SUB_BUCKETS) {
+        return (uint32_t) value;
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    uint32_t msb = 63 - (uint32_t) __builtin_clzll(value);
+#else
+    uint32_t msb = 0;
+    while (value >> (msb + 1)) {
+        msb++;
+    }
+#endif
+    if (msb >= LB_HISTOGRAM_MAX_BITS) {
+        return LB_HISTOGRAM_BUCKETS - 1;
+    }
+
+    const uint32_t shift = msb - LB_HISTOGRAM_SUB_BUCKET_BITS;
+    return (msb - LB_HISTOGRAM_SUB_BUCKET_BITS + 1) * LB_HISTOGRAM_SUB_BUCKETS +
+           (uint32_t) ((value >> shift) & (LB_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+// Smallest value that lands in `bucket`.
+uint64_t lbHistogramBucketLow(uint32_t bucket);
+
+// Largest value that lands in `bucket`.
+uint64_t lbHistogramBucketHigh(uint32_t bucket);
+
+// Create and register the shard of the calling thread, returns NULL if it could not be allocated.
+LB_HistogramShard *lbHistogramShardAcquire(void);
+
+void lbHistogramShardRecord(LB_HistogramShard *shard, LB_HistogramKind kind, uint64_t value);
+
+inline void lbHistogramRecord(const LB_HistogramKind kind, const uint64_t value) {
+    LB_HistogramShard *shard = lb_histogram_shard;
+    if (shard == NULL) {
+        shard = lbHistogramShardAcquire();
+        if (shard == NULL) {
+            return;
+        }
+    }
+
+    lbHistogramShardRecord(shard, kind, value);
+}
+
+#define LB_HISTOGRAM_BEGIN(start) const uint64_t start = lbHistogramNow()
+#define LB_HISTOGRAM_END(kind, start) lbHistogramRecord((kind), lbHistogramNow() - (start))
+
+// Merge every shard of `kind` into `out_histogram`.
+void lbHistogramSnapshot(LB_HistogramKind kind, LB_Histogram *out_histogram);
+
+// Set every shard to zero. Values recorded concurrently may be lost.
+void lbHistogramReset(void);
+
+// Upper bound of the bucket holding the `percentile` (0 to 100) value, 0 if the histogram is empty.
+uint64_t lbHistogramPercentile(const LB_Histogram *histogram, double percentile);
+
+// Print a summary line and every non-empty bucket.
+void lbHistogramPrint(FILE *file, LB_HistogramKind kind, const LB_Histogram *histogram);
+
+/**
+ * Write a snapshot of every kind. <br>
+ * The format is little endian: u32 magic, u16 version, u16 kind count, u16 bucket count, u8 sub-bucket bits, then
+ * for every kind u64 count, sum and max, a u16 number of non-empty buckets and for each a u16 index and u64 count.
+ *
+ * @return The accumulated LB_WriterError bits, 0 on success.
+ */
+uint32_t lbHistogramWrite(struct LB_Writer *writer);
+
+/**
+ * Read an export written by lbHistogramWrite.
+ *
+ * @param out_histograms One histogram per LB_HistogramKind.
+ * @return The accumulated LB_ReaderError bits, 0 on success.
+ */
+uint32_t lbHistogramRead(struct LB_Reader *reader, LB_Histogram out_histograms[LB_HISTOGRAM_KIND_COUNT]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+#define LB_HISTOGRAM_BEGIN(start) ((void) 0)
+#define LB_HISTOGRAM_END(kind, start) ((void) 0)
+#endif
+
+#endif //LB_HISTOGRAM_H
+
+#if defined(LB_HISTOGRAM_IMPLEMENTATION) && defined(LB_BUFFER_HISTOGRAMS) && !defined(LB_HISTOGRAM_IMPLEMENTED)
+#define LB_HISTOGRAM_IMPLEMENTED
+#include "lb_writer.h"
+#include "lb_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct LB_HistogramShard {
+    LB_HistogramShard *next;
+    uint64_t counts[LB_HISTOGRAM_KIND_COUNT][LB_HISTOGRAM_BUCKETS];
+    uint64_t sum[LB_HISTOGRAM_KIND_COUNT];
+    uint64_t max[LB_HISTOGRAM_KIND_COUNT];
+};
+
+LB_HISTOGRAM_THREAD_LOCAL LB_HistogramShard *lb_histogram_shard = NULL;
+static LB_HistogramShard *lb_histogram_shards = NULL;
+
+uint64_t lbHistogramNow(void);
+uint32_t lbHistogramBucket(uint64_t value);
+void lbHistogramRecord(LB_HistogramKind kind, uint64_t value);
+
+// Only the owning thread writes a shard, so a relaxed load and store is enough and avoids a locked add.
+static void lbHistogramStore(uint64_t *target, const uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(target, value, __ATOMIC_RELAXED);
+#else
+    *target = value;
+#endif
+}
+
+static uint64_t lbHistogramLoad(const uint64_t *source) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(source, __ATOMIC_RELAXED);
+#else
+    return *source;
+#endif
+}
+
+const char *lbHistogramKindName(const LB_HistogramKind kind) {
+    switch (kind) {
+        case LB_HISTOGRAM_FILE_WRITE: return "file_write";
+        case LB_HISTOGRAM_FILE_READ: return "file_read";
+        case LB_HISTOGRAM_GROW: return "grow";
+        case LB_HISTOGRAM_FLUSH: return "flush";
+        case LB_HISTOGRAM_ARENA_PAGE: return "arena_page";
+        default: return "unknown";
+    }
+}
+
+uint64_t lbHistogramBucketLow(const uint32_t bucket) {
+    if (bucket < LB_HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+
+    const uint32_t msb = bucket / LB_HISTOGRAM_SUB_BUCKETS + LB_HISTOGRAM_SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = bucket % LB_HISTOGRAM_SUB_BUCKETS;
+    return (LB_HISTOGRAM_SUB_BUCKETS + sub_bucket) << (msb - LB_HISTOGRAM_SUB_BUCKET_BITS);
+}
+
+uint64_t lbHistogramBucketHigh(const uint32_t bucket) {
+    if (bucket >= LB_HISTOGRAM_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+
+    return lbHistogramBucketLow(bucket + 1) - 1;
+}
+
+LB_HistogramShard *lbHistogramShardAcquire(void) {
+    LB_HistogramShard *shard = (LB_HistogramShard *) calloc(1, sizeof(LB_HistogramShard));
+    if (shard == NULL) {
+        return NULL;
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    shard->next = __atomic_load_n(&lb_histogram_shards, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&lb_histogram_shards, &shard->next, shard, 1, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {
+    }
+#else
+    shard->next = lb_histogram_shards;
+    lb_histogram_shards = shard;
+#endif
+    lb_histogram_shard = shard;
+    return shard;
+}
+
+void lbHistogramShardRecord(LB_HistogramShard *shard, const LB_HistogramKind kind, const uint64_t value) {
+    uint64_t *count = &shard->counts[kind][lbHistogramBucket(value)];
+    lbHistogramStore(count, *count + 1);
+    lbHistogramStore(&shard->sum[kind], shard->sum[kind] + value);
+    if (value > shard->max[kind]) {
+        lbHistogramStore(&shard->max[kind], value);
+    }
+}
+
+static LB_HistogramShard *lbHistogramShardsHead(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(&lb_histogram_shards, __ATOMIC_ACQUIRE);
+#else
+    return lb_histogram_shards;
+#endif
+}
+
+void lbHistogramSnapshot(const LB_HistogramKind kind, LB_Histogram *out_histogram) {
+    memset(out_histogram, 0, sizeof(*out_histogram));
+    for (const LB_HistogramShard *shard = lbHistogramShardsHead(); shard != NULL; shard = shard->next) {
+        for (uint32_t bucket = 0; bucket < LB_HISTOGRAM_BUCKETS; bucket++) {
+            const uint64_t count = lbHistogramLoad(&shard->counts[kind][bucket]);
+            out_histogram->counts[bucket] += count;
+            out_histogram->count += count;
+        }
+
+        out_histogram->sum += lbHistogramLoad(&shard->sum[kind]);
+        const uint64_t max = lbHistogramLoad(&shard->max[kind]);
+        out_histogram->max = max > out_histogram->max ? max : out_histogram->max;
+    }
+}
+
+void lbHistogramReset(void) {
+    for (LB_HistogramShard *shard = lbHistogramShardsHead(); shard != NULL; shard = shard->next) {
+        for (int kind = 0; kind < LB_HISTOGRAM_KIND_COUNT; kind++) {
+            for (uint32_t bucket = 0; bucket < LB_HISTOGRAM_BUCKETS; bucket++) {
+                lbHistogramStore(&shard->counts[kind][bucket], 0);
+            }
+            lbHistogramStore(&shard->sum[kind], 0);
+            lbHistogramStore(&shard->max[kind], 0);
+        }
+    }
+}
+
+uint64_t lbHistogramPercentile(const LB_Histogram *histogram, const double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t) (percentile / 100.0 * (double) histogram->count + 0.5);
+    rank = rank == 0 ? 1 : rank > histogram->count ? histogram->count : rank;
+
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < LB_HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            const uint64_t high = lbHistogramBucketHigh(bucket);
+            return high < histogram->max ? high : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+void lbHistogramPrint(FILE *file, const LB_HistogramKind kind, const LB_Histogram *histogram) {
+    fprintf(file, "%s count %llu mean %.1f p50 %llu p90 %llu p99 %llu p99.9 %llu max %llu ns\n",
+            lbHistogramKindName(kind), (unsigned long long) histogram->count,
+            histogram->count ? (double) histogram->sum / (double) histogram->count : 0.0,
+            (unsigned long long) lbHistogramPercentile(histogram, 50.0),
+            (unsigned long long) lbHistogramPercentile(histogram, 90.0),
+            (unsigned long long) lbHistogramPercentile(histogram, 99.0),
+            (unsigned long long) lbHistogramPercentile(histogram, 99.9),
+            (unsigned long long) histogram->max);
+
+    for (uint32_t bucket = 0; bucket < LB_HISTOGRAM_BUCKETS; bucket++) {
+        if (histogram->counts[bucket]) {
+            fprintf(file, "    [%llu, %llu] %llu\n", (unsigned long long) lbHistogramBucketLow(bucket),
+                    (unsigned long long) lbHistogramBucketHigh(bucket), (unsigned long long) histogram->counts[bucket]);
+        }
+    }
+}
+
+uint32_t lbHistogramWrite(LB_Writer *writer) {
+    LB_WriterError e = LB_WRITER_ERROR_NONE;
+    e |= lbWriteU32LE(writer, LB_HISTOGRAM_MAGIC);
+    e |= lbWriteU16LE(writer, LB_HISTOGRAM_VERSION);
+    e |= lbWriteU16LE(writer, LB_HISTOGRAM_KIND_COUNT);
+    e |= lbWriteU16LE(writer, LB_HISTOGRAM_BUCKETS);
+    e |= lbWriteU8(writer, LB_HISTOGRAM_SUB_BUCKET_BITS);
+
+    LB_Histogram histogram;
+    for (int kind = 0; kind < LB_HISTOGRAM_KIND_COUNT; kind++) {
+        lbHistogramSnapshot((LB_HistogramKind) kind, &histogram);
+        e |= lbWriteU64LE(writer, histogram.count);
+        e |= lbWriteU64LE(writer, histogram.sum);
+        e |= lbWriteU64LE(writer, histogram.max);
+
+        uint16_t used = 0;
+        for (uint32_t bucket = 0; bucket < LB_HISTOGRAM_BUCKETS; bucket++) {
+            used += histogram.counts[bucket] != 0;
+        }
+
+        e |= lbWriteU16LE(writer, used);
+        for (uint32_t bucket = 0; bucket < LB_HISTOGRAM_BUCKETS; bucket++) {
+            if (histogram.counts[bucket]) {
+                e |= lbWriteU16LE(writer, (uint16_t) bucket);
+                e |= lbWriteU64LE(writer, histogram.counts[bucket]);
+            }
+        }
+    }
+
+    return e;
+}
+
+uint32_t lbHistogramRead(LB_Reader *reader, LB_Histogram out_histograms[LB_HISTOGRAM_KIND_COUNT]) {
+    memset(out_histograms, 0, LB_HISTOGRAM_KIND_COUNT * sizeof(LB_Histogram));
+
+    // The typed reads assign their error, so each is read into `read_error` and or'ed into `e`. Otherwise a read that
+    // succeeds after a failed one would clear the failure.
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    LB_ReaderError read_error = LB_READER_ERROR_NONE;
+    const uint32_t magic = lbReadU32LE(reader, &read_error);
+    e |= read_error;
+    const uint16_t version = lbReadU16LE(reader, &read_error);
+    e |= read_error;
+    const uint16_t kind_count = lbReadU16LE(reader, &read_error);
+    e |= read_error;
+    const uint16_t bucket_count = lbReadU16LE(reader, &read_error);
+    e |= read_error;
+    const uint8_t sub_bucket_bits = lbReadU8(reader, &read_error);
+    e |= read_error;
+    if (e || magic != LB_HISTOGRAM_MAGIC || version != LB_HISTOGRAM_VERSION || kind_count > LB_HISTOGRAM_KIND_COUNT ||
+        bucket_count != LB_HISTOGRAM_BUCKETS || sub_bucket_bits != LB_HISTOGRAM_SUB_BUCKET_BITS) {
+        return e | LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    for (uint16_t kind = 0; kind < kind_count && !e; kind++) {
+        LB_Histogram *histogram = &out_histograms[kind];
+        histogram->count = lbReadU64LE(reader, &read_error);
+        e |= read_error;
+        histogram->sum = lbReadU64LE(reader, &read_error);
+        e |= read_error;
+        histogram->max = lbReadU64LE(reader, &read_error);
+        e |= read_error;
+        const uint16_t used = lbReadU16LE(reader, &read_error);
+        e |= read_error;
+
+        for (uint16_t i = 0; i < used && !e; i++) {
+            const uint16_t bucket = lbReadU16LE(reader, &read_error);
+            e |= read_error;
+            const uint64_t count = lbReadU64LE(reader, &read_error);
+            e |= read_error;
+            if (e) {
+                break;
+            }
+
+            if (bucket >= LB_HISTOGRAM_BUCKETS) {
+                e |= LB_READER_ERROR_INVALID_VALUE;
+                break;
+            }
+            histogram->counts[bucket] = count;
+        }
+    }
+
+    return e;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_HISTOGRAM_IMPLEMENTATION
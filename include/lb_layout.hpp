@@ -0,0 +1,214 @@
+#ifndef LB_LAYOUT_HPP
+#define LB_LAYOUT_HPP
+
+/*
+ * Compile-time layouts for fixed-format messages.
+ *
+ * A layout lists the members of a struct in wire order. Its encoded size and every field offset are constants, so
+ * serializing a message is one capacity check followed by stores at fixed offsets, with no per-field bookkeeping:
+ *
+ *     struct Order { uint64_t id; char symbol[8]; uint32_t quantity; double price; uint8_t side; };
+ *
+ *     using OrderLayout = lb::Layout<lb::Member<&Order::id, std::endian::big>,
+ *                                    lb::Member<&Order::symbol>,
+ *                                    lb::Member<&Order::quantity, std::endian::big>,
+ *                                    lb::Member<&Order::price, std::endian::big>,
+ *                                    lb::Pad<3>,
+ *                                    lb::Member<&Order::side>>;
+ *
+ *     static_assert(OrderLayout::size == 32 && OrderLayout::offset<3> == 20);
+ *     OrderLayout::write(&writer, order);
+ *
+ * Members may be arithmetic types, enums (encoded as their underlying type) or fixed arrays of those.
+ */
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "lb_buffer.hpp"
+
+namespace lb {
+
+template <class>
+struct MemberPointerTraits;
+
+template <class C, class T>
+struct MemberPointerTraits<T C::*> {
+    using Class = C;
+    using Type = T;
+};
+
+// The type a member is encoded as: itself, the underlying type of an enum, per element for arrays.
+template <class T>
+struct WireType {
+    using Type = T;
+};
+
+template <class T>
+    requires std::is_enum_v<T>
+struct WireType<T> {
+    using Type = std::underlying_type_t<T>;
+};
+
+template <auto P, std::endian E = std::endian::little>
+struct Member {
+    using Class = typename MemberPointerTraits<decltype(P)>::Class;
+    using Type = typename MemberPointerTraits<decltype(P)>::Type;
+    using Element = std::remove_all_extents_t<Type>;
+    using Wire = typename WireType<Element>::Type;
+    static_assert(Scalar<Wire>, "members must be arithmetic types, enums or arrays of those");
+
+    static constexpr size_t size = sizeof(Type);
+    static constexpr size_t count = sizeof(Type) / sizeof(Element);
+
+    static void store(uint8_t *out, const Class &message) noexcept {
+        const Element *elements = reinterpret_cast<const Element *>(&(message.*P));
+        for (size_t i = 0; i < count; i++) {
+            const Wire value = toEndian<E>(static_cast<Wire>(elements[i]));
+            std::memcpy(out + i * sizeof(Wire), &value, sizeof(Wire));
+        }
+    }
+
+    static void load(const uint8_t *in, Class &message) noexcept {
+        Element *elements = reinterpret_cast<Element *>(&(message.*P));
+        for (size_t i = 0; i < count; i++) {
+            Wire value;
+            std::memcpy(&value, in + i * sizeof(Wire), sizeof(Wire));
+            elements[i] = static_cast<Element>(toEndian<E>(value));
+        }
+    }
+};
+
+// `N` reserved bytes, written as zero and skipped on read.
+template <size_t N>
+struct Pad {
+    static constexpr size_t size = N;
+
+    template <class C>
+    static void store(uint8_t *out, const C &) noexcept {
+        std::memset(out, 0, N);
+    }
+
+    template <class C>
+    static void load(const uint8_t *, C &) noexcept {
+    }
+};
+
+template <class... Fields>
+struct Layout {
+    static constexpr size_t count = sizeof...(Fields);
+    static constexpr size_t size = (size_t{0} + ... + Fields::size);
+    static constexpr std::array<size_t, count> offsets = [] {
+        std::array<size_t, count> result{};
+        size_t offset = 0;
+        size_t index = 0;
+        ((result[index++] = offset, offset += Fields::size), ...);
+        return result;
+    }();
+
+    template <size_t I>
+    static constexpr size_t offset = offsets[I];
+
+    // Encode `message` into exactly `size` bytes at `out`, no bounds checks.
+    template <class C>
+    static void store(uint8_t *out, const C &message) noexcept {
+        storeFields(out, message, std::index_sequence_for<Fields...>{});
+    }
+
+    // Decode exactly `size` bytes at `in` into `out_message`, no bounds checks.
+    template <class C>
+    static void load(const uint8_t *in, C &out_message) noexcept {
+        loadFields(in, out_message, std::index_sequence_for<Fields...>{});
+    }
+
+    /**
+     * Write `message` through the C API. <br>
+     * Buffer writers are checked once for `size` bytes (growing a dynamic buffer if needed) and the message is stored
+     * in place. File writers encode on the stack and issue a single lbWrite.
+     */
+    template <class C>
+    static LB_WriterError write(LB_Writer *writer, const C &message) noexcept {
+        if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+            LB_WriterBuffer *buffer = &writer->_.buffer;
+            if (size > buffer->length - buffer->position) [[unlikely]] {
+                if (writer->_.mode & LB_WRITER_MODE_DYNAMIC_BUFFER) {
+                    if (const LB_WriterError e = lbWriterGrow(writer, buffer->position + size)) {
+                        return e;
+                    }
+                } else {
+                    return LB_WRITER_ERROR_FULL;
+                }
+            }
+
+            store(static_cast<uint8_t *>(buffer->data) + buffer->position, message);
+            buffer->position += size;
+            return LB_WRITER_ERROR_NONE;
+        }
+
+        std::array<uint8_t, size> bytes;
+        store(bytes.data(), message);
+        return lbWrite(writer, bytes.data(), size);
+    }
+
+    // Read a message through the C API, one bounds check for buffer readers.
+    template <class C>
+    static LB_ReaderError read(LB_Reader *reader, C &out_message) noexcept {
+        if (reader->_.mode == LB_READER_MODE_BUFFER) {
+            LB_ReaderBuffer *buffer = &reader->_.buffer;
+            if (size > buffer->length - buffer->position) [[unlikely]] {
+                return LB_READER_ERROR_END;
+            }
+
+            load(static_cast<const uint8_t *>(buffer->data) + buffer->position, out_message);
+            buffer->position += size;
+            return LB_READER_ERROR_NONE;
+        }
+
+        std::array<uint8_t, size> bytes;
+        if (const LB_ReaderError e = lbRead(reader, bytes.data(), size)) {
+            return e;
+        }
+
+        load(bytes.data(), out_message);
+        return LB_READER_ERROR_NONE;
+    }
+
+    // Write through the C++ wrapper: one check, none for Unchecked buffer writers.
+    template <class M, class C>
+    static LB_WriterError write(Writer<M> &writer, const C &message) noexcept {
+        std::array<uint8_t, size> bytes;
+        store(bytes.data(), message);
+        return writer.write(bytes.data(), size);
+    }
+
+    template <class M, class C>
+    static LB_ReaderError read(Reader<M> &reader, C &out_message) noexcept {
+        std::array<uint8_t, size> bytes;
+        if (const LB_ReaderError e = reader.read(bytes.data(), size)) {
+            return e;
+        }
+
+        load(bytes.data(), out_message);
+        return LB_READER_ERROR_NONE;
+    }
+
+private:
+    template <class C, size_t... I>
+    static void storeFields(uint8_t *out, const C &message, std::index_sequence<I...>) noexcept {
+        (Fields::store(out + offsets[I], message), ...);
+    }
+
+    template <class C, size_t... I>
+    static void loadFields(const uint8_t *in, C &out_message, std::index_sequence<I...>) noexcept {
+        (Fields::load(in + offsets[I], out_message), ...);
+    }
+};
+
+} // namespace lb
+
+#endif //LB_LAYOUT_HPP
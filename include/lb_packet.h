@@ -0,0 +1,436 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_PACKET_H
+#define LB_PACKET_H
+
+#include "lb_writer.h"
+#include "lb_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Every packet is a sequence of frames. Each frame carries one message, or one fragment
+ * of a message that did not fit into a single packet, behind a little endian header:
+ *
+ *   u32 sequence        Message sequence number, shared by all fragments of a message.
+ *   u16 fragment_index  Index of this fragment.
+ *   u16 fragment_count  Number of fragments of the message, 1 if it is not fragmented.
+ *   u16 length          Number of payload bytes that follow.
+ */
+#define LB_PACKET_FRAME_HEADER_SIZE 10
+
+// Messages that are still missing fragments are dropped when more than this many are pending.
+#ifndef LB_PACKET_MAX_PENDING
+#define LB_PACKET_MAX_PENDING 16
+#endif
+
+// Messages are limited to this many fragments. The reassembler allocates one segment per fragment as soon as the
+// first fragment arrives, so this also bounds what a single forged frame header can make it allocate.
+#ifndef LB_PACKET_MAX_FRAGMENTS
+#define LB_PACKET_MAX_FRAGMENTS 1024
+#endif
+
+#if LB_PACKET_MAX_FRAGMENTS > 65535
+#error "LB_PACKET_MAX_FRAGMENTS must fit into the u16 fragment_count."
+#endif
+
+// Error codes for initializing a LB_PacketWriter or LB_PacketReassembler.
+typedef enum LB_PacketInitError {
+    // No error.
+    LB_PACKET_INIT_NONE = 0x0,
+    // The packet writer or reassembler is NULL.
+    LB_PACKET_INIT_NO_PACKET = 0x1,
+    // The MTU cannot hold a frame header and at least one payload byte, or exceeds 65535.
+    LB_PACKET_INIT_INVALID_MTU = 0x2,
+    // The callback is NULL.
+    LB_PACKET_INIT_NO_CALLBACK = 0x4,
+    // The packet buffer could not be allocated.
+    LB_PACKET_INIT_ALLOCATION_FAILED = 0x8,
+} LB_PacketInitError;
+
+#ifdef __cplusplus
+// A bit flag enum, see lb_writer.h.
+extern "C++" {
+inline LB_PacketInitError operator|(const LB_PacketInitError a, const LB_PacketInitError b) {
+    return (LB_PacketInitError) ((int) a | (int) b);
+}
+
+inline LB_PacketInitError &operator|=(LB_PacketInitError &a, const LB_PacketInitError b) {
+    return a = a | b;
+}
+}
+#endif
+
+const char* lbPacketInitErrorName(LB_PacketInitError e);
+const char* lbPacketInitErrorMessage(LB_PacketInitError e);
+
+// Called with every packet that is ready to be sent. The packet is reused after the call returns.
+typedef void (*LB_PacketSendFn)(void *user, const void *packet, size_t length);
+
+// Called with every reassembled message. The reader is only valid during the call.
+typedef void (*LB_PacketReceiveFn)(void *user, LB_Reader *message);
+
+typedef struct LB_PacketWriter {
+    // A buffer-mode writer over the packet that is currently being filled.
+    LB_Writer packet;
+    // Writer handed out by `lbPacketWriterBeginMessage`.
+    LB_Writer message;
+    size_t mtu;
+    uint32_t sequence;
+    LB_PacketSendFn send;
+    void *user;
+} LB_PacketWriter;
+
+typedef struct LB_PacketPending {
+    uint32_t sequence;
+    uint16_t fragment_count;
+    uint16_t received;
+    // One segment per fragment, the data of each segment is owned by the pending message.
+    LB_ReaderSegment *segments;
+} LB_PacketPending;
+
+typedef struct LB_PacketReassembler {
+    LB_PacketPending pending[LB_PACKET_MAX_PENDING];
+    LB_PacketReceiveFn receive;
+    void *user;
+} LB_PacketReassembler;
+
+LB_PacketInitError lbPacketWriterInit(LB_PacketWriter *packet_writer, size_t mtu, LB_PacketSendFn send, void *user);
+void lbPacketWriterFree(LB_PacketWriter *packet_writer);
+
+// Send the current packet, if it holds any frames.
+void lbPacketWriterFlush(LB_PacketWriter *packet_writer);
+
+/**
+ * Copy a serialized message into the outgoing packets, fragmenting it if it does not fit into one.  <br>
+ * Small messages share packets, call `lbPacketWriterFlush` to send a partially filled packet.
+ *
+ * @return LB_WRITER_ERROR_INVALID_VALUE if the message needs more than LB_PACKET_MAX_FRAGMENTS fragments.
+ */
+LB_WriterError lbPacketWriteMessage(LB_PacketWriter *packet_writer, const void *data, size_t length);
+
+/**
+ * Start a message of at most `max_length` bytes that is serialized directly into the packet,
+ * without any intermediate buffer. Finish it with `lbPacketWriterEndMessage`.
+ *
+ * @return A buffer-mode writer over the reserved space, or NULL if `max_length` does not fit into one packet.
+ */
+LB_Writer *lbPacketWriterBeginMessage(LB_PacketWriter *packet_writer, size_t max_length);
+void lbPacketWriterEndMessage(LB_PacketWriter *packet_writer);
+
+LB_PacketInitError lbPacketReassemblerInit(LB_PacketReassembler *reassembler, LB_PacketReceiveFn receive, void *user);
+void lbPacketReassemblerFree(LB_PacketReassembler *reassembler);
+
+/**
+ * Parse a received packet and pass every completed message to the receive callback.                    <br>
+ * Unfragmented messages are read straight from `packet`, fragments are copied once and read through
+ * a segmented LB_Reader once the message is complete.
+ *
+ * @return LB_READER_ERROR_INVALID_VALUE if the packet is malformed. Frames before the error are still delivered.
+ */
+LB_ReaderError lbPacketReceive(LB_PacketReassembler *reassembler, const void *packet, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_PACKET_H
+
+#ifdef LB_PACKET_IMPLEMENTATION
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* lbPacketInitErrorName(const LB_PacketInitError e) {
+    switch (e) {
+        case LB_PACKET_INIT_NONE:
+            return "LB_PACKET_INIT_NONE";
+        case LB_PACKET_INIT_NO_PACKET:
+            return "LB_PACKET_INIT_NO_PACKET";
+        case LB_PACKET_INIT_INVALID_MTU:
+            return "LB_PACKET_INIT_INVALID_MTU";
+        case LB_PACKET_INIT_NO_CALLBACK:
+            return "LB_PACKET_INIT_NO_CALLBACK";
+        case LB_PACKET_INIT_ALLOCATION_FAILED:
+            return "LB_PACKET_INIT_ALLOCATION_FAILED";
+        default:
+            return "LB_PACKET_INIT_UNKNOWN";
+    }
+}
+
+const char* lbPacketInitErrorMessage(const LB_PacketInitError e) {
+    switch (e) {
+        case LB_PACKET_INIT_NONE:
+            return "No error.";
+        case LB_PACKET_INIT_NO_PACKET:
+            return "The packet writer or reassembler is NULL.";
+        case LB_PACKET_INIT_INVALID_MTU:
+            return "The MTU cannot hold a frame header and at least one payload byte, or exceeds 65535.";
+        case LB_PACKET_INIT_NO_CALLBACK:
+            return "The callback is NULL.";
+        case LB_PACKET_INIT_ALLOCATION_FAILED:
+            return "The packet buffer could not be allocated.";
+        default:
+            return "Unknown error.";
+    }
+}
+
+LB_PacketInitError lbPacketWriterInit(LB_PacketWriter *packet_writer, const size_t mtu, const LB_PacketSendFn send, void *user) {
+    LB_PacketInitError e = LB_PACKET_INIT_NONE;
+    if (packet_writer == NULL) {
+        e |= LB_PACKET_INIT_NO_PACKET;
+    }
+
+    if (mtu <= LB_PACKET_FRAME_HEADER_SIZE || mtu > UINT16_MAX) {
+        e |= LB_PACKET_INIT_INVALID_MTU;
+    }
+
+    if (send == NULL) {
+        e |= LB_PACKET_INIT_NO_CALLBACK;
+    }
+
+    if (e) {
+        return e;
+    }
+
+    void *data = malloc(mtu);
+    if (data == NULL) {
+        return LB_PACKET_INIT_ALLOCATION_FAILED;
+    }
+
+    lbWriterInitBuffer(&packet_writer->packet, data, mtu);
+    packet_writer->mtu = mtu;
+    packet_writer->sequence = 0;
+    packet_writer->send = send;
+    packet_writer->user = user;
+    return LB_PACKET_INIT_NONE;
+}
+
+void lbPacketWriterFree(LB_PacketWriter *packet_writer) {
+    free(packet_writer->packet._.buffer.data);
+}
+
+void lbPacketWriterFlush(LB_PacketWriter *packet_writer) {
+    LB_WriterBuffer *buffer = &packet_writer->packet._.buffer;
+    if (buffer->position == 0) {
+        return;
+    }
+
+    packet_writer->send(packet_writer->user, buffer->data, buffer->position);
+    buffer->position = 0;
+}
+
+static void lbPacketWriteFrameHeader(LB_Writer *packet, const uint32_t sequence, const uint16_t index, const uint16_t count, const uint16_t length) {
+    lbWriteU32LE(packet, sequence);
+    lbWriteU16LE(packet, index);
+    lbWriteU16LE(packet, count);
+    lbWriteU16LE(packet, length);
+}
+
+LB_WriterError lbPacketWriteMessage(LB_PacketWriter *packet_writer, const void *data, const size_t length) {
+    LB_Writer *packet = &packet_writer->packet;
+    const size_t max_payload = packet_writer->mtu - LB_PACKET_FRAME_HEADER_SIZE;
+    const size_t fragment_count = length == 0 ? 1 : (length + max_payload - 1) / max_payload;
+    if (fragment_count > LB_PACKET_MAX_FRAGMENTS) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+    // Fragments always start on a fresh packet, unfragmented messages share packets.
+    if (fragment_count > 1 || lbWriterRemaining(packet) < LB_PACKET_FRAME_HEADER_SIZE + length) {
+        lbPacketWriterFlush(packet_writer);
+    }
+
+    const uint32_t sequence = packet_writer->sequence++;
+    size_t offset = 0;
+    for (size_t i = 0; i < fragment_count; i++) {
+        const size_t chunk = length - offset < max_payload ? length - offset : max_payload;
+        lbPacketWriteFrameHeader(packet, sequence, (uint16_t) i, (uint16_t) fragment_count, (uint16_t) chunk);
+        lbWriteUnsafe(packet, (const uint8_t *) data + offset, chunk);
+        offset += chunk;
+
+        if (i + 1 < fragment_count) {
+            lbPacketWriterFlush(packet_writer);
+        }
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
+
+LB_Writer *lbPacketWriterBeginMessage(LB_PacketWriter *packet_writer, const size_t max_length) {
+    LB_Writer *packet = &packet_writer->packet;
+    if (max_length > packet_writer->mtu - LB_PACKET_FRAME_HEADER_SIZE) {
+        return NULL;
+    }
+
+    if (lbWriterRemaining(packet) < LB_PACKET_FRAME_HEADER_SIZE + max_length) {
+        lbPacketWriterFlush(packet_writer);
+    }
+
+    // The header is written by `lbPacketWriterEndMessage` once the length is known.
+    LB_WriterBuffer *buffer = &packet->_.buffer;
+    uint8_t *payload = (uint8_t *) buffer->data + buffer->position + LB_PACKET_FRAME_HEADER_SIZE;
+    packet_writer->message = (LB_Writer) {
+        ._ = {
+            .mode = LB_WRITER_MODE_BUFFER,
+            .buffer = {
+                .data = payload,
+                .length = buffer->length - buffer->position - LB_PACKET_FRAME_HEADER_SIZE,
+                .position = 0,
+            },
+        },
+    };
+    return &packet_writer->message;
+}
+
+void lbPacketWriterEndMessage(LB_PacketWriter *packet_writer) {
+    LB_Writer *packet = &packet_writer->packet;
+    const size_t length = packet_writer->message._.buffer.position;
+    lbPacketWriteFrameHeader(packet, packet_writer->sequence++, 0, 1, (uint16_t) length);
+    packet->_.buffer.position += length;
+}
+
+LB_PacketInitError lbPacketReassemblerInit(LB_PacketReassembler *reassembler, const LB_PacketReceiveFn receive, void *user) {
+    LB_PacketInitError e = LB_PACKET_INIT_NONE;
+    if (reassembler == NULL) {
+        e |= LB_PACKET_INIT_NO_PACKET;
+    }
+
+    if (receive == NULL) {
+        e |= LB_PACKET_INIT_NO_CALLBACK;
+    }
+
+    if (e) {
+        return e;
+    }
+
+    memset(reassembler->pending, 0, sizeof(reassembler->pending));
+    reassembler->receive = receive;
+    reassembler->user = user;
+    return LB_PACKET_INIT_NONE;
+}
+
+static void lbPacketPendingFree(LB_PacketPending *pending) {
+    if (pending->segments == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < pending->fragment_count; i++) {
+        free((void *) pending->segments[i].data);
+    }
+
+    free(pending->segments);
+    pending->segments = NULL;
+}
+
+void lbPacketReassemblerFree(LB_PacketReassembler *reassembler) {
+    for (size_t i = 0; i < LB_PACKET_MAX_PENDING; i++) {
+        lbPacketPendingFree(&reassembler->pending[i]);
+    }
+}
+
+static LB_PacketPending *lbPacketReassemblerFind(LB_PacketReassembler *reassembler, const uint32_t sequence, const uint16_t fragment_count) {
+    LB_PacketPending *free_slot = NULL;
+    LB_PacketPending *oldest = NULL;
+    for (size_t i = 0; i < LB_PACKET_MAX_PENDING; i++) {
+        LB_PacketPending *pending = &reassembler->pending[i];
+        if (pending->segments == NULL) {
+            free_slot = free_slot ? free_slot : pending;
+            continue;
+        }
+
+        if (pending->sequence == sequence) {
+            return pending->fragment_count == fragment_count ? pending : NULL;
+        }
+
+        // Sequence numbers wrap, compare their distance instead of their value.
+        if (oldest == NULL || (int32_t) (pending->sequence - oldest->sequence) < 0) {
+            oldest = pending;
+        }
+    }
+
+    LB_PacketPending *pending = free_slot;
+    if (pending == NULL) {
+        lbPacketPendingFree(oldest);
+        pending = oldest;
+    }
+
+    LB_ReaderSegment *segments = (LB_ReaderSegment *) calloc(fragment_count, sizeof(LB_ReaderSegment));
+    if (segments == NULL) {
+        return NULL;
+    }
+
+    pending->sequence = sequence;
+    pending->fragment_count = fragment_count;
+    pending->received = 0;
+    pending->segments = segments;
+    return pending;
+}
+
+LB_ReaderError lbPacketReceive(LB_PacketReassembler *reassembler, const void *packet, const size_t length) {
+    LB_Reader frames;
+    if (lbReaderInitBuffer(&frames, packet, length)) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    while (lbReaderRemaining(&frames) >= LB_PACKET_FRAME_HEADER_SIZE) {
+        const uint32_t sequence = lbReadU32LE(&frames, NULL);
+        const uint16_t fragment_index = lbReadU16LE(&frames, NULL);
+        const uint16_t fragment_count = lbReadU16LE(&frames, NULL);
+        const uint16_t fragment_length = lbReadU16LE(&frames, NULL);
+        if (fragment_length > lbReaderRemaining(&frames) || fragment_index >= fragment_count) {
+            return LB_READER_ERROR_INVALID_VALUE;
+        }
+
+        const uint8_t *payload = (const uint8_t *) packet + lbReaderPosition(&frames);
+        frames._.buffer.position += fragment_length;
+
+        if (fragment_count == 1) {
+            LB_Reader message;
+            if (fragment_length == 0) {
+                // Buffer mode does not allow empty buffers.
+                lbReaderInitSegmented(&message, NULL, 0);
+            } else {
+                lbReaderInitBuffer(&message, payload, fragment_length);
+            }
+
+            reassembler->receive(reassembler->user, &message);
+            continue;
+        }
+
+        if (fragment_count > LB_PACKET_MAX_FRAGMENTS) {
+            // Never sent by a LB_PacketWriter with the same limit, dropped before anything is allocated for it.
+            continue;
+        }
+
+        LB_PacketPending *pending = lbPacketReassemblerFind(reassembler, sequence, fragment_count);
+        if (pending == NULL || pending->segments[fragment_index].data != NULL) {
+            // Out of memory, mismatched fragment count or a duplicate.
+            continue;
+        }
+
+        void *copy = malloc(fragment_length ? fragment_length : 1);
+        if (copy == NULL) {
+            continue;
+        }
+
+        memcpy(copy, payload, fragment_length);
+        pending->segments[fragment_index] = (LB_ReaderSegment) { .data = copy, .length = fragment_length };
+        pending->received++;
+
+        if (pending->received == pending->fragment_count) {
+            LB_Reader message;
+            lbReaderInitSegmented(&message, pending->segments, pending->fragment_count);
+            reassembler->receive(reassembler->user, &message);
+            lbPacketPendingFree(pending);
+        }
+    }
+
+    return lbReaderRemaining(&frames) == 0 ? LB_READER_ERROR_NONE : LB_READER_ERROR_INVALID_VALUE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_PACKET_IMPLEMENTATION
@@ -4,13 +4,19 @@
 
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 extern "C" {
 #else
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #endif
 
+#include "lb_stats.h"
+#include "lb_histogram.h"
+#include "lb_probes.h"
+
 typedef struct LB_PagedArenaPage LB_PagedArenaPage;
 typedef struct LB_PagedArena LB_PagedArena;
 
@@ -19,13 +25,17 @@ void lbPagedArenaFree(LB_PagedArena *arena);
 void lbPagedArenaClear(LB_PagedArena *arena);
 void* lbPagedArenaAlloc(LB_PagedArena *arena, size_t size);
 
+// Like lbPagedArenaAlloc, with the result aligned to `alignment`, which must be a power of two.
+void* lbPagedArenaAllocAligned(LB_PagedArena *arena, size_t size, size_t alignment);
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif //LB_PAGED_ARENA_H
 
-#ifdef LB_PAGED_ARENA_IMPLEMENTATION
+#if defined(LB_PAGED_ARENA_IMPLEMENTATION) && !defined(LB_PAGED_ARENA_IMPLEMENTED)
+#define LB_PAGED_ARENA_IMPLEMENTED
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -46,7 +56,7 @@ typedef struct LB_PagedArena {
 
 static LB_PagedArenaPage *lbPagedArenaPageNew(size_t capacity) {
     void* data = malloc(sizeof(LB_PagedArenaPage) + capacity);
-    LB_PagedArenaPage *page = data;
+    LB_PagedArenaPage *page = (LB_PagedArenaPage *) data;
     if(page == NULL) {
         return NULL;
     }
@@ -104,13 +114,27 @@ void lbPagedArenaClear(LB_PagedArena *arena) {
     }
 }
 
+// Bytes needed in front of the next allocation in `page` to align it.
+static size_t lbPagedArenaPadding(const LB_PagedArenaPage *page, const size_t alignment) {
+    const uintptr_t address = (uintptr_t) page->data + page->length;
+    return (alignment - (address & (alignment - 1))) & (alignment - 1);
+}
+
 void * lbPagedArenaAlloc(LB_PagedArena *arena, const size_t size) {
+    return lbPagedArenaAllocAligned(arena, size, 1);
+}
+
+void * lbPagedArenaAllocAligned(LB_PagedArena *arena, const size_t size, const size_t alignment) {
+    LB_STATS_ADD(arena_allocs, 1);
+    LB_STATS_ADD(arena_bytes, size);
+
     // Step 1: Find a page with enough space
     LB_PagedArenaPage *page = arena->head;
     while(page != NULL) {
-        if(page->length + size <= page->capacity) {
+        if(page->length + lbPagedArenaPadding(page, alignment) + size <= page->capacity) {
             break;
         }
+        LB_STATS_ADD(arena_page_walk, 1);
         page = page->next;
     }
 
@@ -118,16 +142,21 @@ void * lbPagedArenaAlloc(LB_PagedArena *arena, const size_t size) {
         // Step 1.5:
         // If no page with enough space was found create a new
         // page with a multiple of the default page capacity that
-        // is greater than the requested size.
+        // is greater than the requested size, plus the worst case
+        // alignment padding.
         size_t new_capacity = arena->default_page_capacity;
-        while(new_capacity < size) {
+        while(new_capacity < size + alignment - 1) {
             new_capacity *= 2;
         }
 
+        LB_HISTOGRAM_BEGIN(page_start);
         page = lbPagedArenaPageNew(new_capacity);
+        LB_HISTOGRAM_END(LB_HISTOGRAM_ARENA_PAGE, page_start);
         if(page == NULL) {
             return NULL;
         }
+        LB_STATS_ADD(arena_pages, 1);
+        LB_PROBE1(arena_page, new_capacity);
 
         page->prev = arena->tail;
         arena->tail->next = page;
@@ -135,8 +164,9 @@ void * lbPagedArenaAlloc(LB_PagedArena *arena, const size_t size) {
     }
 
     // Step 2: Allocate the memory in the page
-    void *ptr = ((uint8_t*) page->data) + page->length;
-    page->length += size;
+    const size_t padding = lbPagedArenaPadding(page, alignment);
+    void *ptr = ((uint8_t*) page->data) + page->length + padding;
+    page->length += padding + size;
     return ptr;
 }
 
@@ -0,0 +1,94 @@
+#ifndef LB_PAGED_ARENA_HPP
+#define LB_PAGED_ARENA_HPP
+
+/*
+ * std::pmr::memory_resource backed by an LB_PagedArena.
+ *
+ * Allocation is monotonic: deallocate does nothing and all memory handed out is released at once by clear(), which
+ * keeps the arena's pages for reuse. This suits per-message containers that are built, encoded and dropped together:
+ *
+ *     lb::PagedArenaResource arena(64 * 1024);
+ *     std::pmr::vector<Order> orders(&arena);
+ *     std::pmr::string symbol("ABCD", &arena);
+ *     ...
+ *     arena.clear(); // after orders and symbol are gone
+ *
+ * Alignment requests are honored. Define LB_PAGED_ARENA_IMPLEMENTATION in exactly one translation unit.
+ */
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+#include "lb_paged_arena.h"
+
+namespace lb {
+
+class PagedArenaResource final : public std::pmr::memory_resource {
+public:
+    // Own a new arena whose pages hold at least `default_page_capacity` bytes.
+    explicit PagedArenaResource(const size_t default_page_capacity)
+        : arena_(lbPagedArenaNew(default_page_capacity)), owned_(true) {
+        if (arena_ == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    // Allocate from `arena` without taking ownership of it.
+    explicit PagedArenaResource(LB_PagedArena *arena) noexcept : arena_(arena), owned_(false) {
+    }
+
+    PagedArenaResource(const PagedArenaResource &) = delete;
+    PagedArenaResource &operator=(const PagedArenaResource &) = delete;
+
+    PagedArenaResource(PagedArenaResource &&other) noexcept
+        : arena_(std::exchange(other.arena_, nullptr)), owned_(std::exchange(other.owned_, false)) {
+    }
+
+    PagedArenaResource &operator=(PagedArenaResource &&other) noexcept {
+        std::swap(arena_, other.arena_);
+        std::swap(owned_, other.owned_);
+        return *this;
+    }
+
+    ~PagedArenaResource() override {
+        if (owned_) {
+            lbPagedArenaFree(arena_);
+        }
+    }
+
+    // Release everything allocated so far. Containers using this resource must already be destroyed.
+    void clear() noexcept {
+        lbPagedArenaClear(arena_);
+    }
+
+    LB_PagedArena *arena() const noexcept {
+        return arena_;
+    }
+
+protected:
+    void *do_allocate(const size_t bytes, const size_t alignment) override {
+        void *ptr = lbPagedArenaAllocAligned(arena_, bytes, alignment);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return ptr;
+    }
+
+    void do_deallocate(void *, size_t, size_t) override {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    LB_PagedArena *arena_;
+    bool owned_;
+};
+
+} // namespace lb
+
+#endif //LB_PAGED_ARENA_HPP
@@ -0,0 +1,66 @@
+#ifndef LB_PROBES_H
+#define LB_PROBES_H
+
+/*
+ * USDT (SystemTap style) static tracepoints, usable from bpftrace, perf and other tools that read .note.stapsdt:
+ *
+ *     bpftrace -e 'usdt:./app:lb_buffer:writer_grow { printf("%d -> %d\n", arg0, arg1); }'
+ *     perf buildid-cache --add ./app && perf record -e sdt_lb_buffer:file_write ./app
+ *
+ * A probe compiles to a single nop plus an ELF note recording its address and where its arguments live. Nothing
+ * else happens until a tracer patches the nop, so probes are on by default wherever they are supported: GCC or
+ * Clang targeting ELF on x86-64 or AArch64. Define LB_BUFFER_NO_PROBES to remove them entirely.
+ *
+ * This is a self-contained subset of <sys/sdt.h>. Every argument is passed as a u64 and there are no semaphores.
+ *
+ * Probes (provider lb_buffer):
+ *     writer_grow(old_capacity, new_capacity)
+ *     writer_seek(position)           reader_seek(position)
+ *     file_write(length, written)     file_read(length, read)       written and read are 1 on success, 0 otherwise
+ *     write_error(error, length)      read_error(error, length)     LB_WriterError / LB_ReaderError bits
+ *     arena_page(capacity)
+ */
+
+#if !defined(LB_BUFFER_NO_PROBES) && (defined(__GNUC__) || defined(__clang__)) && defined(__ELF__) && \
+    (defined(__x86_64__) || defined(__aarch64__))
+#define LB_PROBES_ENABLED
+
+#define LB_PROBE_PROVIDER "lb_buffer"
+
+// The note layout is the one described at https://sourceware.org/systemtap/wiki/UserSpaceProbeImplementation.
+#define LB_PROBE_ASM(name, arguments)                                                                               \
+    "990: nop\n"                                                                                                    \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                                                   \
+    ".balign 4\n"                                                                                                   \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                                                              \
+    "991: .asciz \"stapsdt\"\n"                                                                                     \
+    "992: .balign 4\n"                                                                                              \
+    "993: .8byte 990b\n"                                                                                            \
+    ".8byte _.stapsdt.base\n"                                                                                       \
+    ".8byte 0\n"                                                                                                    \
+    ".asciz \"" LB_PROBE_PROVIDER "\"\n"                                                                            \
+    ".asciz \"" name "\"\n"                                                                                         \
+    ".asciz \"" arguments "\"\n"                                                                                    \
+    "994: .balign 4\n"                                                                                              \
+    ".popsection\n"                                                                                                 \
+    ".ifndef _.stapsdt.base\n"                                                                                      \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"                                         \
+    ".weak _.stapsdt.base\n"                                                                                        \
+    ".hidden _.stapsdt.base\n"                                                                                      \
+    "_.stapsdt.base: .space 1\n"                                                                                    \
+    ".size _.stapsdt.base, 1\n"                                                                                     \
+    ".popsection\n"                                                                                                 \
+    ".endif\n"
+
+#define LB_PROBE1(name, a)                                                                                          \
+    __asm__ __volatile__(LB_PROBE_ASM(#name, "8@%0") : : "nor"((unsigned long long) (a)))
+#define LB_PROBE2(name, a, b)                                                                                       \
+    __asm__ __volatile__(LB_PROBE_ASM(#name, "8@%0 8@%1") : : "nor"((unsigned long long) (a)),                     \
+                         "nor"((unsigned long long) (b)))
+
+#else
+#define LB_PROBE1(name, a) ((void) 0)
+#define LB_PROBE2(name, a, b) ((void) 0)
+#endif
+
+#endif //LB_PROBES_H
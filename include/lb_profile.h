@@ -0,0 +1,319 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_PROFILE_H
+#define LB_PROFILE_H
+
+/*
+ * Debug profile of the lengths passed to lbWrite, lbWriteReversed, lbWritePrepend, lbRead and lbReadReversed, keyed
+ * by call site. Every typed read and write goes through one of these, so the profile shows which encoders issue
+ * many small operations and would benefit from bulk APIs or batching.
+ *
+ * Define LB_BUFFER_PROFILE for every translation unit to enable it, and LB_PROFILE_IMPLEMENTATION (implied by
+ * LB_BUFFER_IMPLEMENTATION) in exactly one. Without LB_BUFFER_PROFILE every hook expands to nothing.
+ *
+ * A call site is the code address the operation was issued from. In optimized builds the library's functions are
+ * inlined into their callers, so the address lands in your encoder: resolve it with `addr2line -i -f -e <binary>
+ * <offset>`, using the `binary(+offset)` printed next to it. Unoptimized builds attribute everything to the library's
+ * own functions; mark sites explicitly with LB_PROFILE_SITE(), which keys everything that thread does afterwards by
+ * file and line until LB_PROFILE_SITE_CLEAR().
+ *
+ * Every record takes a global lock. This is a debugging aid, not something to leave enabled.
+ */
+
+#ifdef LB_BUFFER_PROFILE
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstdio>
+#include <cstddef>
+extern "C" {
+#else
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#endif
+
+#ifndef LB_PROFILE_MAX_SITES
+#define LB_PROFILE_MAX_SITES 4096
+#endif
+
+// Lengths are bucketed by power of two: bucket 0 is 0, bucket n is [2^(n-1), 2^n), the last is everything above.
+#define LB_PROFILE_LENGTH_BUCKETS 18
+
+#ifdef __cplusplus
+#define LB_PROFILE_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define LB_PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define LB_PROFILE_THREAD_LOCAL _Thread_local
+#endif
+
+typedef enum LB_ProfileOp {
+    LB_PROFILE_OP_WRITE,
+    LB_PROFILE_OP_READ,
+    LB_PROFILE_OP_COUNT,
+} LB_ProfileOp;
+
+// An explicit call site, see LB_PROFILE_SITE.
+typedef struct LB_ProfileLabel {
+    const char *file;
+    int line;
+    const char *function;
+} LB_ProfileLabel;
+
+typedef struct LB_ProfileSite {
+    const void *address;
+    // Non-NULL if the site was marked with LB_PROFILE_SITE, `address` is then the label itself.
+    const LB_ProfileLabel *label;
+    LB_ProfileOp op;
+    uint64_t calls;
+    uint64_t bytes;
+    uint64_t lengths[LB_PROFILE_LENGTH_BUCKETS];
+} LB_ProfileSite;
+
+extern LB_PROFILE_THREAD_LOCAL const LB_ProfileLabel *lb_profile_label;
+
+// Record one operation of `length` bytes, keyed by the current label or else the caller's address.
+void lbProfileRecord(LB_ProfileOp op, size_t length);
+
+#define LB_PROFILE_RECORD(op, length) lbProfileRecord((op), (length))
+
+#define LB_PROFILE_SITE()                                                                                           \
+    do {                                                                                                            \
+        static const LB_ProfileLabel lb_profile_site_label = {__FILE__, __LINE__, __func__};                        \
+        lb_profile_label = &lb_profile_site_label;                                                                  \
+    } while (0)
+#define LB_PROFILE_SITE_CLEAR() (lb_profile_label = NULL)
+
+/**
+ * Copy every recorded site into `out_sites`. <br>
+ *
+ * @param capacity The number of elements `out_sites` can hold.
+ * @return The number of sites copied. Sites that did not fit in LB_PROFILE_MAX_SITES are merged into one entry with
+ *         a NULL address.
+ */
+size_t lbProfileSnapshot(LB_ProfileSite *out_sites, size_t capacity);
+
+void lbProfileReset(void);
+
+// Print the `top` sites by bytes and the `top` sites by calls, with their length distributions.
+void lbProfilePrint(FILE *file, size_t top);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+#define LB_PROFILE_RECORD(op, length) ((void) 0)
+#define LB_PROFILE_SITE() ((void) 0)
+#define LB_PROFILE_SITE_CLEAR() ((void) 0)
+#endif
+
+#endif //LB_PROFILE_H
+
+#if defined(LB_PROFILE_IMPLEMENTATION) && defined(LB_BUFFER_PROFILE) && !defined(LB_PROFILE_IMPLEMENTED)
+#define LB_PROFILE_IMPLEMENTED
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+#ifdef __GLIBC__
+#include <execinfo.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_ReturnAddress)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+LB_PROFILE_THREAD_LOCAL const LB_ProfileLabel *lb_profile_label = NULL;
+
+// Open addressing on the site address; slot LB_PROFILE_MAX_SITES collects whatever does not fit.
+static LB_ProfileSite lb_profile_sites[LB_PROFILE_MAX_SITES + 1];
+static volatile long lb_profile_lock = 0;
+
+static void lbProfileLock(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    while (__atomic_exchange_n(&lb_profile_lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&lb_profile_lock, __ATOMIC_RELAXED)) {
+        }
+    }
+#elif defined(_MSC_VER)
+    while (_InterlockedExchange(&lb_profile_lock, 1)) {
+        while (lb_profile_lock) {
+        }
+    }
+#else
+#error "LB_BUFFER_PROFILE needs GCC, Clang or MSVC atomics for its lock"
+#endif
+}
+
+static void lbProfileUnlock(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&lb_profile_lock, 0, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+    _InterlockedExchange(&lb_profile_lock, 0);
+#endif
+}
+
+static uint32_t lbProfileLengthBucket(size_t length) {
+    uint32_t bucket = 0;
+    while (length && bucket < LB_PROFILE_LENGTH_BUCKETS - 1) {
+        length >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static LB_ProfileSite *lbProfileFind(const void *address, const LB_ProfileOp op) {
+    size_t index = (((uintptr_t) address >> 2) * 0x9E3779B97F4A7C15ull + op) % LB_PROFILE_MAX_SITES;
+    for (size_t probe = 0; probe < LB_PROFILE_MAX_SITES; probe++) {
+        LB_ProfileSite *site = &lb_profile_sites[index];
+        if (site->calls == 0) {
+            site->address = address;
+            site->op = op;
+            return site;
+        }
+
+        if (site->address == address && site->op == op) {
+            return site;
+        }
+
+        index = (index + 1) % LB_PROFILE_MAX_SITES;
+    }
+
+    return &lb_profile_sites[LB_PROFILE_MAX_SITES];
+}
+
+// Not inlined, so that the return address is the call site in the caller.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#elif defined(_MSC_VER)
+__declspec(noinline)
+#endif
+void lbProfileRecord(const LB_ProfileOp op, const size_t length) {
+    const LB_ProfileLabel *label = lb_profile_label;
+#if defined(__GNUC__) || defined(__clang__)
+    const void *address = label ? (const void *) label : __builtin_return_address(0);
+#else
+    const void *address = label ? (const void *) label : _ReturnAddress();
+#endif
+
+    lbProfileLock();
+    LB_ProfileSite *site = lbProfileFind(address, op);
+    site->label = label;
+    site->calls++;
+    site->bytes += length;
+    site->lengths[lbProfileLengthBucket(length)]++;
+    lbProfileUnlock();
+}
+
+size_t lbProfileSnapshot(LB_ProfileSite *out_sites, const size_t capacity) {
+    size_t count = 0;
+    lbProfileLock();
+    for (size_t i = 0; i <= LB_PROFILE_MAX_SITES && count < capacity; i++) {
+        if (lb_profile_sites[i].calls) {
+            out_sites[count] = lb_profile_sites[i];
+            if (i == LB_PROFILE_MAX_SITES) {
+                out_sites[count].address = NULL;
+            }
+            count++;
+        }
+    }
+    lbProfileUnlock();
+    return count;
+}
+
+void lbProfileReset(void) {
+    lbProfileLock();
+    memset(lb_profile_sites, 0, sizeof(lb_profile_sites));
+    lbProfileUnlock();
+}
+
+static int lbProfileCompareBytes(const void *a, const void *b) {
+    const uint64_t x = ((const LB_ProfileSite *) a)->bytes;
+    const uint64_t y = ((const LB_ProfileSite *) b)->bytes;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static int lbProfileCompareCalls(const void *a, const void *b) {
+    const uint64_t x = ((const LB_ProfileSite *) a)->calls;
+    const uint64_t y = ((const LB_ProfileSite *) b)->calls;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void lbProfilePrintSite(FILE *file, const LB_ProfileSite *site) {
+    fprintf(file, "  %-5s %12llu calls %14llu bytes %10.1f mean  ", site->op == LB_PROFILE_OP_WRITE ? "write" : "read",
+            (unsigned long long) site->calls, (unsigned long long) site->bytes,
+            (double) site->bytes / (double) site->calls);
+
+    if (site->address == NULL) {
+        fprintf(file, "(other sites, table full)");
+    } else if (site->label) {
+        fprintf(file, "%s:%d (%s)", site->label->file, site->label->line, site->label->function);
+    } else {
+#ifdef __GLIBC__
+        void *address = (void *) site->address;
+        char **symbols = backtrace_symbols(&address, 1);
+        fprintf(file, "%s", symbols ? symbols[0] : "?");
+        free(symbols);
+#else
+        fprintf(file, "%p", site->address);
+#endif
+    }
+
+    fprintf(file, "\n        lengths");
+    for (uint32_t bucket = 0; bucket < LB_PROFILE_LENGTH_BUCKETS; bucket++) {
+        if (site->lengths[bucket] == 0) {
+            continue;
+        }
+
+        const double share = 100.0 * (double) site->lengths[bucket] / (double) site->calls;
+        if (bucket == 0) {
+            fprintf(file, " 0:%.1f%%", share);
+        } else if (bucket == LB_PROFILE_LENGTH_BUCKETS - 1) {
+            fprintf(file, " %zu+:%.1f%%", (size_t) 1 << (bucket - 1), share);
+        } else if (bucket == 1) {
+            fprintf(file, " 1:%.1f%%", share);
+        } else {
+            fprintf(file, " %zu-%zu:%.1f%%", (size_t) 1 << (bucket - 1), ((size_t) 1 << bucket) - 1, share);
+        }
+    }
+    fprintf(file, "\n");
+}
+
+void lbProfilePrint(FILE *file, const size_t top) {
+    LB_ProfileSite *sites = (LB_ProfileSite *) malloc((LB_PROFILE_MAX_SITES + 1) * sizeof(LB_ProfileSite));
+    if (sites == NULL) {
+        return;
+    }
+
+    const size_t count = lbProfileSnapshot(sites, LB_PROFILE_MAX_SITES + 1);
+    const size_t shown = count < top ? count : top;
+
+    qsort(sites, count, sizeof(LB_ProfileSite), lbProfileCompareBytes);
+    fprintf(file, "Top %zu of %zu call sites by bytes:\n", shown, count);
+    for (size_t i = 0; i < shown; i++) {
+        lbProfilePrintSite(file, &sites[i]);
+    }
+
+    qsort(sites, count, sizeof(LB_ProfileSite), lbProfileCompareCalls);
+    fprintf(file, "Top %zu of %zu call sites by calls:\n", shown, count);
+    for (size_t i = 0; i < shown; i++) {
+        lbProfilePrintSite(file, &sites[i]);
+    }
+
+    free(sites);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_PROFILE_IMPLEMENTATION
@@ -0,0 +1,388 @@
+#ifndef LB_QUANTIZE_H
+#define LB_QUANTIZE_H
+
+#include "lb_bit_writer.h"
+#include "lb_bit_reader.h"
+#include "lb_cpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Error codes for initializing a LB_Quantizer.
+typedef enum LB_QuantizerInitError {
+    // No error.
+    LB_QUANTIZER_INIT_NONE = 0x0,
+    // The quantizer is NULL.
+    LB_QUANTIZER_INIT_NO_QUANTIZER = 0x1,
+    // The range is empty, inverted or not finite.
+    LB_QUANTIZER_INIT_INVALID_RANGE = 0x2,
+    // The bit count is zero or greater than 32.
+    LB_QUANTIZER_INIT_INVALID_BITS = 0x4,
+} LB_QuantizerInitError;
+
+#ifdef __cplusplus
+// A bit flag enum, see lb_writer.h.
+extern "C++" {
+LB_INLINE LB_QuantizerInitError operator|(const LB_QuantizerInitError a, const LB_QuantizerInitError b) {
+    return (LB_QuantizerInitError) ((int) a | (int) b);
+}
+
+LB_INLINE LB_QuantizerInitError &operator|=(LB_QuantizerInitError &a, const LB_QuantizerInitError b) {
+    return a = a | b;
+}
+}
+#endif
+
+LB_INLINE const char* lbQuantizerInitErrorName(const LB_QuantizerInitError e) {
+    switch (e) {
+        case LB_QUANTIZER_INIT_NONE:
+            return "LB_QUANTIZER_INIT_NONE";
+        case LB_QUANTIZER_INIT_NO_QUANTIZER:
+            return "LB_QUANTIZER_INIT_NO_QUANTIZER";
+        case LB_QUANTIZER_INIT_INVALID_RANGE:
+            return "LB_QUANTIZER_INIT_INVALID_RANGE";
+        case LB_QUANTIZER_INIT_INVALID_BITS:
+            return "LB_QUANTIZER_INIT_INVALID_BITS";
+        default:
+            return "LB_QUANTIZER_INIT_UNKNOWN";
+    }
+}
+
+LB_INLINE const char* lbQuantizerInitErrorMessage(const LB_QuantizerInitError e) {
+    switch (e) {
+        case LB_QUANTIZER_INIT_NONE:
+            return "No error.";
+        case LB_QUANTIZER_INIT_NO_QUANTIZER:
+            return "The quantizer is NULL.";
+        case LB_QUANTIZER_INIT_INVALID_RANGE:
+            return "The range is empty, inverted or not finite.";
+        case LB_QUANTIZER_INIT_INVALID_BITS:
+            return "The bit count is zero or greater than 32.";
+        default:
+            return "Unknown error.";
+    }
+}
+
+// Maps [min, max] onto the integers [0, 2^bits - 1]. Both ends of the range are exact.
+// lbQuantizerInitHalfOpen maps [min, max) instead.
+typedef struct LB_Quantizer {
+    double min;
+    double max;
+    // Codes per unit, `max_code / (max - min)`.
+    double scale;
+    // Units per code, `(max - min) / max_code`.
+    double step;
+    uint32_t max_code;
+    uint32_t bits;
+    // Nonzero if `max` is excluded from the range, see lbQuantizerInitHalfOpen.
+    uint32_t half_open;
+} LB_Quantizer;
+
+/**
+ * Initialize a LB_Quantizer for the range [min, max] at the given bit width.
+ *
+ * @param quantizer A pointer to the LB_Quantizer to be initialized.
+ * @param min The smallest representable value.
+ * @param max The largest representable value, must be greater than `min`.
+ * @param bits The number of bits per value, between 1 and 32.
+ * @return LB_QuantizerInitError An error code indicating the result of the initialization.
+ */
+LB_INLINE LB_QuantizerInitError lbQuantizerInit(LB_Quantizer *quantizer, const double min, const double max, const uint32_t bits) {
+    LB_QuantizerInitError e = LB_QUANTIZER_INIT_NONE;
+    if (quantizer == NULL) {
+        e |= LB_QUANTIZER_INIT_NO_QUANTIZER;
+    }
+
+    // Written so that NaN fails the check.
+    if (!(max > min) || !(max - min < 1e300)) {
+        e |= LB_QUANTIZER_INIT_INVALID_RANGE;
+    }
+
+    if (bits == 0 || bits > 32) {
+        e |= LB_QUANTIZER_INIT_INVALID_BITS;
+    }
+
+    if (e) {
+        return e;
+    }
+
+    const uint32_t max_code = (uint32_t) (((uint64_t) 1 << bits) - 1);
+    *quantizer = (LB_Quantizer) {
+        .min = min,
+        .max = max,
+        .scale = (double) max_code / (max - min),
+        .step = (max - min) / (double) max_code,
+        .max_code = max_code,
+        .bits = bits,
+        .half_open = 0,
+    };
+    return LB_QUANTIZER_INIT_NONE;
+}
+
+/**
+ * Initialize a LB_Quantizer for the half-open range [min, max), cut into 2^bits steps of `(max - min) / 2^bits`. <br>
+ * Values up to, but excluding, `max` are accepted. Those above the last code, `max - step`, are clamped to it. In
+ * exchange a power of two range divides evenly: [-4096, 4096) at 1/64 fits in 19 bits, where [-4096, 4096] needs 20.
+ */
+LB_INLINE LB_QuantizerInitError lbQuantizerInitHalfOpen(LB_Quantizer *quantizer, const double min, const double max, const uint32_t bits) {
+    const LB_QuantizerInitError e = lbQuantizerInit(quantizer, min, max, bits);
+    if (e) {
+        return e;
+    }
+
+    const double codes = (double) ((uint64_t) 1 << bits);
+    quantizer->scale = codes / (max - min);
+    quantizer->step = (max - min) / codes;
+    quantizer->half_open = 1;
+    return LB_QUANTIZER_INIT_NONE;
+}
+
+/**
+ * Initialize a LB_Quantizer with the smallest bit width whose step is at most `resolution`.  <br>
+ * E.g. [-4096, 4096] at a resolution of 1/64 needs 20 bits: both ends are included, so the range holds 2^19 + 1
+ * multiples of 1/64. lbQuantizerInitHalfOpen fits [-4096, 4096) in 19.
+ */
+LB_INLINE LB_QuantizerInitError lbQuantizerInitResolution(LB_Quantizer *quantizer, const double min, const double max, const double resolution) {
+    if (!(resolution > 0.0)) {
+        return LB_QUANTIZER_INIT_INVALID_RANGE;
+    }
+
+    const double steps = (max - min) / resolution;
+    uint32_t bits = 1;
+    while (bits < 32 && (double) (((uint64_t) 1 << bits) - 1) < steps) {
+        bits++;
+    }
+
+    return lbQuantizerInit(quantizer, min, max, bits);
+}
+
+// Values outside the range are clamped, NaN maps to `min`.
+LB_INLINE uint32_t lbQuantize(const LB_Quantizer *quantizer, const double value) {
+    const double scaled = (value - quantizer->min) * quantizer->scale + 0.5;
+    if (!(scaled >= 0.5)) {
+        return 0;
+    }
+
+    if (scaled >= (double) quantizer->max_code) {
+        return quantizer->max_code;
+    }
+
+    return (uint32_t) scaled;
+}
+
+LB_INLINE double lbDequantize(const LB_Quantizer *quantizer, const uint32_t code) {
+    // The top code is exactly `max` for closed ranges, half-open ranges stop one step short of it.
+    if (code >= quantizer->max_code) {
+        return quantizer->half_open ? quantizer->min + (double) quantizer->max_code * quantizer->step : quantizer->max;
+    }
+
+    return quantizer->min + (double) code * quantizer->step;
+}
+
+#ifdef LB_WRITER_SAFETY
+#define LB_WRITER_QUANTIZED_SAFETY \
+    if (!(value >= quantizer->min && (quantizer->half_open ? value < quantizer->max : value <= quantizer->max))) { \
+        return LB_WRITER_ERROR_INVALID_VALUE; \
+    }
+#else
+#define LB_WRITER_QUANTIZED_SAFETY
+#endif
+
+LB_INLINE LB_WriterError lbWriteQuantizer(LB_BitWriter *bit_writer, const LB_Quantizer *quantizer, const double value) {
+    LB_WRITER_QUANTIZED_SAFETY
+    return lbWriteBits(bit_writer, lbQuantize(quantizer, value), quantizer->bits);
+}
+
+LB_INLINE double lbReadQuantizer(LB_BitReader *bit_reader, const LB_Quantizer *quantizer, LB_ReaderError *out_error) {
+    return lbDequantize(quantizer, (uint32_t) lbReadBits(bit_reader, quantizer->bits, out_error));
+}
+
+/**
+ * Write `value` from the range [min, max] in `bits` bits.                         <br>
+ * Prefer `lbWriteQuantizer` with a LB_Quantizer when the same range is used repeatedly.
+ *
+ * @return LB_WRITER_ERROR_INVALID_VALUE if the range, bit count or value is invalid and LB_WRITER_SAFETY.
+ */
+LB_INLINE LB_WriterError lbWriteQuantized(LB_BitWriter *bit_writer, const double value, const double min, const double max, const uint32_t bits) {
+    LB_Quantizer quantizer;
+    if (lbQuantizerInit(&quantizer, min, max, bits)) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+    return lbWriteQuantizer(bit_writer, &quantizer, value);
+}
+
+LB_INLINE double lbReadQuantized(LB_BitReader *bit_reader, const double min, const double max, const uint32_t bits, LB_ReaderError *out_error) {
+    LB_Quantizer quantizer;
+    if (lbQuantizerInit(&quantizer, min, max, bits)) {
+#ifdef LB_READER_SAFETY
+        if (out_error != NULL) {
+            *out_error = LB_READER_ERROR_INVALID_VALUE;
+        }
+#endif
+        return 0.0;
+    }
+
+    return lbReadQuantizer(bit_reader, &quantizer, out_error);
+}
+
+/*
+ * Array Functions
+ */
+
+// Number of values quantized per batch, so the conversion loop can be vectorized.
+#define LB_QUANTIZE_BATCH 64
+
+// Dispatched to the best kernel for this CPU, see lb_cpu.h.
+LB_INLINE void lbQuantizeF32Array(const LB_Quantizer *quantizer, const float *values, uint32_t *out_codes, const size_t count) {
+    // Computed in double so that widths above 24 bits stay exact.
+    lbCpuKernels()->quantize_f32(values, out_codes, count, quantizer->min, quantizer->scale, quantizer->max_code);
+}
+
+LB_INLINE void lbDequantizeF32Array(const LB_Quantizer *quantizer, const uint32_t *codes, float *out_values, const size_t count) {
+    lbCpuKernels()->dequantize_f32(codes, out_values, count, quantizer->min, quantizer->step);
+}
+
+LB_INLINE LB_WriterError lbWriteQuantizerF32Array(LB_BitWriter *bit_writer, const LB_Quantizer *quantizer, const float *values, const size_t count) {
+    uint32_t codes[LB_QUANTIZE_BATCH];
+    for (size_t offset = 0; offset < count; offset += LB_QUANTIZE_BATCH) {
+        const size_t batch = count - offset < LB_QUANTIZE_BATCH ? count - offset : LB_QUANTIZE_BATCH;
+#ifdef LB_WRITER_SAFETY
+        for (size_t i = 0; i < batch; i++) {
+            const float value = values[offset + i];
+            LB_WRITER_QUANTIZED_SAFETY
+        }
+#endif
+
+        lbQuantizeF32Array(quantizer, values + offset, codes, batch);
+        for (size_t i = 0; i < batch; i++) {
+            const LB_WriterError e = lbWriteBits(bit_writer, codes[i], quantizer->bits);
+            if (e) {
+                return e;
+            }
+        }
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
+
+LB_INLINE LB_ReaderError lbReadQuantizerF32Array(LB_BitReader *bit_reader, const LB_Quantizer *quantizer, float *out_values, const size_t count) {
+    uint32_t codes[LB_QUANTIZE_BATCH];
+    for (size_t offset = 0; offset < count; offset += LB_QUANTIZE_BATCH) {
+        const size_t batch = count - offset < LB_QUANTIZE_BATCH ? count - offset : LB_QUANTIZE_BATCH;
+        for (size_t i = 0; i < batch; i++) {
+            LB_ReaderError e = LB_READER_ERROR_NONE;
+            codes[i] = (uint32_t) lbReadBits(bit_reader, quantizer->bits, &e);
+            if (e) {
+                return e;
+            }
+        }
+
+        lbDequantizeF32Array(quantizer, codes, out_values + offset, batch);
+    }
+
+    return LB_READER_ERROR_NONE;
+}
+
+LB_INLINE LB_WriterError lbWriteQuantizedF32Array(LB_BitWriter *bit_writer, const float *values, const size_t count, const double min, const double max, const uint32_t bits) {
+    LB_Quantizer quantizer;
+    if (lbQuantizerInit(&quantizer, min, max, bits)) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+    return lbWriteQuantizerF32Array(bit_writer, &quantizer, values, count);
+}
+
+LB_INLINE LB_ReaderError lbReadQuantizedF32Array(LB_BitReader *bit_reader, float *out_values, const size_t count, const double min, const double max, const uint32_t bits) {
+    LB_Quantizer quantizer;
+    if (lbQuantizerInit(&quantizer, min, max, bits)) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    return lbReadQuantizerF32Array(bit_reader, &quantizer, out_values, count);
+}
+
+// Quantize one float field of an array of structs: the values at base, base + stride, base + 2 * stride...
+LB_INLINE LB_WriterError lbWriteQuantizerStridedF32(LB_BitWriter *bit_writer, const LB_Quantizer *quantizer, const float *base, const size_t stride, const size_t count) {
+    float values[LB_QUANTIZE_BATCH];
+    for (size_t offset = 0; offset < count; offset += LB_QUANTIZE_BATCH) {
+        const size_t batch = count - offset < LB_QUANTIZE_BATCH ? count - offset : LB_QUANTIZE_BATCH;
+        lbCpuKernels()->gather_32((const uint8_t *) base + offset * stride, stride, values, batch, 0);
+        const LB_WriterError e = lbWriteQuantizerF32Array(bit_writer, quantizer, values, batch);
+        if (e) {
+            return e;
+        }
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
+
+LB_INLINE LB_ReaderError lbReadQuantizerStridedF32(LB_BitReader *bit_reader, const LB_Quantizer *quantizer, float *base, const size_t stride, const size_t count) {
+    float values[LB_QUANTIZE_BATCH];
+    for (size_t offset = 0; offset < count; offset += LB_QUANTIZE_BATCH) {
+        const size_t batch = count - offset < LB_QUANTIZE_BATCH ? count - offset : LB_QUANTIZE_BATCH;
+        const LB_ReaderError e = lbReadQuantizerF32Array(bit_reader, quantizer, values, batch);
+        if (e) {
+            return e;
+        }
+        lbCpuKernels()->scatter_32(values, (uint8_t *) base + offset * stride, stride, batch, 0);
+    }
+
+    return LB_READER_ERROR_NONE;
+}
+
+LB_INLINE LB_WriterError lbWriteQuantizedStridedF32(LB_BitWriter *bit_writer, const float *base, const size_t stride, const size_t count, const double min, const double max, const uint32_t bits) {
+    LB_Quantizer quantizer;
+    if (lbQuantizerInit(&quantizer, min, max, bits)) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+    return lbWriteQuantizerStridedF32(bit_writer, &quantizer, base, stride, count);
+}
+
+LB_INLINE LB_ReaderError lbReadQuantizedStridedF32(LB_BitReader *bit_reader, float *base, const size_t stride, const size_t count, const double min, const double max, const uint32_t bits) {
+    LB_Quantizer quantizer;
+    if (lbQuantizerInit(&quantizer, min, max, bits)) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    return lbReadQuantizerStridedF32(bit_reader, &quantizer, base, stride, count);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif //LB_QUANTIZE_H
+
+#if defined(LB_QUANTIZE_IMPLEMENTATION) && !defined(LB_BUFFER_STATIC)
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* lbQuantizerInitErrorName(LB_QuantizerInitError e);
+const char* lbQuantizerInitErrorMessage(LB_QuantizerInitError e);
+LB_QuantizerInitError lbQuantizerInit(LB_Quantizer *quantizer, double min, double max, uint32_t bits);
+LB_QuantizerInitError lbQuantizerInitHalfOpen(LB_Quantizer *quantizer, double min, double max, uint32_t bits);
+LB_QuantizerInitError lbQuantizerInitResolution(LB_Quantizer *quantizer, double min, double max, double resolution);
+uint32_t lbQuantize(const LB_Quantizer *quantizer, double value);
+double lbDequantize(const LB_Quantizer *quantizer, uint32_t code);
+LB_WriterError lbWriteQuantizer(LB_BitWriter *bit_writer, const LB_Quantizer *quantizer, double value);
+double lbReadQuantizer(LB_BitReader *bit_reader, const LB_Quantizer *quantizer, LB_ReaderError *out_error);
+LB_WriterError lbWriteQuantized(LB_BitWriter *bit_writer, double value, double min, double max, uint32_t bits);
+double lbReadQuantized(LB_BitReader *bit_reader, double min, double max, uint32_t bits, LB_ReaderError *out_error);
+void lbQuantizeF32Array(const LB_Quantizer *quantizer, const float *values, uint32_t *out_codes, size_t count);
+void lbDequantizeF32Array(const LB_Quantizer *quantizer, const uint32_t *codes, float *out_values, size_t count);
+LB_WriterError lbWriteQuantizerF32Array(LB_BitWriter *bit_writer, const LB_Quantizer *quantizer, const float *values, size_t count);
+LB_ReaderError lbReadQuantizerF32Array(LB_BitReader *bit_reader, const LB_Quantizer *quantizer, float *out_values, size_t count);
+LB_WriterError lbWriteQuantizedF32Array(LB_BitWriter *bit_writer, const float *values, size_t count, double min, double max, uint32_t bits);
+LB_ReaderError lbReadQuantizedF32Array(LB_BitReader *bit_reader, float *out_values, size_t count, double min, double max, uint32_t bits);
+LB_WriterError lbWriteQuantizerStridedF32(LB_BitWriter *bit_writer, const LB_Quantizer *quantizer, const float *base, size_t stride, size_t count);
+LB_ReaderError lbReadQuantizerStridedF32(LB_BitReader *bit_reader, const LB_Quantizer *quantizer, float *base, size_t stride, size_t count);
+LB_WriterError lbWriteQuantizedStridedF32(LB_BitWriter *bit_writer, const float *base, size_t stride, size_t count, double min, double max, uint32_t bits);
+LB_ReaderError lbReadQuantizedStridedF32(LB_BitReader *bit_reader, float *base, size_t stride, size_t count, double min, double max, uint32_t bits);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //LB_QUANTIZE_IMPLEMENTATION
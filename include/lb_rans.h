@@ -0,0 +1,570 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_RANS_H
+#define LB_RANS_H
+
+#include "lb_writer.h"
+#include "lb_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Interleaved rANS entropy coder for streams of byte-sized symbols, such as the output of
+ * `lbQuantize` for narrow quantizers or of a LB_BitWriter.
+ *
+ * Symbol `i` is coded by state `i % LB_RANS_LANES`. All states share one byte stream, but
+ * their decode steps are independent, so the decoder can work on every lane at once.
+ *
+ * An encoded stream is written as:
+ *   u32 symbol_count   (little endian)
+ *   u32 byte_count     (little endian)
+ *   u8  bytes[byte_count]
+ */
+#define LB_RANS_LANES 4
+#define LB_RANS_LOWER_BOUND (1u << 23)
+#define LB_RANS_MAX_SYMBOLS 256
+#define LB_RANS_MAX_SCALE_BITS 14
+#define LB_RANS_DEFAULT_SCALE_BITS 12
+
+// Error codes for initializing a LB_RansTable.
+typedef enum LB_RansInitError {
+    // No error.
+    LB_RANS_INIT_NONE = 0x0,
+    // The table is NULL.
+    LB_RANS_INIT_NO_TABLE = 0x1,
+    // The scale bits are zero or greater than LB_RANS_MAX_SCALE_BITS.
+    LB_RANS_INIT_INVALID_SCALE_BITS = 0x2,
+    // The symbol count is zero or greater than LB_RANS_MAX_SYMBOLS.
+    LB_RANS_INIT_INVALID_SYMBOL_COUNT = 0x4,
+    // More symbols occur than fit into the scale, or none occur at all.
+    LB_RANS_INIT_INVALID_COUNTS = 0x8,
+} LB_RansInitError;
+
+#ifdef __cplusplus
+// A bit flag enum, see lb_writer.h.
+extern "C++" {
+inline LB_RansInitError operator|(const LB_RansInitError a, const LB_RansInitError b) {
+    return (LB_RansInitError) ((int) a | (int) b);
+}
+
+inline LB_RansInitError &operator|=(LB_RansInitError &a, const LB_RansInitError b) {
+    return a = a | b;
+}
+}
+#endif
+
+const char* lbRansInitErrorName(LB_RansInitError e);
+const char* lbRansInitErrorMessage(LB_RansInitError e);
+
+// Symbol frequencies normalized so that they add up to `1 << scale_bits`.
+typedef struct LB_RansTable {
+    uint32_t scale_bits;
+    uint32_t symbol_count;
+    uint32_t frequencies[LB_RANS_MAX_SYMBOLS];
+    uint32_t cumulative[LB_RANS_MAX_SYMBOLS + 1];
+    // Maps every slot in [0, 1 << scale_bits) to its symbol, for decoding.
+    uint8_t slots[1 << LB_RANS_MAX_SCALE_BITS];
+} LB_RansTable;
+
+/**
+ * Initialize a static LB_RansTable from symbol occurrence counts.                       <br>
+ * Every symbol with a non-zero count is guaranteed to be encodable.
+ *
+ * @param counts The number of occurrences of each symbol in [0, symbol_count).
+ * @param symbol_count The size of the alphabet, between 1 and LB_RANS_MAX_SYMBOLS.
+ * @param scale_bits The precision of the frequencies, between 1 and LB_RANS_MAX_SCALE_BITS.
+ */
+LB_RansInitError lbRansTableInit(LB_RansTable *table, const uint32_t *counts, uint32_t symbol_count, uint32_t scale_bits);
+
+// Initialize a static LB_RansTable from the symbols that will be encoded with it.
+LB_RansInitError lbRansTableInitFromSymbols(LB_RansTable *table, const uint8_t *symbols, size_t count, uint32_t symbol_count, uint32_t scale_bits);
+
+// Write the normalized frequencies so that a decoder can rebuild the table with `lbRansReadTable`.
+LB_WriterError lbRansWriteTable(LB_Writer *writer, const LB_RansTable *table);
+LB_ReaderError lbRansReadTable(LB_Reader *reader, LB_RansTable *table);
+
+/**
+ * Encode `count` symbols with a static table.
+ *
+ * @return LB_WRITER_ERROR_INVALID_VALUE if a symbol has no frequency in the table, or
+ * LB_WRITER_ERROR_FULL if the scratch buffer could not be allocated.
+ */
+LB_WriterError lbRansEncode(LB_Writer *writer, const LB_RansTable *table, const uint8_t *symbols, size_t count);
+
+/**
+ * Decode a stream written by `lbRansEncode` with the same table.                               <br>
+ * Buffer-mode readers are decoded in place, other modes are read into a scratch buffer first.
+ *
+ * @param out_symbols Receives the symbols, must hold at least `capacity` symbols.
+ * @param out_count Receives the number of decoded symbols, may be NULL.
+ * @return LB_READER_ERROR_INVALID_VALUE if the stream holds more than `capacity` symbols or is corrupt.
+ */
+LB_ReaderError lbRansDecode(LB_Reader *reader, const LB_RansTable *table, uint8_t *out_symbols, size_t capacity, size_t *out_count);
+
+/**
+ * Encode with tables that adapt to the data. The symbols are split into blocks of `block_size`, and
+ * each block is coded with a table built from the counts of all blocks before it, so no table has
+ * to be stored. Older counts are halved over time so the model follows drifting statistics.
+ */
+LB_WriterError lbRansEncodeAdaptive(LB_Writer *writer, const uint8_t *symbols, size_t count, uint32_t symbol_count, uint32_t scale_bits, uint32_t block_size);
+LB_ReaderError lbRansDecodeAdaptive(LB_Reader *reader, uint8_t *out_symbols, size_t capacity, size_t *out_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_RANS_H
+
+#ifdef LB_RANS_IMPLEMENTATION
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* lbRansInitErrorName(const LB_RansInitError e) {
+    switch (e) {
+        case LB_RANS_INIT_NONE:
+            return "LB_RANS_INIT_NONE";
+        case LB_RANS_INIT_NO_TABLE:
+            return "LB_RANS_INIT_NO_TABLE";
+        case LB_RANS_INIT_INVALID_SCALE_BITS:
+            return "LB_RANS_INIT_INVALID_SCALE_BITS";
+        case LB_RANS_INIT_INVALID_SYMBOL_COUNT:
+            return "LB_RANS_INIT_INVALID_SYMBOL_COUNT";
+        case LB_RANS_INIT_INVALID_COUNTS:
+            return "LB_RANS_INIT_INVALID_COUNTS";
+        default:
+            return "LB_RANS_INIT_UNKNOWN";
+    }
+}
+
+const char* lbRansInitErrorMessage(const LB_RansInitError e) {
+    switch (e) {
+        case LB_RANS_INIT_NONE:
+            return "No error.";
+        case LB_RANS_INIT_NO_TABLE:
+            return "The table is NULL.";
+        case LB_RANS_INIT_INVALID_SCALE_BITS:
+            return "The scale bits are zero or greater than LB_RANS_MAX_SCALE_BITS.";
+        case LB_RANS_INIT_INVALID_SYMBOL_COUNT:
+            return "The symbol count is zero or greater than LB_RANS_MAX_SYMBOLS.";
+        case LB_RANS_INIT_INVALID_COUNTS:
+            return "More symbols occur than fit into the scale, or none occur at all.";
+        default:
+            return "Unknown error.";
+    }
+}
+
+static void lbRansTableBuildSlots(LB_RansTable *table) {
+    table->cumulative[0] = 0;
+    for (uint32_t s = 0; s < LB_RANS_MAX_SYMBOLS; s++) {
+        table->cumulative[s + 1] = table->cumulative[s] + table->frequencies[s];
+        for (uint32_t slot = table->cumulative[s]; slot < table->cumulative[s + 1]; slot++) {
+            table->slots[slot] = (uint8_t) s;
+        }
+    }
+}
+
+LB_RansInitError lbRansTableInit(LB_RansTable *table, const uint32_t *counts, const uint32_t symbol_count, const uint32_t scale_bits) {
+    LB_RansInitError e = LB_RANS_INIT_NONE;
+    if (table == NULL) {
+        e |= LB_RANS_INIT_NO_TABLE;
+    }
+
+    if (scale_bits == 0 || scale_bits > LB_RANS_MAX_SCALE_BITS) {
+        e |= LB_RANS_INIT_INVALID_SCALE_BITS;
+    }
+
+    if (symbol_count == 0 || symbol_count > LB_RANS_MAX_SYMBOLS) {
+        e |= LB_RANS_INIT_INVALID_SYMBOL_COUNT;
+    }
+
+    if (e) {
+        return e;
+    }
+
+    const uint32_t total = 1u << scale_bits;
+    uint64_t sum = 0;
+    uint32_t used = 0;
+    for (uint32_t s = 0; s < symbol_count; s++) {
+        sum += counts[s];
+        used += counts[s] != 0;
+    }
+
+    if (sum == 0 || used > total) {
+        return LB_RANS_INIT_INVALID_COUNTS;
+    }
+
+    // Scale the counts, keeping every occurring symbol at a frequency of at least 1.
+    memset(table->frequencies, 0, sizeof(table->frequencies));
+    uint32_t scaled_sum = 0;
+    uint32_t largest = 0;
+    for (uint32_t s = 0; s < symbol_count; s++) {
+        if (counts[s] == 0) {
+            continue;
+        }
+
+        uint32_t frequency = (uint32_t) (((uint64_t) counts[s] * total) / sum);
+        frequency = frequency ? frequency : 1;
+        table->frequencies[s] = frequency;
+        scaled_sum += frequency;
+        if (frequency > table->frequencies[largest]) {
+            largest = s;
+        }
+    }
+
+    // Rounding leaves the sum slightly off, settle the difference on the largest frequencies.
+    if (scaled_sum < total) {
+        table->frequencies[largest] += total - scaled_sum;
+        scaled_sum = total;
+    }
+
+    while (scaled_sum > total) {
+        uint32_t best = 0;
+        for (uint32_t s = 0; s < symbol_count; s++) {
+            if (table->frequencies[s] > table->frequencies[best]) {
+                best = s;
+            }
+        }
+
+        const uint32_t excess = scaled_sum - total;
+        const uint32_t take = table->frequencies[best] - 1 < excess ? table->frequencies[best] - 1 : excess;
+        table->frequencies[best] -= take;
+        scaled_sum -= take;
+    }
+
+    table->scale_bits = scale_bits;
+    table->symbol_count = symbol_count;
+    lbRansTableBuildSlots(table);
+    return LB_RANS_INIT_NONE;
+}
+
+LB_RansInitError lbRansTableInitFromSymbols(LB_RansTable *table, const uint8_t *symbols, const size_t count, const uint32_t symbol_count, const uint32_t scale_bits) {
+    uint32_t counts[LB_RANS_MAX_SYMBOLS] = {0};
+    for (size_t i = 0; i < count; i++) {
+        counts[symbols[i]]++;
+    }
+
+    return lbRansTableInit(table, counts, symbol_count, scale_bits);
+}
+
+LB_WriterError lbRansWriteTable(LB_Writer *writer, const LB_RansTable *table) {
+    LB_WriterError e = lbWriteU8(writer, (uint8_t) table->scale_bits);
+    e |= lbWriteU16LE(writer, (uint16_t) table->symbol_count);
+    for (uint32_t s = 0; s < table->symbol_count && !e; s++) {
+        e |= lbWriteU16LE(writer, (uint16_t) table->frequencies[s]);
+    }
+
+    return e;
+}
+
+LB_ReaderError lbRansReadTable(LB_Reader *reader, LB_RansTable *table) {
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    const uint32_t scale_bits = lbReadU8(reader, &e);
+    if (e) {
+        return e;
+    }
+
+    const uint32_t symbol_count = lbReadU16LE(reader, &e);
+    if (e) {
+        return e;
+    }
+
+    if (scale_bits == 0 || scale_bits > LB_RANS_MAX_SCALE_BITS || symbol_count == 0 || symbol_count > LB_RANS_MAX_SYMBOLS) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    memset(table->frequencies, 0, sizeof(table->frequencies));
+    uint32_t sum = 0;
+    for (uint32_t s = 0; s < symbol_count; s++) {
+        table->frequencies[s] = lbReadU16LE(reader, &e);
+        if (e) {
+            return e;
+        }
+
+        sum += table->frequencies[s];
+    }
+
+    if (sum != 1u << scale_bits) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    table->scale_bits = scale_bits;
+    table->symbol_count = symbol_count;
+    lbRansTableBuildSlots(table);
+    return LB_READER_ERROR_NONE;
+}
+
+LB_WriterError lbRansEncode(LB_Writer *writer, const LB_RansTable *table, const uint8_t *symbols, const size_t count) {
+    if (count > UINT32_MAX) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+    // With at most LB_RANS_MAX_SCALE_BITS of precision a symbol never emits more than 2 bytes.
+    const size_t capacity = count * 2 + LB_RANS_LANES * sizeof(uint32_t);
+    uint8_t *scratch = (uint8_t *) malloc(capacity);
+    if (scratch == NULL) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    const uint32_t scale_bits = table->scale_bits;
+    uint32_t states[LB_RANS_LANES];
+    for (size_t lane = 0; lane < LB_RANS_LANES; lane++) {
+        states[lane] = LB_RANS_LOWER_BOUND;
+    }
+
+    // rANS is last in, first out, so encode backwards into a buffer that is filled from its end.
+    uint8_t *end = scratch + capacity;
+    uint8_t *ptr = end;
+    for (size_t i = count; i-- > 0;) {
+        const uint8_t symbol = symbols[i];
+        const uint32_t frequency = table->frequencies[symbol];
+        if (frequency == 0) {
+            free(scratch);
+            return LB_WRITER_ERROR_INVALID_VALUE;
+        }
+
+        uint32_t x = states[i % LB_RANS_LANES];
+        const uint32_t x_max = ((LB_RANS_LOWER_BOUND >> scale_bits) << 8) * frequency;
+        while (x >= x_max) {
+            *--ptr = (uint8_t) x;
+            x >>= 8;
+        }
+
+        states[i % LB_RANS_LANES] = ((x / frequency) << scale_bits) + (x % frequency) + table->cumulative[symbol];
+    }
+
+    for (size_t lane = LB_RANS_LANES; lane-- > 0;) {
+        ptr -= sizeof(uint32_t);
+        for (size_t b = 0; b < sizeof(uint32_t); b++) {
+            ptr[b] = (uint8_t) (states[lane] >> (b * 8));
+        }
+    }
+
+    const size_t byte_count = (size_t) (end - ptr);
+    LB_WriterError e = lbWriteU32LE(writer, (uint32_t) count);
+    e |= lbWriteU32LE(writer, (uint32_t) byte_count);
+    if (!e) {
+        e |= lbWrite(writer, ptr, byte_count);
+    }
+
+    free(scratch);
+    return e;
+}
+
+static LB_ReaderError lbRansDecodeBytes(const LB_RansTable *table, const uint8_t *ptr, const uint8_t *end, uint8_t *out_symbols, const size_t count) {
+    if ((size_t) (end - ptr) < LB_RANS_LANES * sizeof(uint32_t)) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    uint32_t states[LB_RANS_LANES];
+    for (size_t lane = 0; lane < LB_RANS_LANES; lane++) {
+        states[lane] = (uint32_t) ptr[0] | (uint32_t) ptr[1] << 8 | (uint32_t) ptr[2] << 16 | (uint32_t) ptr[3] << 24;
+        ptr += sizeof(uint32_t);
+    }
+
+    const uint32_t scale_bits = table->scale_bits;
+    const uint32_t mask = (1u << scale_bits) - 1;
+    size_t i = 0;
+
+    // Decode every lane before renormalizing any of them, the lanes do not depend on each other.
+    for (; i + LB_RANS_LANES <= count; i += LB_RANS_LANES) {
+        for (size_t lane = 0; lane < LB_RANS_LANES; lane++) {
+            const uint32_t x = states[lane];
+            const uint8_t symbol = table->slots[x & mask];
+            out_symbols[i + lane] = symbol;
+            states[lane] = table->frequencies[symbol] * (x >> scale_bits) + (x & mask) - table->cumulative[symbol];
+        }
+
+        for (size_t lane = 0; lane < LB_RANS_LANES; lane++) {
+            while (states[lane] < LB_RANS_LOWER_BOUND) {
+                if (ptr == end) {
+                    return LB_READER_ERROR_INVALID_VALUE;
+                }
+
+                states[lane] = (states[lane] << 8) | *ptr++;
+            }
+        }
+    }
+
+    for (; i < count; i++) {
+        const size_t lane = i % LB_RANS_LANES;
+        const uint32_t x = states[lane];
+        const uint8_t symbol = table->slots[x & mask];
+        out_symbols[i] = symbol;
+        states[lane] = table->frequencies[symbol] * (x >> scale_bits) + (x & mask) - table->cumulative[symbol];
+        while (states[lane] < LB_RANS_LOWER_BOUND) {
+            if (ptr == end) {
+                return LB_READER_ERROR_INVALID_VALUE;
+            }
+
+            states[lane] = (states[lane] << 8) | *ptr++;
+        }
+    }
+
+    return ptr == end ? LB_READER_ERROR_NONE : LB_READER_ERROR_INVALID_VALUE;
+}
+
+LB_ReaderError lbRansDecode(LB_Reader *reader, const LB_RansTable *table, uint8_t *out_symbols, const size_t capacity, size_t *out_count) {
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    const uint32_t count = lbReadU32LE(reader, &e);
+    if (e) {
+        return e;
+    }
+
+    const uint32_t byte_count = lbReadU32LE(reader, &e);
+    if (e) {
+        return e;
+    }
+
+    if (count > capacity) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    if (byte_count > lbReaderRemaining(reader)) {
+        return LB_READER_ERROR_END;
+    }
+
+    if (reader->_.mode == LB_READER_MODE_BUFFER) {
+        LB_ReaderBuffer *buffer = &reader->_.buffer;
+        const uint8_t *bytes = (const uint8_t *) buffer->data + buffer->position;
+        e = lbRansDecodeBytes(table, bytes, bytes + byte_count, out_symbols, count);
+        buffer->position += byte_count;
+    } else {
+        uint8_t *scratch = (uint8_t *) malloc(byte_count ? byte_count : 1);
+        if (scratch == NULL) {
+            return LB_READER_ERROR_DATA_NULL;
+        }
+
+        e = lbRead(reader, scratch, byte_count);
+        if (!e) {
+            e = lbRansDecodeBytes(table, scratch, scratch + byte_count, out_symbols, count);
+        }
+
+        free(scratch);
+    }
+
+    if (out_count != NULL) {
+        *out_count = e ? 0 : count;
+    }
+
+    return e;
+}
+
+static void lbRansAdaptiveUpdate(uint32_t *counts, const uint8_t *symbols, const size_t count, const uint32_t symbol_count) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        counts[symbols[i]]++;
+    }
+
+    for (uint32_t s = 0; s < symbol_count; s++) {
+        total += counts[s];
+    }
+
+    // Halve old statistics once they outweigh recent blocks, but keep every symbol encodable.
+    if (total > (1u << 16)) {
+        for (uint32_t s = 0; s < symbol_count; s++) {
+            counts[s] = (counts[s] + 1) / 2;
+        }
+    }
+}
+
+LB_WriterError lbRansEncodeAdaptive(LB_Writer *writer, const uint8_t *symbols, const size_t count, const uint32_t symbol_count, const uint32_t scale_bits, const uint32_t block_size) {
+    if (count > UINT32_MAX || block_size == 0 || symbol_count == 0 || symbol_count > LB_RANS_MAX_SYMBOLS
+        || scale_bits == 0 || scale_bits > LB_RANS_MAX_SCALE_BITS || (1u << scale_bits) < symbol_count) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+    LB_RansTable *table = (LB_RansTable *) malloc(sizeof(LB_RansTable));
+    if (table == NULL) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    LB_WriterError e = lbWriteU32LE(writer, (uint32_t) count);
+    e |= lbWriteU32LE(writer, block_size);
+    e |= lbWriteU16LE(writer, (uint16_t) symbol_count);
+    e |= lbWriteU8(writer, (uint8_t) scale_bits);
+
+    uint32_t counts[LB_RANS_MAX_SYMBOLS];
+    for (uint32_t s = 0; s < symbol_count; s++) {
+        counts[s] = 1;
+    }
+
+    for (size_t offset = 0; offset < count && !e; offset += block_size) {
+        const size_t block = count - offset < block_size ? count - offset : block_size;
+        for (size_t i = 0; i < block; i++) {
+            if (symbols[offset + i] >= symbol_count) {
+                free(table);
+                return LB_WRITER_ERROR_INVALID_VALUE;
+            }
+        }
+
+        if (lbRansTableInit(table, counts, symbol_count, scale_bits)) {
+            free(table);
+            return LB_WRITER_ERROR_INVALID_VALUE;
+        }
+
+        e |= lbRansEncode(writer, table, symbols + offset, block);
+        lbRansAdaptiveUpdate(counts, symbols + offset, block, symbol_count);
+    }
+
+    free(table);
+    return e;
+}
+
+LB_ReaderError lbRansDecodeAdaptive(LB_Reader *reader, uint8_t *out_symbols, const size_t capacity, size_t *out_count) {
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    const uint32_t count = lbReadU32LE(reader, &e);
+    const uint32_t block_size = e ? 0 : lbReadU32LE(reader, &e);
+    const uint32_t symbol_count = e ? 0 : lbReadU16LE(reader, &e);
+    const uint32_t scale_bits = e ? 0 : lbReadU8(reader, &e);
+    if (e) {
+        return e;
+    }
+
+    if (count > capacity || block_size == 0 || symbol_count == 0 || symbol_count > LB_RANS_MAX_SYMBOLS
+        || scale_bits == 0 || scale_bits > LB_RANS_MAX_SCALE_BITS || (1u << scale_bits) < symbol_count) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+
+    LB_RansTable *table = (LB_RansTable *) malloc(sizeof(LB_RansTable));
+    if (table == NULL) {
+        return LB_READER_ERROR_DATA_NULL;
+    }
+
+    uint32_t counts[LB_RANS_MAX_SYMBOLS];
+    for (uint32_t s = 0; s < symbol_count; s++) {
+        counts[s] = 1;
+    }
+
+    for (size_t offset = 0; offset < count && !e; offset += block_size) {
+        const size_t block = count - offset < block_size ? count - offset : block_size;
+        size_t decoded = 0;
+        if (lbRansTableInit(table, counts, symbol_count, scale_bits)) {
+            e = LB_READER_ERROR_INVALID_VALUE;
+            break;
+        }
+
+        e = lbRansDecode(reader, table, out_symbols + offset, block, &decoded);
+        if (!e && decoded != block) {
+            e = LB_READER_ERROR_INVALID_VALUE;
+        }
+
+        if (!e) {
+            lbRansAdaptiveUpdate(counts, out_symbols + offset, block, symbol_count);
+        }
+    }
+
+    free(table);
+    if (out_count != NULL) {
+        *out_count = e ? 0 : count;
+    }
+
+    return e;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_RANS_IMPLEMENTATION
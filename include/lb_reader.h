@@ -14,13 +14,33 @@ extern "C" {
 #include <stdlib.h>
 #endif
 
+#include "lb_file.h"
+#include "lb_stats.h"
+#include "lb_histogram.h"
+#include "lb_probes.h"
+#include "lb_profile.h"
+
 #ifndef LB_READER_NO_SAFETY
 #define LB_READER_SAFETY
 #endif
 
+// Linkage of the functions below. With LB_BUFFER_STATIC every translation unit gets its own static copy, so the
+// compiler can always inline them without link-time optimization. The implementation redeclarations are then skipped,
+// a static function has no external definition to provide. The functions that are not inline, such as lbCpu*,
+// lbWriterCopyFrom, lbWriteStrided* and the stats and profile functions, still need one translation unit defining
+// LB_BUFFER_IMPLEMENTATION, or lb_buffer_static / lb_buffer_shared.
+#ifndef LB_INLINE
+#ifdef LB_BUFFER_STATIC
+#define LB_INLINE static inline
+#else
+#define LB_INLINE inline
+#endif
+#endif
+
 typedef enum LB_ReaderMode {
     LB_READER_MODE_BUFFER = 0,
     LB_READER_MODE_FILE = 1,
+    LB_READER_MODE_SEGMENTED = 2,
 } LB_ReaderMode;
 
 // Error codes for initializing a LB_Reader.
@@ -37,7 +57,7 @@ typedef enum LB_ReaderInitError {
     LB_READER_INIT_LENGTH_ZERO = 0x8,
 } LB_ReaderInitError;
 
-inline const char* lbReaderInitErrorName(const LB_ReaderInitError error) {
+LB_INLINE const char* lbReaderInitErrorName(const LB_ReaderInitError error) {
     switch (error) {
         case LB_READER_INIT_NONE:
             return "LB_READER_INIT_NONE";
@@ -54,7 +74,7 @@ inline const char* lbReaderInitErrorName(const LB_ReaderInitError error) {
     }
 }
 
-inline const char* lbReaderInitErrorMessage(const LB_ReaderInitError error) {
+LB_INLINE const char* lbReaderInitErrorMessage(const LB_ReaderInitError error) {
     switch (error) {
         case LB_READER_INIT_NONE:
             return "No error.";
@@ -86,7 +106,20 @@ typedef enum LB_ReaderError {
     LB_READER_ERROR_INVALID_VALUE = 0x8,
 } LB_ReaderError;
 
-inline const char* lbReaderErrorName(const LB_ReaderError error) {
+#ifdef __cplusplus
+// The enums above are bit flags. C converts the int result of `|` back implicitly, C++ needs the operators.
+extern "C++" {
+#define LB_READER_FLAG_OPERATORS(type) \
+    inline type operator|(const type a, const type b) { return (type) ((int) a | (int) b); } \
+    inline type &operator|=(type &a, const type b) { return a = a | b; }
+LB_READER_FLAG_OPERATORS(LB_ReaderMode)
+LB_READER_FLAG_OPERATORS(LB_ReaderInitError)
+LB_READER_FLAG_OPERATORS(LB_ReaderError)
+#undef LB_READER_FLAG_OPERATORS
+}
+#endif
+
+LB_INLINE const char* lbReaderErrorName(const LB_ReaderError error) {
     switch (error) {
         case LB_READER_ERROR_NONE:
             return "LB_READER_ERROR_NONE";
@@ -103,7 +136,7 @@ inline const char* lbReaderErrorName(const LB_ReaderError error) {
     }
 }
 
-inline const char* lbReaderErrorMessage(const LB_ReaderError error) {
+LB_INLINE const char* lbReaderErrorMessage(const LB_ReaderError error) {
     switch (error) {
         case LB_READER_ERROR_NONE:
             return "No error.";
@@ -133,13 +166,40 @@ typedef struct LB_ReaderBuffer {
     size_t position;
 } LB_ReaderBuffer;
 
+// One contiguous piece of a segmented LB_Reader.
+typedef struct LB_ReaderSegment {
+    const void *data;
+    size_t length;
+} LB_ReaderSegment;
+
+typedef struct LB_ReaderSegments {
+    const LB_ReaderSegment *segments;
+    size_t count;
+    // The segment containing `position`, and the offset of `position` inside of it.
+    size_t index;
+    size_t offset;
+    size_t length;
+    size_t position;
+} LB_ReaderSegments;
+
+typedef struct LB_ReaderFile {
+    FILE *handle;
+    // Measured once by lbReaderInitFile, SIZE_MAX if the stream has no length (pipes, sockets, terminals).
+    size_t length;
+    // Kept up to date by every read, skip and seek, so lbReaderPosition and lbReaderRemaining do not call ftell.
+    size_t position;
+    // See lbReaderSetUnlocked.
+    int unlocked;
+} LB_ReaderFile;
+
 typedef struct LB_Reader {
     struct {
         LB_ReaderMode mode;
 
         union {
             LB_ReaderBuffer buffer;
-            FILE *file;
+            LB_ReaderSegments segments;
+            LB_ReaderFile file;
         };
     } _;
 } LB_Reader;
@@ -156,7 +216,7 @@ typedef struct LB_Reader {
  * If 0 and LB_READER_SAFETY, will return LB_READER_INIT_LENGTH_ZERO.                 <br>
  * @return LB_ReaderInitError An error code indicating the result of the initialization.
  */
-inline LB_ReaderInitError lbReaderInitBuffer(LB_Reader *reader, const void *data, const size_t length) {
+LB_INLINE LB_ReaderInitError lbReaderInitBuffer(LB_Reader *reader, const void *data, const size_t length) {
 #ifdef LB_READER_SAFETY
     LB_ReaderInitError e = LB_READER_INIT_NONE;
     if (reader == NULL) {
@@ -191,22 +251,99 @@ inline LB_ReaderInitError lbReaderInitBuffer(LB_Reader *reader, const void *data
 }
 
 
-inline LB_ReaderInitError lbReaderInitFile(LB_Reader *reader, FILE *file) {
+/**
+ * Initialize a LB_Reader over `file`, from its current position.                         <br>
+ * The length of the file and the position are measured here, once, and the reader keeps track of the position from
+ * then on. If the file grows, or the stream is read or moved other than through the reader, initialize the reader
+ * again. Streams without a length, such as pipes, have a length and remaining count of SIZE_MAX, and a position
+ * counted from 0 at initialization.
+ */
+LB_INLINE LB_ReaderInitError lbReaderInitFile(LB_Reader *reader, FILE *file) {
     if (file == NULL) {
         return LB_READER_INIT_DATA_NULL;
     }
 
+    // Only regular files have a length. Other streams are unbounded and fread reports their end, even where they can
+    // seek: a device may report a length of 0.
+#ifdef LB_FILE_STAT
+    LB_FileStatus status;
+    const int has_length = LB_FILE_STAT(file, &status) == 0 && LB_FILE_STATUS_REGULAR(&status);
+#else
+    const int has_length = 1;
+#endif
+    size_t length = SIZE_MAX;
+    const LB_FileOffset position = has_length ? LB_FILE_TELL(file) : -1;
+    if (position >= 0 && LB_FILE_SEEK(file, 0, SEEK_END) == 0) {
+        const LB_FileOffset end = LB_FILE_TELL(file);
+        LB_FILE_SEEK(file, position, SEEK_SET);
+        if (end >= 0) {
+            length = (size_t) end;
+        }
+    }
+
     *reader = (LB_Reader){
         ._ = {
             .mode = LB_READER_MODE_FILE,
-            .file = file
+            .file = {
+                .handle = file,
+                .length = length,
+                .position = length == SIZE_MAX ? 0 : (size_t) position,
+            }
         }
     };
     return LB_READER_INIT_NONE;
 }
 
+/**
+ * Initialize a LB_Reader over several non-contiguous pieces of memory that are read as one.  <br>
+ * The segments are not copied and must outlive the reader.
+ *
+ * @param reader A pointer to the LB_Reader to be initialized.                              <br>
+ * If NULL and LB_READER_SAFETY, will return LB_READER_INIT_NO_READER.                <br>
+ * @param segments The segments, in order. Segments may be empty.                             <br>
+ * If NULL while `count` is not 0 and LB_READER_SAFETY, will return LB_READER_INIT_DATA_NULL.  <br>
+ * @param count The number of segments.
+ * @return LB_ReaderInitError An error code indicating the result of the initialization.
+ */
+LB_INLINE LB_ReaderInitError lbReaderInitSegmented(LB_Reader *reader, const LB_ReaderSegment *segments, const size_t count) {
 #ifdef LB_READER_SAFETY
-inline LB_ReaderError lbReaderCheckSafety(const LB_Reader *reader, const void *out_value, const size_t length) {
+    LB_ReaderInitError e = LB_READER_INIT_NONE;
+    if (reader == NULL) {
+        e |= LB_READER_INIT_NO_READER;
+    }
+
+    if (segments == NULL && count != 0) {
+        e |= LB_READER_INIT_DATA_NULL;
+    }
+
+    if (e) {
+        return e;
+    }
+#endif
+
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        length += segments[i].length;
+    }
+
+    *reader = (LB_Reader){
+        ._ = {
+            .mode = LB_READER_MODE_SEGMENTED,
+            .segments = {
+                .segments = segments,
+                .count = count,
+                .index = 0,
+                .offset = 0,
+                .length = length,
+                .position = 0,
+            }
+        }
+    };
+    return LB_READER_INIT_NONE;
+}
+
+#ifdef LB_READER_SAFETY
+LB_INLINE LB_ReaderError lbReaderCheckSafety(const LB_Reader *reader, const void *out_value, const size_t length) {
     LB_ReaderError e = LB_READER_ERROR_NONE;
     if (reader == NULL) {
         e |= LB_READER_ERROR_READER_NULL;
@@ -219,7 +356,12 @@ inline LB_ReaderError lbReaderCheckSafety(const LB_Reader *reader, const void *o
         if (buffer->data == NULL) {
             e |= LB_READER_ERROR_DATA_NULL;
         }
-    } else if (reader->_.file == NULL) {
+    } else if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        const LB_ReaderSegments *segments = &reader->_.segments;
+        if (segments->position + length > segments->length) {
+            e |= LB_READER_ERROR_END;
+        }
+    } else if (reader->_.file.handle == NULL) {
         e |= LB_READER_ERROR_DATA_NULL;
     }
 
@@ -234,11 +376,13 @@ inline LB_ReaderError lbReaderCheckSafety(const LB_Reader *reader, const void *o
 #define lbReadSafety(reader, length, value) LB_READER_READ_NONE
 #endif
 
-inline LB_ReaderMode lbReaderGetMode(const LB_Reader *reader) {
+LB_INLINE LB_ReaderMode lbReaderGetMode(const LB_Reader *reader) {
     return reader->_.mode;
 }
 
-inline LB_ReaderError lbReaderSeek(LB_Reader *reader, const size_t position) {
+LB_INLINE LB_ReaderError lbReaderSeek(LB_Reader *reader, const size_t position) {
+    LB_STATS_ADD(reader_seeks, 1);
+    LB_PROBE1(reader_seek, position);
     if (reader->_.mode == LB_READER_MODE_BUFFER) {
         LB_ReaderBuffer *buffer = &reader->_.buffer;
         if (position >= buffer->length) {
@@ -249,67 +393,219 @@ inline LB_ReaderError lbReaderSeek(LB_Reader *reader, const size_t position) {
         return LB_READER_ERROR_NONE;
     }
 
-    FILE *file = reader->_.file;
-    if (fseek(file, position, SEEK_SET) != 0) {
+    if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        LB_ReaderSegments *segments = &reader->_.segments;
+        if (position >= segments->length) {
+            return LB_READER_ERROR_END;
+        }
+
+        size_t index = 0;
+        size_t offset = position;
+        while (offset >= segments->segments[index].length) {
+            offset -= segments->segments[index].length;
+            index++;
+        }
+
+        segments->index = index;
+        segments->offset = offset;
+        segments->position = position;
+        return LB_READER_ERROR_NONE;
+    }
+
+    FILE *file = reader->_.file.handle;
+    LB_STATS_ADD(file_seeks, 1);
+    if (LB_FILE_SEEK(file, position, SEEK_SET) != 0) {
+        return LB_READER_ERROR_END;
+    }
+
+    reader->_.file.position = position;
+    return LB_READER_ERROR_NONE;
+}
+
+/**
+ * Move the position by `offset` bytes, backwards if negative. <br>
+ * Same bounds as lbReaderSeek. File readers seek relative to the current position, without a tell.
+ */
+LB_INLINE LB_ReaderError lbReaderSeekRelative(LB_Reader *reader, const int64_t offset) {
+    if (reader->_.mode == LB_READER_MODE_FILE) {
+        LB_STATS_ADD(reader_seeks, 1);
+        LB_STATS_ADD(file_seeks, 1);
+        if (LB_FILE_SEEK(reader->_.file.handle, offset, SEEK_CUR) != 0) {
+            return LB_READER_ERROR_END;
+        }
+
+        reader->_.file.position += (size_t) offset;
+        return LB_READER_ERROR_NONE;
+    }
+
+    const size_t position = reader->_.mode == LB_READER_MODE_BUFFER ? reader->_.buffer.position
+                                                                    : reader->_.segments.position;
+    if (offset < 0 && (uint64_t) -offset > position) {
+        return LB_READER_ERROR_END;
+    }
+
+    return lbReaderSeek(reader, position + (size_t) offset);
+}
+
+/**
+ * Skip `length` bytes, as if they had been read. <br>
+ * Unlike lbReaderSeek this may move the position to exactly the end. Returns LB_READER_ERROR_END, without moving,
+ * if fewer than `length` bytes remain.
+ */
+LB_INLINE LB_ReaderError lbReaderSkip(LB_Reader *reader, const size_t length) {
+    if (reader->_.mode == LB_READER_MODE_BUFFER) {
+        LB_ReaderBuffer *buffer = &reader->_.buffer;
+        if (length > buffer->length - buffer->position) {
+            return LB_READER_ERROR_END;
+        }
+
+        buffer->position += length;
+        return LB_READER_ERROR_NONE;
+    }
+
+    if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        LB_ReaderSegments *segments = &reader->_.segments;
+        if (length > segments->length - segments->position) {
+            return LB_READER_ERROR_END;
+        }
+
+        if (segments->position + length == segments->length) {
+            segments->index = segments->count;
+            segments->offset = 0;
+            segments->position = segments->length;
+            return LB_READER_ERROR_NONE;
+        }
+
+        return lbReaderSeek(reader, segments->position + length);
+    }
+
+    LB_ReaderFile *file = &reader->_.file;
+    if (file->length != SIZE_MAX && (file->position > file->length || length > file->length - file->position)) {
         return LB_READER_ERROR_END;
     }
 
+    LB_STATS_ADD(file_seeks, 1);
+    if (LB_FILE_SEEK(file->handle, length, SEEK_CUR) != 0) {
+        return LB_READER_ERROR_END;
+    }
+
+    file->position += length;
     return LB_READER_ERROR_NONE;
 }
 
+/**
+ * Take the FILE lock of a file reader until lbReaderUnlock, so a sequence of reads is not interleaved with other
+ * threads' and each read does not lock again. Required around shared streams after lbReaderSetUnlocked. Does nothing
+ * for buffer and segmented readers.
+ */
+LB_INLINE void lbReaderLock(const LB_Reader *reader) {
+    if (reader->_.mode == LB_READER_MODE_FILE) {
+        LB_FILE_LOCK(reader->_.file.handle);
+    }
+}
+
+LB_INLINE void lbReaderUnlock(const LB_Reader *reader) {
+    if (reader->_.mode == LB_READER_MODE_FILE) {
+        LB_FILE_UNLOCK(reader->_.file.handle);
+    }
+}
+
+/**
+ * Make the reads of a file reader skip the FILE lock (fread_unlocked, _fread_nolock...), see lb_file.h. The stream
+ * must then not be used by another thread at the same time, unless every sequence of reads is bracketed by
+ * lbReaderLock / lbReaderUnlock. 0 turns it off, the default. Buffer and segmented readers ignore it.
+ */
+LB_INLINE void lbReaderSetUnlocked(LB_Reader *reader, const int unlocked) {
+    if (reader->_.mode == LB_READER_MODE_FILE) {
+        reader->_.file.unlocked = unlocked != 0;
+    }
+}
+
 #define lbReaderTell lbReaderPosition
 
-inline size_t lbReaderPosition(const LB_Reader *reader) {
+LB_INLINE size_t lbReaderPosition(const LB_Reader *reader) {
     if (reader->_.mode == LB_READER_MODE_BUFFER) {
         return reader->_.buffer.position;
     }
 
-    FILE *file = reader->_.file;
-#ifdef _LARGEFILE64_SOURCE
-#ifdef _MSC_VER
-    return _ftelli64(file);
-#else
-    return ftello64(file);
-#endif
-#else
-    return ftell(file);
-#endif
+    if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        return reader->_.segments.position;
+    }
+
+    return reader->_.file.position;
 }
 
-inline size_t lbReaderLength(const LB_Reader *reader) {
+LB_INLINE size_t lbReaderLength(const LB_Reader *reader) {
     if (reader->_.mode == LB_READER_MODE_BUFFER) {
         return reader->_.buffer.length;
     }
 
-    FILE *file = reader->_.file;
-#ifdef _LARGEFILE64_SOURCE
-#ifdef _MSC_VER
-    const long long position = _ftelli64(file);
-    _fseeki64(file, 0, SEEK_END);
-    const long long end = _ftelli64(file);
-    _fseeki64(file, position, SEEK_SET);
-    return end;
-#else
-    const off64_t position = ftello64(file);
-    fseeko64(file, 0, SEEK_END);
-    const off64_t end = ftello64(file);
-    fseeko64(file, position, SEEK_SET);
-    return end;
-#endif
-#else
-    const long position = ftell(file);
-    fseek(file, 0, SEEK_END);
-    const long end = ftell(file);
-    fseek(file, position, SEEK_SET);
-    return end;
-#endif
+    if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        return reader->_.segments.length;
+    }
+
+    return reader->_.file.length;
 }
 
-inline size_t lbReaderRemaining(const LB_Reader *reader) {
+// SIZE_MAX for file readers over streams without a length.
+LB_INLINE size_t lbReaderRemaining(const LB_Reader *reader) {
+    if (reader->_.mode == LB_READER_MODE_FILE) {
+        const LB_ReaderFile *file = &reader->_.file;
+        if (file->length == SIZE_MAX) {
+            return SIZE_MAX;
+        }
+
+        return file->position < file->length ? file->length - file->position : 0;
+    }
+
     return lbReaderLength(reader) - lbReaderPosition(reader);
 }
 
-inline LB_ReaderError lbReadUnsafe(LB_Reader *reader, void *out_value, const size_t length) {
+LB_INLINE LB_ReaderError lbReadSegmentsUnsafe(LB_ReaderSegments *segments, void *out_value, const size_t length) {
+    size_t copied = 0;
+    while (copied < length) {
+        if (segments->index >= segments->count) {
+            return LB_READER_ERROR_END;
+        }
+
+        const LB_ReaderSegment *segment = &segments->segments[segments->index];
+        if (segments->offset == segment->length) {
+            // Empty segments may have NULL data, step over them instead of copying nothing from them.
+            segments->index++;
+            segments->offset = 0;
+            continue;
+        }
+
+        size_t chunk = segment->length - segments->offset;
+        if (chunk > length - copied) {
+            chunk = length - copied;
+        }
+
+        memcpy((uint8_t *) out_value + copied, (const uint8_t *) segment->data + segments->offset, chunk);
+        copied += chunk;
+        segments->offset += chunk;
+        if (segments->offset == segment->length) {
+            segments->index++;
+            segments->offset = 0;
+        }
+    }
+
+    segments->position += length;
+    return LB_READER_ERROR_NONE;
+}
+
+// A failed fread may have consumed part of the value. Streams with a length are asked for their position again, the
+// others keep the last known one.
+LB_INLINE void lbReaderFileResync(LB_ReaderFile *file) {
+    if (file->length != SIZE_MAX) {
+        const LB_FileOffset position = LB_FILE_TELL(file->handle);
+        if (position >= 0) {
+            file->position = (size_t) position;
+        }
+    }
+}
+
+LB_INLINE LB_ReaderError lbReadUnsafe(LB_Reader *reader, void *out_value, const size_t length) {
     if (reader->_.mode == LB_READER_MODE_BUFFER) {
         LB_ReaderBuffer *buffer = &reader->_.buffer;
         memcpy(out_value, (uint8_t *) buffer->data + buffer->position, length);
@@ -317,19 +613,38 @@ inline LB_ReaderError lbReadUnsafe(LB_Reader *reader, void *out_value, const siz
         return LB_READER_ERROR_NONE;
     }
 
-    FILE *file = reader->_.file;
-    if (fread(out_value, length, 1, file) != 1) {
+    if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        return lbReadSegmentsUnsafe(&reader->_.segments, out_value, length);
+    }
+
+    LB_ReaderFile *file = &reader->_.file;
+    LB_STATS_ADD(file_reads, 1);
+    LB_HISTOGRAM_BEGIN(read_start);
+    const size_t read = file->unlocked ? LB_FILE_READ_UNLOCKED(out_value, length, file->handle)
+                                       : LB_FILE_READ(out_value, length, file->handle);
+    LB_HISTOGRAM_END(LB_HISTOGRAM_FILE_READ, read_start);
+    LB_PROBE2(file_read, length, read);
+    if (read != 1) {
+        lbReaderFileResync(file);
+        LB_STATS_ERRORS(read_errors, LB_READER_ERROR_END);
+        LB_PROBE2(read_error, LB_READER_ERROR_END, length);
         return LB_READER_ERROR_END;
     }
 
+    file->position += length;
     return LB_READER_ERROR_NONE;
 }
 
 
-inline LB_ReaderError lbRead(LB_Reader *reader, void *out_value, const size_t length) {
+LB_INLINE LB_ReaderError lbRead(LB_Reader *reader, void *out_value, const size_t length) {
+    LB_STATS_ADD(read_calls, 1);
+    LB_PROFILE_RECORD(LB_PROFILE_OP_READ, length);
+    LB_STATS_ADD(read_bytes, length);
 #ifdef LB_READER_SAFETY
     const LB_ReaderError e = lbReaderCheckSafety(reader, out_value, length);
     if (e) {
+        LB_STATS_ERRORS(read_errors, e);
+        LB_PROBE2(read_error, e, length);
         return e;
     }
 #endif
@@ -337,7 +652,7 @@ inline LB_ReaderError lbRead(LB_Reader *reader, void *out_value, const size_t le
     return lbReadUnsafe(reader, out_value, length);
 }
 
-inline LB_ReaderError lbReadReversedUnsafe(LB_Reader *reader, void *out_value, const size_t length) {
+LB_INLINE LB_ReaderError lbReadReversedUnsafe(LB_Reader *reader, void *out_value, const size_t length) {
     if (reader->_.mode == LB_READER_MODE_BUFFER) {
         LB_ReaderBuffer *buffer = &reader->_.buffer;
         for (size_t i = 0; i < length; i++) {
@@ -348,8 +663,27 @@ inline LB_ReaderError lbReadReversedUnsafe(LB_Reader *reader, void *out_value, c
         return LB_READER_ERROR_NONE;
     }
 
-    if (fread(out_value, length, 1, reader->_.file) != 1) {
-        return LB_READER_ERROR_END;
+    if (reader->_.mode == LB_READER_MODE_SEGMENTED) {
+        const LB_ReaderError e = lbReadSegmentsUnsafe(&reader->_.segments, out_value, length);
+        if (e) {
+            return e;
+        }
+    } else {
+        LB_ReaderFile *file = &reader->_.file;
+        LB_STATS_ADD(file_reads, 1);
+        LB_HISTOGRAM_BEGIN(read_start);
+        const size_t read = file->unlocked ? LB_FILE_READ_UNLOCKED(out_value, length, file->handle)
+                                           : LB_FILE_READ(out_value, length, file->handle);
+        LB_HISTOGRAM_END(LB_HISTOGRAM_FILE_READ, read_start);
+        LB_PROBE2(file_read, length, read);
+        if (read != 1) {
+            lbReaderFileResync(file);
+            LB_STATS_ERRORS(read_errors, LB_READER_ERROR_END);
+            LB_PROBE2(read_error, LB_READER_ERROR_END, length);
+            return LB_READER_ERROR_END;
+        }
+
+        file->position += length;
     }
 
     // Reverse the bytes.
@@ -362,10 +696,15 @@ inline LB_ReaderError lbReadReversedUnsafe(LB_Reader *reader, void *out_value, c
     return LB_READER_ERROR_NONE;
 }
 
-inline LB_ReaderError lbReadReversed(LB_Reader *reader, void *out_value, const size_t length) {
+LB_INLINE LB_ReaderError lbReadReversed(LB_Reader *reader, void *out_value, const size_t length) {
+    LB_STATS_ADD(read_calls, 1);
+    LB_PROFILE_RECORD(LB_PROFILE_OP_READ, length);
+    LB_STATS_ADD(read_bytes, length);
 #ifdef LB_READER_SAFETY
     const LB_ReaderError e = lbReaderCheckSafety(reader, out_value, length);
     if (e) {
+        LB_STATS_ERRORS(read_errors, e);
+        LB_PROBE2(read_error, e, length);
         return e;
     }
 #endif
@@ -385,7 +724,7 @@ inline LB_ReaderError lbReadReversed(LB_Reader *reader, void *out_value, const s
 #define lbReadUnsafeBE lbReadUnsafe
 #endif
 
-inline uint8_t lbReadU8(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint8_t lbReadU8(LB_Reader *reader, LB_ReaderError *out_error) {
     uint8_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -396,7 +735,7 @@ inline uint8_t lbReadU8(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint8_t lbReadU8LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint8_t lbReadU8LE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint8_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -407,7 +746,7 @@ inline uint8_t lbReadU8LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint8_t lbReadU8BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint8_t lbReadU8BE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint8_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -418,7 +757,7 @@ inline uint8_t lbReadU8BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint16_t lbReadU16(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint16_t lbReadU16(LB_Reader *reader, LB_ReaderError *out_error) {
     uint16_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -429,7 +768,7 @@ inline uint16_t lbReadU16(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint16_t lbReadU16LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint16_t lbReadU16LE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint16_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -440,7 +779,7 @@ inline uint16_t lbReadU16LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint16_t lbReadU16BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint16_t lbReadU16BE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint16_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -451,7 +790,7 @@ inline uint16_t lbReadU16BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint32_t lbReadU32(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint32_t lbReadU32(LB_Reader *reader, LB_ReaderError *out_error) {
     uint32_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -462,7 +801,7 @@ inline uint32_t lbReadU32(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint32_t lbReadU32LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint32_t lbReadU32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint32_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -473,7 +812,7 @@ inline uint32_t lbReadU32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint32_t lbReadU32BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint32_t lbReadU32BE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint32_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -485,7 +824,7 @@ inline uint32_t lbReadU32BE(LB_Reader *reader, LB_ReaderError *out_error) {
 }
 
 
-inline uint64_t lbReadU64(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint64_t lbReadU64(LB_Reader *reader, LB_ReaderError *out_error) {
     uint64_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -496,7 +835,7 @@ inline uint64_t lbReadU64(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint64_t lbReadU64LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint64_t lbReadU64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint64_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -507,7 +846,7 @@ inline uint64_t lbReadU64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline uint64_t lbReadU64BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE uint64_t lbReadU64BE(LB_Reader *reader, LB_ReaderError *out_error) {
     uint64_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -519,7 +858,7 @@ inline uint64_t lbReadU64BE(LB_Reader *reader, LB_ReaderError *out_error) {
 }
 
 
-inline int8_t lbReadI8(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int8_t lbReadI8(LB_Reader *reader, LB_ReaderError *out_error) {
     int8_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -530,7 +869,7 @@ inline int8_t lbReadI8(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int8_t lbReadI8LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int8_t lbReadI8LE(LB_Reader *reader, LB_ReaderError *out_error) {
     int8_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -541,7 +880,7 @@ inline int8_t lbReadI8LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int8_t lbReadI8BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int8_t lbReadI8BE(LB_Reader *reader, LB_ReaderError *out_error) {
     int8_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -552,7 +891,7 @@ inline int8_t lbReadI8BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int16_t lbReadI16(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int16_t lbReadI16(LB_Reader *reader, LB_ReaderError *out_error) {
     int16_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -563,7 +902,7 @@ inline int16_t lbReadI16(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int16_t lbReadI16LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int16_t lbReadI16LE(LB_Reader *reader, LB_ReaderError *out_error) {
     int16_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -574,7 +913,7 @@ inline int16_t lbReadI16LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int16_t lbReadI16BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int16_t lbReadI16BE(LB_Reader *reader, LB_ReaderError *out_error) {
     int16_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -585,7 +924,7 @@ inline int16_t lbReadI16BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int32_t lbReadI32(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int32_t lbReadI32(LB_Reader *reader, LB_ReaderError *out_error) {
     int32_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -596,7 +935,7 @@ inline int32_t lbReadI32(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int32_t lbReadI32LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int32_t lbReadI32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     int32_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -607,7 +946,7 @@ inline int32_t lbReadI32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int32_t lbReadI32BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int32_t lbReadI32BE(LB_Reader *reader, LB_ReaderError *out_error) {
     int32_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -619,7 +958,7 @@ inline int32_t lbReadI32BE(LB_Reader *reader, LB_ReaderError *out_error) {
 }
 
 
-inline int64_t lbReadI64(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int64_t lbReadI64(LB_Reader *reader, LB_ReaderError *out_error) {
     int64_t result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -630,7 +969,7 @@ inline int64_t lbReadI64(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int64_t lbReadI64LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int64_t lbReadI64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     int64_t result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -641,7 +980,7 @@ inline int64_t lbReadI64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline int64_t lbReadI64BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE int64_t lbReadI64BE(LB_Reader *reader, LB_ReaderError *out_error) {
     int64_t result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -653,7 +992,7 @@ inline int64_t lbReadI64BE(LB_Reader *reader, LB_ReaderError *out_error) {
 }
 
 
-inline float lbReadF32(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadF32(LB_Reader *reader, LB_ReaderError *out_error) {
     float result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -664,7 +1003,7 @@ inline float lbReadF32(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline float lbReadF32LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadF32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     float result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -675,7 +1014,7 @@ inline float lbReadF32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline float lbReadF32BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadF32BE(LB_Reader *reader, LB_ReaderError *out_error) {
     float result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -687,7 +1026,7 @@ inline float lbReadF32BE(LB_Reader *reader, LB_ReaderError *out_error) {
 }
 
 
-inline double lbReadF64(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadF64(LB_Reader *reader, LB_ReaderError *out_error) {
     double result;
     const LB_ReaderError error = lbRead(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -698,7 +1037,7 @@ inline double lbReadF64(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline double lbReadF64LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadF64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     double result;
     const LB_ReaderError error = lbReadLE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -709,7 +1048,7 @@ inline double lbReadF64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return result;
 }
 
-inline double lbReadF64BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadF64BE(LB_Reader *reader, LB_ReaderError *out_error) {
     double result;
     const LB_ReaderError error = lbReadBE(reader, &result, sizeof(result));
 #ifdef LB_READER_SAFETY
@@ -724,106 +1063,106 @@ inline double lbReadF64BE(LB_Reader *reader, LB_ReaderError *out_error) {
  * Normalized Integer Functions
  */
 
-inline float lbReadNU8(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNU8(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadU8(reader, out_error) / (float) UINT8_MAX;
 }
 
-inline float lbReadNU8LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNU8LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return lbReadNU8(reader, out_error);
 }
 
-inline float lbReadNU8BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNU8BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return lbReadNU8(reader, out_error);
 }
 
 
-inline float lbReadNU16(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNU16(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadU16(reader, out_error) / (float) UINT16_MAX;
 }
 
-inline float lbReadNU16LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNU16LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadU16LE(reader, out_error) / (float) UINT16_MAX;
 }
 
-inline float lbReadNU16BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNU16BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadU16BE(reader, out_error) / (float) UINT16_MAX;
 }
 
 /*  Normalized integers utilizing more than 23 bits can carry more precision than a float.  */
-inline double lbReadNU32(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNU32(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadU32(reader, out_error) / (double) UINT32_MAX;
 }
 
-inline double lbReadNU32LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNU32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadU32LE(reader, out_error) / (double) UINT32_MAX;
 }
 
-inline double lbReadNU32BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNU32BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadU32BE(reader, out_error) / (double) UINT32_MAX;
 }
 
 
-inline double lbReadNU64(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNU64(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadU64(reader, out_error) / (double) UINT64_MAX;
 }
 
-inline double lbReadNU64LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNU64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadU64LE(reader, out_error) / (double) UINT64_MAX;
 }
 
-inline double lbReadNU64BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNU64BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadU64BE(reader, out_error) / (double) UINT64_MAX;
 }
 
 
-inline float lbReadNI8(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNI8(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadI8(reader, out_error) / (float) INT8_MAX;
 }
 
-inline float lbReadNI8LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNI8LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return lbReadNI8(reader, out_error);
 }
 
-inline float lbReadNI8BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNI8BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return lbReadNI8(reader, out_error);
 }
 
 
-inline float lbReadNI16(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNI16(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadI16(reader, out_error) / (float) INT16_MAX;
 }
 
-inline float lbReadNI16LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNI16LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadI16LE(reader, out_error) / (float) INT16_MAX;
 }
 
-inline float lbReadNI16BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE float lbReadNI16BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (float) lbReadI16BE(reader, out_error) / (float) INT16_MAX;
 }
 
 
-inline double lbReadNI32(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNI32(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadI32(reader, out_error) / (double) INT32_MAX;
 }
 
-inline double lbReadNI32LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNI32LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadI32LE(reader, out_error) / (double) INT32_MAX;
 }
 
-inline double lbReadNI32BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNI32BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadI32BE(reader, out_error) / (double) INT32_MAX;
 }
 
 
-inline double lbReadNI64(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNI64(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadI64(reader, out_error) / (double) INT64_MAX;
 }
 
-inline double lbReadNI64LE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNI64LE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadI64LE(reader, out_error) / (double) INT64_MAX;
 }
 
-inline double lbReadNI64BE(LB_Reader *reader, LB_ReaderError *out_error) {
+LB_INLINE double lbReadNI64BE(LB_Reader *reader, LB_ReaderError *out_error) {
     return (double) lbReadI64BE(reader, out_error) / (double) INT64_MAX;
 }
 #ifdef __cplusplus
@@ -831,7 +1170,7 @@ inline double lbReadNI64BE(LB_Reader *reader, LB_ReaderError *out_error) {
 #endif
 #endif
 
-#ifdef LB_READER_IMPLEMENTATION
+#if defined(LB_READER_IMPLEMENTATION) && !defined(LB_BUFFER_STATIC)
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -844,6 +1183,8 @@ const char* lbReaderErrorMessage(const LB_ReaderError error);
 LB_ReaderInitError lbReaderInitBuffer(LB_Reader *reader, const void *data, size_t length);
 
 LB_ReaderInitError lbReaderInitFile(LB_Reader *reader, FILE *file);
+
+LB_ReaderInitError lbReaderInitSegmented(LB_Reader *reader, const LB_ReaderSegment *segments, size_t count);
 #ifdef LB_READER_SAFETY
 LB_ReaderError lbReaderCheckSafety(const LB_Reader *reader, const void *out_value, size_t length);
 #endif
@@ -851,8 +1192,21 @@ LB_ReaderMode lbReaderGetMode(const LB_Reader *reader);
 
 LB_ReaderError lbReaderSeek(LB_Reader *reader, size_t position);
 
+LB_ReaderError lbReaderSeekRelative(LB_Reader *reader, int64_t offset);
+
+LB_ReaderError lbReaderSkip(LB_Reader *reader, size_t length);
+
+void lbReaderLock(const LB_Reader *reader);
+
+void lbReaderUnlock(const LB_Reader *reader);
+
+void lbReaderSetUnlocked(LB_Reader *reader, int unlocked);
+
 size_t lbReaderTell(const LB_Reader *reader);
 
+LB_ReaderError lbReadSegmentsUnsafe(LB_ReaderSegments *segments, void *out_value, size_t length);
+void lbReaderFileResync(LB_ReaderFile *file);
+
 LB_ReaderError lbReadUnsafe(LB_Reader *reader, void *out_value, size_t length);
 
 LB_ReaderError lbRead(LB_Reader *reader, void *out_value, size_t length);
@@ -972,8 +1326,8 @@ double lbReadNI64(LB_Reader *reader, LB_ReaderError *out_error);
 double lbReadNI64LE(LB_Reader *reader, LB_ReaderError *out_error);
 
 double lbReadNI64BE(LB_Reader *reader, LB_ReaderError *out_error);
-#endif
 
 #ifdef __cplusplus
 }
 #endif
+#endif
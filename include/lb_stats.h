@@ -0,0 +1,161 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_STATS_H
+#define LB_STATS_H
+
+/*
+ * Opt-in hot path counters.
+ *
+ * Define LB_BUFFER_STATS for every translation unit to enable them, and LB_STATS_IMPLEMENTATION (implied by
+ * LB_BUFFER_IMPLEMENTATION) in exactly one. Without LB_BUFFER_STATS every hook expands to nothing.
+ *
+ * Counters are updated with relaxed atomic adds where the compiler supports them, so they are safe to update from
+ * several threads, but every update is a shared write: expect the hot path to be measurably slower in this mode.
+ */
+
+#ifdef LB_BUFFER_STATS
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstdio>
+extern "C" {
+#else
+#include <stdint.h>
+#include <stdio.h>
+#endif
+
+// Error codes are bit flags, counted per bit: index 0 is 0x1, index 3 is 0x8.
+#define LB_STATS_ERROR_BITS 4
+
+typedef struct LB_Stats {
+    // lbWrite, lbWriteReversed and lbWritePrepend, including every typed write built on them, and the direct
+    // paths of lbWriterCopyFrom and lbWriteStrided*.
+    uint64_t write_calls;
+    uint64_t write_bytes;
+    uint64_t write_errors[LB_STATS_ERROR_BITS];
+    // lbRead and lbReadReversed, including every typed read built on them, and the direct
+    // paths of lbWriterCopyFrom and lbReadStrided*.
+    uint64_t read_calls;
+    uint64_t read_bytes;
+    uint64_t read_errors[LB_STATS_ERROR_BITS];
+    // Dynamic buffer reallocations, and the bytes realloc had to move because the block could not grow in place.
+    uint64_t grow_events;
+    uint64_t grow_bytes_copied;
+    uint64_t writer_seeks;
+    uint64_t reader_seeks;
+    // fwrite, fread and fseek calls made by file mode writers and readers.
+    uint64_t file_writes;
+    uint64_t file_reads;
+    uint64_t file_seeks;
+    // lbPagedArenaAlloc calls, bytes, pages it added and pages it skipped while looking for space.
+    uint64_t arena_allocs;
+    uint64_t arena_bytes;
+    uint64_t arena_pages;
+    uint64_t arena_page_walk;
+} LB_Stats;
+
+extern LB_Stats lb_stats;
+
+inline void lbStatsAdd(uint64_t *counter, const uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+#else
+    *counter += value;
+#endif
+}
+
+inline void lbStatsAddErrors(uint64_t *counters, const uint32_t error) {
+    for (uint32_t bit = 0; bit < LB_STATS_ERROR_BITS; bit++) {
+        if (error & (1u << bit)) {
+            lbStatsAdd(&counters[bit], 1);
+        }
+    }
+}
+
+#define LB_STATS_ADD(counter, value) lbStatsAdd(&lb_stats.counter, (uint64_t) (value))
+#define LB_STATS_ERRORS(counters, error) lbStatsAddErrors(lb_stats.counters, (uint32_t) (error))
+
+// Copy the current counters into `out_stats`. Each counter is read atomically, the snapshot as a whole is not.
+void lbStatsSnapshot(LB_Stats *out_stats);
+
+// Set every counter to zero.
+void lbStatsReset(void);
+
+// Print a snapshot as `name value` lines.
+void lbStatsPrint(FILE *file, const LB_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+#define LB_STATS_ADD(counter, value) ((void) 0)
+#define LB_STATS_ERRORS(counters, error) ((void) 0)
+#endif
+
+#endif //LB_STATS_H
+
+#if defined(LB_STATS_IMPLEMENTATION) && defined(LB_BUFFER_STATS) && !defined(LB_STATS_IMPLEMENTED)
+#define LB_STATS_IMPLEMENTED
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+LB_Stats lb_stats;
+
+void lbStatsAdd(uint64_t *counter, uint64_t value);
+void lbStatsAddErrors(uint64_t *counters, uint32_t error);
+
+#define LB_STATS_COUNTER_COUNT (sizeof(LB_Stats) / sizeof(uint64_t))
+
+void lbStatsSnapshot(LB_Stats *out_stats) {
+    const uint64_t *source = (const uint64_t *) &lb_stats;
+    uint64_t *target = (uint64_t *) out_stats;
+    for (size_t i = 0; i < LB_STATS_COUNTER_COUNT; i++) {
+#if defined(__GNUC__) || defined(__clang__)
+        target[i] = __atomic_load_n(&source[i], __ATOMIC_RELAXED);
+#else
+        target[i] = source[i];
+#endif
+    }
+}
+
+void lbStatsReset(void) {
+    uint64_t *target = (uint64_t *) &lb_stats;
+    for (size_t i = 0; i < LB_STATS_COUNTER_COUNT; i++) {
+#if defined(__GNUC__) || defined(__clang__)
+        __atomic_store_n(&target[i], 0, __ATOMIC_RELAXED);
+#else
+        target[i] = 0;
+#endif
+    }
+}
+
+void lbStatsPrint(FILE *file, const LB_Stats *stats) {
+    fprintf(file, "write_calls %llu\n", (unsigned long long) stats->write_calls);
+    fprintf(file, "write_bytes %llu\n", (unsigned long long) stats->write_bytes);
+    for (int bit = 0; bit < LB_STATS_ERROR_BITS; bit++) {
+        fprintf(file, "write_errors_0x%x %llu\n", 1u << bit, (unsigned long long) stats->write_errors[bit]);
+    }
+    fprintf(file, "read_calls %llu\n", (unsigned long long) stats->read_calls);
+    fprintf(file, "read_bytes %llu\n", (unsigned long long) stats->read_bytes);
+    for (int bit = 0; bit < LB_STATS_ERROR_BITS; bit++) {
+        fprintf(file, "read_errors_0x%x %llu\n", 1u << bit, (unsigned long long) stats->read_errors[bit]);
+    }
+    fprintf(file, "grow_events %llu\n", (unsigned long long) stats->grow_events);
+    fprintf(file, "grow_bytes_copied %llu\n", (unsigned long long) stats->grow_bytes_copied);
+    fprintf(file, "writer_seeks %llu\n", (unsigned long long) stats->writer_seeks);
+    fprintf(file, "reader_seeks %llu\n", (unsigned long long) stats->reader_seeks);
+    fprintf(file, "file_writes %llu\n", (unsigned long long) stats->file_writes);
+    fprintf(file, "file_reads %llu\n", (unsigned long long) stats->file_reads);
+    fprintf(file, "file_seeks %llu\n", (unsigned long long) stats->file_seeks);
+    fprintf(file, "arena_allocs %llu\n", (unsigned long long) stats->arena_allocs);
+    fprintf(file, "arena_bytes %llu\n", (unsigned long long) stats->arena_bytes);
+    fprintf(file, "arena_pages %llu\n", (unsigned long long) stats->arena_pages);
+    fprintf(file, "arena_page_walk %llu\n", (unsigned long long) stats->arena_page_walk);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_STATS_IMPLEMENTATION
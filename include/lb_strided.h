@@ -0,0 +1,385 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_STRIDED_H
+#define LB_STRIDED_H
+
+/*
+ * Writing one field of an array of structs as a contiguous column, and reading a column back into one.
+ *
+ * `base` points at the field in the first element and `stride` is the distance between elements in bytes, usually
+ * sizeof the struct:
+ *
+ *     typedef struct Entity { uint32_t id; float x, y, z; } Entity;
+ *     lbWriteStridedF32BE(&writer, &entities[0].x, sizeof(Entity), count);
+ *     lbReadStridedF32BE(&reader, &entities[0].x, sizeof(Entity), count);
+ *
+ * Buffer writers and readers are checked once for the whole column, which is then gathered straight into, or
+ * scattered straight out of, their memory by the dispatched kernels of lb_cpu.h: AVX2 and AVX-512 gathers with an
+ * in-register byte swap, and AVX-512 scatters. Other modes go through a small block on the stack.
+ *
+ * For quantized columns see lbWriteQuantizerStridedF32 in lb_quantize.h.
+ *
+ * Define LB_STRIDED_IMPLEMENTATION (implied by LB_BUFFER_IMPLEMENTATION) in exactly one translation unit.
+ */
+
+#include "lb_writer.h"
+#include "lb_reader.h"
+#include "lb_cpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Write `count` values read from base, base + stride, base + 2 * stride... with `stride` in bytes.
+ *
+ * @return LB_WRITER_ERROR_FULL if the writer cannot take the whole column, in which case a buffer writer is unchanged.
+ *         File writers may have written part of it.
+ */
+LB_WriterError lbWriteStridedU32(LB_Writer *writer, const uint32_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedU32LE(LB_Writer *writer, const uint32_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedU32BE(LB_Writer *writer, const uint32_t *base, size_t stride, size_t count);
+
+LB_WriterError lbWriteStridedI32(LB_Writer *writer, const int32_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedI32LE(LB_Writer *writer, const int32_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedI32BE(LB_Writer *writer, const int32_t *base, size_t stride, size_t count);
+
+LB_WriterError lbWriteStridedF32(LB_Writer *writer, const float *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedF32LE(LB_Writer *writer, const float *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedF32BE(LB_Writer *writer, const float *base, size_t stride, size_t count);
+
+LB_WriterError lbWriteStridedU64(LB_Writer *writer, const uint64_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedU64LE(LB_Writer *writer, const uint64_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedU64BE(LB_Writer *writer, const uint64_t *base, size_t stride, size_t count);
+
+LB_WriterError lbWriteStridedI64(LB_Writer *writer, const int64_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedI64LE(LB_Writer *writer, const int64_t *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedI64BE(LB_Writer *writer, const int64_t *base, size_t stride, size_t count);
+
+LB_WriterError lbWriteStridedF64(LB_Writer *writer, const double *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedF64LE(LB_Writer *writer, const double *base, size_t stride, size_t count);
+LB_WriterError lbWriteStridedF64BE(LB_Writer *writer, const double *base, size_t stride, size_t count);
+
+/**
+ * Read `count` values into base, base + stride, base + 2 * stride... with `stride` in bytes and at least the size of
+ * the value.
+ *
+ * @return LB_READER_ERROR_END if fewer values remain, in which case a buffer reader is unchanged. Other modes may have
+ *         stored part of the column.
+ */
+LB_ReaderError lbReadStridedU32(LB_Reader *reader, uint32_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedU32LE(LB_Reader *reader, uint32_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedU32BE(LB_Reader *reader, uint32_t *base, size_t stride, size_t count);
+
+LB_ReaderError lbReadStridedI32(LB_Reader *reader, int32_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedI32LE(LB_Reader *reader, int32_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedI32BE(LB_Reader *reader, int32_t *base, size_t stride, size_t count);
+
+LB_ReaderError lbReadStridedF32(LB_Reader *reader, float *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedF32LE(LB_Reader *reader, float *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedF32BE(LB_Reader *reader, float *base, size_t stride, size_t count);
+
+LB_ReaderError lbReadStridedU64(LB_Reader *reader, uint64_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedU64LE(LB_Reader *reader, uint64_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedU64BE(LB_Reader *reader, uint64_t *base, size_t stride, size_t count);
+
+LB_ReaderError lbReadStridedI64(LB_Reader *reader, int64_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedI64LE(LB_Reader *reader, int64_t *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedI64BE(LB_Reader *reader, int64_t *base, size_t stride, size_t count);
+
+LB_ReaderError lbReadStridedF64(LB_Reader *reader, double *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedF64LE(LB_Reader *reader, double *base, size_t stride, size_t count);
+LB_ReaderError lbReadStridedF64BE(LB_Reader *reader, double *base, size_t stride, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_STRIDED_H
+
+#if defined(LB_STRIDED_IMPLEMENTATION) && !defined(LB_STRIDED_IMPLEMENTED)
+#define LB_STRIDED_IMPLEMENTED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LB_STRIDED_BLOCK 4096
+
+#define LB_STRIDED_SWAP_NATIVE 0
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LB_STRIDED_SWAP_LE 0
+#define LB_STRIDED_SWAP_BE 1
+#else
+#define LB_STRIDED_SWAP_LE 1
+#define LB_STRIDED_SWAP_BE 0
+#endif
+
+static LB_WriterError lbWriteStrided(LB_Writer *writer, const void *base, const size_t stride, size_t count,
+                                     const size_t width, const int swap) {
+#ifdef LB_WRITER_SAFETY
+    if (writer == NULL) {
+        return LB_WRITER_ERROR_WRITER_NULL;
+    }
+
+    if (base == NULL && count > 0) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+#endif
+
+    const LB_CpuKernels *kernels = lbCpuKernels();
+    void (*gather)(const void *, size_t, void *, size_t, int) = width == 4 ? kernels->gather_32 : kernels->gather_64;
+    if (count > SIZE_MAX / width) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    // Buffer writers: one check, then gather straight into their memory. Counted as one lbWrite of the column.
+    if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+        LB_WriterBuffer *buffer = &writer->_.buffer;
+        const size_t length = count * width;
+        LB_STATS_ADD(write_calls, 1);
+        LB_PROFILE_RECORD(LB_PROFILE_OP_WRITE, length);
+        LB_STATS_ADD(write_bytes, length);
+        if (length > buffer->length - buffer->position) {
+            const LB_WriterError e = lbWriterGrow(writer, buffer->position + length);
+            if (e) {
+                LB_STATS_ERRORS(write_errors, e);
+                LB_PROBE2(write_error, e, length);
+                return e;
+            }
+        }
+
+        gather(base, stride, (uint8_t *) buffer->data + buffer->position, count, swap);
+        buffer->position += length;
+        return LB_WRITER_ERROR_NONE;
+    }
+
+    uint8_t block[LB_STRIDED_BLOCK];
+    const uint8_t *in = (const uint8_t *) base;
+    while (count > 0) {
+        const size_t batch = count < sizeof(block) / width ? count : sizeof(block) / width;
+        gather(in, stride, block, batch, swap);
+        const LB_WriterError e = lbWrite(writer, block, batch * width);
+        if (e) {
+            return e;
+        }
+
+        in += batch * stride;
+        count -= batch;
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
+
+static LB_ReaderError lbReadStrided(LB_Reader *reader, void *base, const size_t stride, size_t count,
+                                    const size_t width, const int swap) {
+#ifdef LB_READER_SAFETY
+    if (reader == NULL) {
+        return LB_READER_ERROR_READER_NULL;
+    }
+
+    if (base == NULL && count > 0) {
+        return LB_READER_ERROR_INVALID_VALUE;
+    }
+#endif
+
+    const LB_CpuKernels *kernels = lbCpuKernels();
+    void (*scatter)(const void *, void *, size_t, size_t, int) = width == 4 ? kernels->scatter_32 : kernels->scatter_64;
+    if (count > SIZE_MAX / width) {
+        return LB_READER_ERROR_END;
+    }
+
+    // Buffer readers: one check, then scatter straight out of their memory. Counted as one lbRead of the column.
+    if (reader->_.mode == LB_READER_MODE_BUFFER) {
+        LB_ReaderBuffer *buffer = &reader->_.buffer;
+        const size_t length = count * width;
+        LB_STATS_ADD(read_calls, 1);
+        LB_PROFILE_RECORD(LB_PROFILE_OP_READ, length);
+        LB_STATS_ADD(read_bytes, length);
+        if (length > buffer->length - buffer->position) {
+            LB_STATS_ERRORS(read_errors, LB_READER_ERROR_END);
+            LB_PROBE2(read_error, LB_READER_ERROR_END, length);
+            return LB_READER_ERROR_END;
+        }
+
+        scatter((const uint8_t *) buffer->data + buffer->position, base, stride, count, swap);
+        buffer->position += length;
+        return LB_READER_ERROR_NONE;
+    }
+
+    uint8_t block[LB_STRIDED_BLOCK];
+    uint8_t *out = (uint8_t *) base;
+    while (count > 0) {
+        const size_t batch = count < sizeof(block) / width ? count : sizeof(block) / width;
+        const LB_ReaderError e = lbRead(reader, block, batch * width);
+        if (e) {
+            return e;
+        }
+
+        scatter(block, out, stride, batch, swap);
+        out += batch * stride;
+        count -= batch;
+    }
+
+    return LB_READER_ERROR_NONE;
+}
+
+LB_WriterError lbWriteStridedU32(LB_Writer *writer, const uint32_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_WriterError lbWriteStridedU32LE(LB_Writer *writer, const uint32_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_WriterError lbWriteStridedU32BE(LB_Writer *writer, const uint32_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_WriterError lbWriteStridedI32(LB_Writer *writer, const int32_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_WriterError lbWriteStridedI32LE(LB_Writer *writer, const int32_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_WriterError lbWriteStridedI32BE(LB_Writer *writer, const int32_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_WriterError lbWriteStridedF32(LB_Writer *writer, const float *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_WriterError lbWriteStridedF32LE(LB_Writer *writer, const float *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_WriterError lbWriteStridedF32BE(LB_Writer *writer, const float *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_WriterError lbWriteStridedU64(LB_Writer *writer, const uint64_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_WriterError lbWriteStridedU64LE(LB_Writer *writer, const uint64_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_WriterError lbWriteStridedU64BE(LB_Writer *writer, const uint64_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_WriterError lbWriteStridedI64(LB_Writer *writer, const int64_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_WriterError lbWriteStridedI64LE(LB_Writer *writer, const int64_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_WriterError lbWriteStridedI64BE(LB_Writer *writer, const int64_t *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_WriterError lbWriteStridedF64(LB_Writer *writer, const double *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_WriterError lbWriteStridedF64LE(LB_Writer *writer, const double *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_WriterError lbWriteStridedF64BE(LB_Writer *writer, const double *base, const size_t stride, const size_t count) {
+    return lbWriteStrided(writer, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_ReaderError lbReadStridedU32(LB_Reader *reader, uint32_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_ReaderError lbReadStridedU32LE(LB_Reader *reader, uint32_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_ReaderError lbReadStridedU32BE(LB_Reader *reader, uint32_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_ReaderError lbReadStridedI32(LB_Reader *reader, int32_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_ReaderError lbReadStridedI32LE(LB_Reader *reader, int32_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_ReaderError lbReadStridedI32BE(LB_Reader *reader, int32_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_ReaderError lbReadStridedF32(LB_Reader *reader, float *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_ReaderError lbReadStridedF32LE(LB_Reader *reader, float *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_ReaderError lbReadStridedF32BE(LB_Reader *reader, float *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_ReaderError lbReadStridedU64(LB_Reader *reader, uint64_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_ReaderError lbReadStridedU64LE(LB_Reader *reader, uint64_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_ReaderError lbReadStridedU64BE(LB_Reader *reader, uint64_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_ReaderError lbReadStridedI64(LB_Reader *reader, int64_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_ReaderError lbReadStridedI64LE(LB_Reader *reader, int64_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_ReaderError lbReadStridedI64BE(LB_Reader *reader, int64_t *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+
+LB_ReaderError lbReadStridedF64(LB_Reader *reader, double *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_NATIVE);
+}
+
+LB_ReaderError lbReadStridedF64LE(LB_Reader *reader, double *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_LE);
+}
+
+LB_ReaderError lbReadStridedF64BE(LB_Reader *reader, double *base, const size_t stride, const size_t count) {
+    return lbReadStrided(reader, base, stride, count, sizeof(*base), LB_STRIDED_SWAP_BE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LB_STRIDED_IMPLEMENTATION
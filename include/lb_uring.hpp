@@ -0,0 +1,630 @@
+#ifndef LB_URING_HPP
+#define LB_URING_HPP
+
+/*
+ * C++20 coroutine reader and writer over io_uring, for files and sockets. Linux 5.6 or newer.
+ *
+ * A decoder stays straight-line code over the regular LB_Reader / LB_Writer functions, and suspends instead of
+ * blocking a thread while it waits for bytes to arrive or leave. Thousands of streams can share one thread and one
+ * ring:
+ *
+ *     lb::Task<> session(lb::Ring &ring, int socket) {
+ *         lb::AsyncReader reader(ring, socket);
+ *         lb::AsyncWriter writer(ring, socket);
+ *         while (co_await reader.require(4) == LB_READER_ERROR_NONE) {
+ *             const uint32_t length = lbReadU32LE(reader.get(), NULL);
+ *             if (co_await reader.require(length)) {
+ *                 break;
+ *             }
+ *             ... decode `length` bytes from reader.get(), encode the reply into writer.get() ...
+ *             if (co_await writer.flush()) {
+ *                 break;
+ *             }
+ *         }
+ *         close(socket);
+ *     }
+ *
+ *     lb::Ring ring;
+ *     ring.spawn(session(ring, socket));
+ *     ring.run();
+ *
+ * AsyncReader::get() is a buffer reader over the bytes received and not yet consumed; require(n) suspends until at
+ * least n of them are available. Positions are relative to that window, which moves as require() compacts it, so do
+ * not seek back across a require(). AsyncWriter::get() is a dynamic buffer writer; flush() suspends until its contents
+ * have been written out and then rewinds it.
+ *
+ * The ring is driven by raw system calls, liburing is not needed. It is single threaded: a Ring, and every reader,
+ * writer and task using it, belong to the thread calling run(). Header-only, the C functions used here are inline.
+ */
+
+#if !defined(__linux__)
+#error "lb_uring.hpp requires Linux"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <utility>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "lb_buffer.h"
+
+namespace lb {
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    // Resumed when the task finishes, if it was awaited.
+    std::coroutine_handle<> continuation;
+    // Spawned tasks have no owner and free themselves when they finish.
+    bool detached = false;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <class P>
+        std::coroutine_handle<> await_suspend(const std::coroutine_handle<P> handle) noexcept {
+            TaskPromiseBase &promise = handle.promise();
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+
+            if (promise.detached) {
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {
+        }
+    };
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    // Like the C API, nothing here throws. An escaping exception is a bug in the task.
+    void unhandled_exception() const noexcept {
+        std::terminate();
+    }
+};
+
+template <class T>
+struct TaskPromise : TaskPromiseBase {
+    T value{};
+
+    Task<T> get_return_object() noexcept;
+
+    void return_value(T result) noexcept {
+        value = std::move(result);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {
+    }
+};
+
+} // namespace detail
+
+// A lazily started coroutine: it runs when awaited, or when handed to Ring::spawn.
+template <class T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(const std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        std::swap(handle_, other.handle_);
+        return *this;
+    }
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return !handle_ || handle_.done();
+    }
+
+    std::coroutine_handle<> await_suspend(const std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+
+    T await_resume() noexcept {
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(handle_.promise().value);
+        }
+    }
+
+    // Give up ownership, see Ring::spawn.
+    std::coroutine_handle<promise_type> release() noexcept {
+        return std::exchange(handle_, nullptr);
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <class T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+} // namespace detail
+
+class Ring;
+
+// One read or write in flight. co_await yields the result: a byte count, or a negated errno.
+class [[nodiscard]] Operation {
+public:
+    Operation(Ring &ring, const io_uring_sqe &sqe) noexcept : ring_(ring), sqe_(sqe) {
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    // Defined after Ring. Resumes immediately with the error if the operation cannot be queued.
+    bool await_suspend(std::coroutine_handle<> handle) noexcept;
+
+    int await_resume() const noexcept {
+        return result_;
+    }
+
+private:
+    friend class Ring;
+
+    Ring &ring_;
+    io_uring_sqe sqe_;
+    std::coroutine_handle<> handle_;
+    int result_ = 0;
+};
+
+class Ring {
+public:
+    // Set up a ring with room for `entries` queued submissions. On failure see valid() and error().
+    explicit Ring(const unsigned entries = 256) noexcept {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            error_ = errno;
+            return;
+        }
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+
+        sq_ring_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                        IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            sq_ring_ = nullptr;
+            error_ = errno;
+            return;
+        }
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cq_ring_ = sq_ring_;
+        } else {
+            cq_ring_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                            IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED) {
+                cq_ring_ = nullptr;
+                error_ = errno;
+                return;
+            }
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                          IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            error_ = errno;
+            return;
+        }
+        sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+        uint8_t *sq = static_cast<uint8_t *>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_entries_ = params.sq_entries;
+
+        // Slot i of the indirection array always names SQE i, so SQEs are filled in ring order.
+        unsigned *array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        for (unsigned i = 0; i < sq_entries_; i++) {
+            array[i] = i;
+        }
+
+        uint8_t *cq = static_cast<uint8_t *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        tail_ = *sq_tail_;
+    }
+
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    ~Ring() {
+        if (sqes_) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_size_);
+        }
+        if (sq_ring_) {
+            munmap(sq_ring_, sq_size_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    [[nodiscard]] bool valid() const noexcept {
+        return sqes_ != nullptr;
+    }
+
+    // The errno of the failed setup, 0 if valid.
+    [[nodiscard]] int error() const noexcept {
+        return error_;
+    }
+
+    // Read up to `length` bytes at `offset`, or at the file position for UINT64_MAX (the only choice for sockets).
+    Operation read(const int fd, void *data, const size_t length, const uint64_t offset = UINT64_MAX) noexcept {
+        return Operation(*this, prepare(IORING_OP_READ, fd, data, length, offset));
+    }
+
+    Operation write(const int fd, const void *data, const size_t length,
+                    const uint64_t offset = UINT64_MAX) noexcept {
+        return Operation(*this, prepare(IORING_OP_WRITE, fd, data, length, offset));
+    }
+
+    // Start `task` now. It runs on this ring until it finishes, then frees itself.
+    void spawn(Task<> task) noexcept {
+        const std::coroutine_handle<detail::TaskPromise<void>> handle = task.release();
+        if (handle) {
+            handle.promise().detached = true;
+            handle.resume();
+        }
+    }
+
+    // Submit and complete operations, resuming their coroutines, until none are left in flight.
+    void run() noexcept {
+        while (in_flight_ > 0) {
+            if (enter(IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EBUSY) {
+                return;
+            }
+            complete();
+        }
+    }
+
+    // Operations queued or running.
+    [[nodiscard]] size_t inFlight() const noexcept {
+        return in_flight_;
+    }
+
+private:
+    friend class Operation;
+
+    static io_uring_sqe prepare(const uint8_t opcode, const int fd, const void *data, const size_t length,
+                                const uint64_t offset) noexcept {
+        io_uring_sqe sqe;
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uintptr_t>(data);
+        // A single operation transfers at most 1 GiB, callers loop on short counts anyway.
+        sqe.len = static_cast<uint32_t>(length < (size_t{1} << 30) ? length : size_t{1} << 30);
+        sqe.off = offset;
+        return sqe;
+    }
+
+    // Queue `operation`, submitting what is already queued first if the ring is full.
+    int queue(Operation *operation) noexcept {
+        if (!valid()) {
+            return -(error_ ? error_ : ENXIO);
+        }
+
+        while (tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            if (enter(0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                return -errno;
+            }
+            complete();
+        }
+
+        io_uring_sqe *sqe = &sqes_[tail_ & sq_mask_];
+        *sqe = operation->sqe_;
+        sqe->user_data = reinterpret_cast<uintptr_t>(operation);
+        tail_++;
+        __atomic_store_n(sq_tail_, tail_, __ATOMIC_RELEASE);
+        queued_++;
+        in_flight_++;
+        return 0;
+    }
+
+    int enter(const unsigned flags) noexcept {
+        const long submitted = syscall(__NR_io_uring_enter, fd_, queued_, flags ? 1 : 0, flags, nullptr, 0);
+        if (submitted > 0) {
+            queued_ -= static_cast<unsigned>(submitted);
+        }
+        return static_cast<int>(submitted);
+    }
+
+    void complete() noexcept {
+        // The head is reloaded every time: a resumed coroutine that finds the SQ full completes work itself.
+        unsigned head;
+        while ((head = *cq_head_) != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+            Operation *operation = reinterpret_cast<Operation *>(static_cast<uintptr_t>(cqe->user_data));
+            operation->result_ = cqe->res;
+
+            // Release the slot before resuming, the coroutine may queue more work.
+            __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+            in_flight_--;
+            operation->handle_.resume();
+        }
+    }
+
+    int fd_ = -1;
+    int error_ = 0;
+
+    void *sq_ring_ = nullptr;
+    void *cq_ring_ = nullptr;
+    size_t sq_size_ = 0;
+    size_t cq_size_ = 0;
+    size_t sqes_size_ = 0;
+
+    io_uring_sqe *sqes_ = nullptr;
+    unsigned *sq_head_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+
+    io_uring_cqe *cqes_ = nullptr;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    // Our copy of the SQ tail, queued but not yet submitted, and queued or submitted but not completed.
+    unsigned tail_ = 0;
+    unsigned queued_ = 0;
+    size_t in_flight_ = 0;
+};
+
+inline bool Operation::await_suspend(const std::coroutine_handle<> handle) noexcept {
+    handle_ = handle;
+    result_ = ring_.queue(this);
+    return result_ == 0;
+}
+
+class AsyncReader {
+public:
+    // Read from `fd` at the file position, or starting at `offset` for a file read by offset.
+    AsyncReader(Ring &ring, const int fd, const size_t initial_capacity = 4096,
+                const uint64_t offset = UINT64_MAX) noexcept
+        : ring_(ring), fd_(fd), offset_(offset),
+          data_(static_cast<uint8_t *>(std::malloc(initial_capacity ? initial_capacity : 1))),
+          capacity_(data_ ? (initial_capacity ? initial_capacity : 1) : 0) {
+        reset(0, 0);
+    }
+
+    AsyncReader(const AsyncReader &) = delete;
+    AsyncReader &operator=(const AsyncReader &) = delete;
+
+    ~AsyncReader() {
+        std::free(data_);
+    }
+
+    [[nodiscard]] bool valid() const noexcept {
+        return data_ != nullptr;
+    }
+
+    // The errno of the last failed read, 0 if none failed.
+    [[nodiscard]] int error() const noexcept {
+        return error_;
+    }
+
+    // A buffer reader over the bytes received and not yet consumed.
+    LB_Reader *get() noexcept {
+        return &reader_;
+    }
+
+    /**
+     * Suspend until at least `length` unconsumed bytes are available through get(). <br>
+     * Returns LB_READER_ERROR_END if the stream ends or fails first (see error()), the bytes already received stay
+     * readable.
+     */
+    Task<LB_ReaderError> require(const size_t length) {
+        if (lbReaderRemaining(&reader_) >= length) {
+            co_return LB_READER_ERROR_NONE;
+        }
+
+        if (data_ == nullptr) {
+            co_return LB_READER_ERROR_DATA_NULL;
+        }
+
+        // Move what is left to the front, and make room for the rest.
+        const size_t position = reader_._.buffer.position;
+        size_t end = reader_._.buffer.length - position;
+        std::memmove(data_, data_ + position, end);
+        if (capacity_ < length) {
+            size_t capacity = capacity_;
+            while (capacity < length) {
+                capacity *= 2;
+            }
+
+            uint8_t *data = static_cast<uint8_t *>(std::realloc(data_, capacity));
+            if (data == nullptr) {
+                reset(0, end);
+                co_return LB_READER_ERROR_DATA_NULL;
+            }
+            data_ = data;
+            capacity_ = capacity;
+        }
+        reset(0, end);
+
+        while (end < length) {
+            const int result = co_await ring_.read(fd_, data_ + end, capacity_ - end, offset_);
+            if (result == -EINTR || result == -EAGAIN) {
+                continue;
+            }
+
+            if (result <= 0) {
+                error_ = -result;
+                co_return LB_READER_ERROR_END;
+            }
+
+            end += static_cast<size_t>(result);
+            if (offset_ != UINT64_MAX) {
+                offset_ += static_cast<uint64_t>(result);
+            }
+            reset(0, end);
+        }
+
+        co_return LB_READER_ERROR_NONE;
+    }
+
+private:
+    // Set the fields directly, lbReaderInitBuffer rejects an empty buffer.
+    void reset(const size_t position, const size_t length) noexcept {
+        reader_._.mode = LB_READER_MODE_BUFFER;
+        reader_._.buffer.data = data_;
+        reader_._.buffer.length = length;
+        reader_._.buffer.position = position;
+    }
+
+    Ring &ring_;
+    int fd_;
+    int error_ = 0;
+    uint64_t offset_;
+    uint8_t *data_;
+    size_t capacity_;
+    LB_Reader reader_;
+};
+
+class AsyncWriter {
+public:
+    // Write to `fd` at the file position, or starting at `offset` for a file written by offset.
+    AsyncWriter(Ring &ring, const int fd, const size_t initial_capacity = 4096,
+                const uint64_t offset = UINT64_MAX) noexcept
+        : ring_(ring), fd_(fd), offset_(offset) {
+        valid_ = lbWriterInitDynamicBuffer(&writer_, initial_capacity ? initial_capacity : 1) ==
+                 LB_WRITER_INIT_NONE;
+    }
+
+    AsyncWriter(const AsyncWriter &) = delete;
+    AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+    ~AsyncWriter() {
+        if (valid_) {
+            lbWriterFree(&writer_);
+        }
+    }
+
+    [[nodiscard]] bool valid() const noexcept {
+        return valid_;
+    }
+
+    // The errno of the last failed write, 0 if none failed.
+    [[nodiscard]] int error() const noexcept {
+        return error_;
+    }
+
+    // A dynamic buffer writer, emptied by flush().
+    LB_Writer *get() noexcept {
+        return &writer_;
+    }
+
+    /**
+     * Suspend until everything written through get() is out, then rewind. <br>
+     * Returns LB_WRITER_ERROR_FULL if the descriptor fails or stops accepting data (see error()). What was not
+     * written stays at the start of the buffer, so a later flush() retries it.
+     */
+    Task<LB_WriterError> flush() {
+        if (!valid_) {
+            co_return LB_WRITER_ERROR_DATA_NULL;
+        }
+
+        uint8_t *data = static_cast<uint8_t *>(lbWriterData(&writer_));
+        const size_t length = lbWriterPosition(&writer_);
+        size_t written = 0;
+        while (written < length) {
+            const int result = co_await ring_.write(fd_, data + written, length - written, offset_);
+            if (result == -EINTR || result == -EAGAIN) {
+                continue;
+            }
+
+            if (result <= 0) {
+                error_ = -result;
+                std::memmove(data, data + written, length - written);
+                writer_._.buffer.position = length - written;
+                co_return LB_WRITER_ERROR_FULL;
+            }
+
+            written += static_cast<size_t>(result);
+            if (offset_ != UINT64_MAX) {
+                offset_ += static_cast<uint64_t>(result);
+            }
+        }
+
+        writer_._.buffer.position = 0;
+        co_return LB_WRITER_ERROR_NONE;
+    }
+
+private:
+    Ring &ring_;
+    int fd_;
+    int error_ = 0;
+    bool valid_ = false;
+    uint64_t offset_;
+    LB_Writer writer_;
+};
+
+} // namespace lb
+
+#endif //LB_URING_HPP
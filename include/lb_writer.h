@@ -15,8 +15,32 @@ extern "C" {
 #ifndef LB_WRITER_NO_SAFETY
 #define LB_WRITER_SAFETY
 #endif
+
+// Linkage of the functions below. With LB_BUFFER_STATIC every translation unit gets its own static copy, so the
+// compiler can always inline them without link-time optimization. The implementation redeclarations are then skipped,
+// a static function has no external definition to provide. The functions that are not inline, such as lbCpu*,
+// lbWriterCopyFrom, lbWriteStrided* and the stats and profile functions, still need one translation unit defining
+// LB_BUFFER_IMPLEMENTATION, or lb_buffer_static / lb_buffer_shared.
+#ifndef LB_INLINE
+#ifdef LB_BUFFER_STATIC
+#define LB_INLINE static inline
+#else
+#define LB_INLINE inline
+#endif
+#endif
 #include <stdlib.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LB_WRITER_STREAMING_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "lb_file.h"
+#include "lb_stats.h"
+#include "lb_histogram.h"
+#include "lb_probes.h"
+#include "lb_profile.h"
+
 typedef enum LB_WriterMode {
     LB_WRITER_MODE_BUFFER = 0x01,
     LB_WRITER_MODE_FILE = 0x02,
@@ -37,7 +61,7 @@ typedef enum LB_WriterInitError {
     LB_WRITER_INIT_LENGTH_ZERO = 0x8,
 } LB_WriterInitError;
 
-inline const char* lbWriterInitErrorName(const LB_WriterInitError e) {
+LB_INLINE const char* lbWriterInitErrorName(const LB_WriterInitError e) {
     switch (e) {
         case LB_WRITER_INIT_NONE:
             return "LB_WRITER_INIT_NONE";
@@ -54,7 +78,7 @@ inline const char* lbWriterInitErrorName(const LB_WriterInitError e) {
     }
 }
 
-inline const char* lbWriterInitErrorMessage(const LB_WriterInitError e) {
+LB_INLINE const char* lbWriterInitErrorMessage(const LB_WriterInitError e) {
     switch (e) {
         case LB_WRITER_INIT_NONE:
             return "No error.";
@@ -86,7 +110,20 @@ typedef enum LB_WriterError {
     LB_WRITER_ERROR_INVALID_VALUE = 0x8,
 } LB_WriterError;
 
-inline const char* lbWriterErrorName(const LB_WriterError e) {
+#ifdef __cplusplus
+// The enums above are bit flags. C converts the int result of `|` back implicitly, C++ needs the operators.
+extern "C++" {
+#define LB_WRITER_FLAG_OPERATORS(type) \
+    inline type operator|(const type a, const type b) { return (type) ((int) a | (int) b); } \
+    inline type &operator|=(type &a, const type b) { return a = a | b; }
+LB_WRITER_FLAG_OPERATORS(LB_WriterMode)
+LB_WRITER_FLAG_OPERATORS(LB_WriterInitError)
+LB_WRITER_FLAG_OPERATORS(LB_WriterError)
+#undef LB_WRITER_FLAG_OPERATORS
+}
+#endif
+
+LB_INLINE const char* lbWriterErrorName(const LB_WriterError e) {
     switch (e) {
         case LB_WRITER_ERROR_NONE:
             return "LB_WRITER_ERROR_NONE";
@@ -103,7 +140,7 @@ inline const char* lbWriterErrorName(const LB_WriterError e) {
     }
 }
 
-inline const char* lbWriterErrorMessage(const LB_WriterError e) {
+LB_INLINE const char* lbWriterErrorMessage(const LB_WriterError e) {
     switch (e) {
         case LB_WRITER_ERROR_NONE:
             return "No error.";
@@ -124,11 +161,17 @@ typedef struct LB_WriterBuffer {
     void *data;
     size_t length;
     size_t position;
+    // Bytes reserved in front of `data` for `lbWritePrepend`.
+    size_t headroom;
+    // Writes of at least this many bytes bypass the cache, 0 if none do. See `lbWriterSetStreaming`.
+    size_t streaming_threshold;
 } LB_WriterBuffer;
 
 typedef struct LB_Writer {
     struct {
         LB_WriterMode mode;
+        // File writers only, see lbWriterSetUnlocked.
+        int unlocked;
 
         union {
             LB_WriterBuffer buffer;
@@ -149,7 +192,7 @@ typedef struct LB_Writer {
  * If 0 and LB_WRITER_SAFETY, will return LB_WRITER_INIT_LENGTH_ZERO.                 <br>
  * @return LB_WriterInitError An error code indicating the result of the initialization.
  */
-inline LB_WriterInitError lbWriterInitBuffer(LB_Writer *writer, void *data, const size_t length) {
+LB_INLINE LB_WriterInitError lbWriterInitBuffer(LB_Writer *writer, void *data, const size_t length) {
 #ifdef LB_WRITER_SAFETY
     LB_WriterInitError e = LB_WRITER_INIT_NONE;
     if (writer == NULL) {
@@ -177,6 +220,8 @@ inline LB_WriterInitError lbWriterInitBuffer(LB_Writer *writer, void *data, cons
                 .data = data,
                 .length = length,
                 .position = 0,
+                .headroom = 0,
+                .streaming_threshold = 0,
             },
         },
     };
@@ -193,7 +238,7 @@ inline LB_WriterInitError lbWriterInitBuffer(LB_Writer *writer, void *data, cons
  * If NULL and LB_WRITER_SAFETY, will return LB_WRITER_INIT_INVALID_FILE.                <br>
  * @return LB_WriterInitError An error code indicating the result of the initialization.
  */
-inline LB_WriterInitError lbWriterInitFile(LB_Writer *writer, FILE *file) {
+LB_INLINE LB_WriterInitError lbWriterInitFile(LB_Writer *writer, FILE *file) {
 #ifdef LB_WRITER_SAFETY
     LB_WriterInitError e = LB_WRITER_INIT_NONE;
     if (file == NULL) {
@@ -214,7 +259,7 @@ inline LB_WriterInitError lbWriterInitFile(LB_Writer *writer, FILE *file) {
     return LB_WRITER_INIT_NONE;
 }
 
-inline LB_WriterInitError lbWriterInitDynamicBuffer(LB_Writer *writer, size_t initial_capacity) {
+LB_INLINE LB_WriterInitError lbWriterInitDynamicBuffer(LB_Writer *writer, size_t initial_capacity) {
     void* data = malloc(initial_capacity);
     if(data == NULL) {
         return LB_WRITER_INIT_DATA_NULL;
@@ -227,41 +272,110 @@ inline LB_WriterInitError lbWriterInitDynamicBuffer(LB_Writer *writer, size_t in
                 .data = data,
                 .length = initial_capacity,
                 .position = 0,
+                .headroom = 0,
+                .streaming_threshold = 0,
             }
         },
     };
     return LB_WRITER_INIT_NONE;
 }
 
-inline void lbWriterFree(LB_Writer *writer) {
+/**
+ * Initialize a buffer-mode LB_Writer that keeps the first `headroom` bytes of `data` free, so that
+ * outer layers can add their headers with `lbWritePrepend` instead of copying the payload.
+ *
+ * @param length The length of `data`, including the headroom.                           <br>
+ * If not greater than `headroom` and LB_WRITER_SAFETY, will return LB_WRITER_INIT_LENGTH_ZERO.
+ */
+LB_INLINE LB_WriterInitError lbWriterInitBufferHeadroom(LB_Writer *writer, void *data, const size_t length, const size_t headroom) {
+#ifdef LB_WRITER_SAFETY
+    if (length <= headroom) {
+        return LB_WRITER_INIT_LENGTH_ZERO;
+    }
+#endif
+
+    const LB_WriterInitError e = lbWriterInitBuffer(writer, (uint8_t *) data + headroom, length - headroom);
+    if (e) {
+        return e;
+    }
+
+    writer->_.buffer.headroom = headroom;
+    return LB_WRITER_INIT_NONE;
+}
+
+// Like `lbWriterInitDynamicBuffer`, with `headroom` bytes reserved in front of the data that are kept when growing.
+LB_INLINE LB_WriterInitError lbWriterInitDynamicBufferHeadroom(LB_Writer *writer, const size_t initial_capacity, const size_t headroom) {
+    void* base = malloc(headroom + initial_capacity);
+    if(base == NULL) {
+        return LB_WRITER_INIT_DATA_NULL;
+    }
+
+    *writer = (LB_Writer) {
+        ._ = {
+            .mode = LB_WRITER_MODE_DYNAMIC_BUFFER | LB_WRITER_MODE_BUFFER,
+            .buffer = {
+                .data = (uint8_t *) base + headroom,
+                .length = initial_capacity,
+                .position = 0,
+                .headroom = headroom,
+                .streaming_threshold = 0,
+            }
+        },
+    };
+    return LB_WRITER_INIT_NONE;
+}
+
+LB_INLINE void lbWriterFree(LB_Writer *writer) {
     if(writer->_.mode & LB_WRITER_MODE_DYNAMIC_BUFFER) {
-        free(writer->_.buffer.data);
+        free((uint8_t *) writer->_.buffer.data - writer->_.buffer.headroom);
     }
 }
 
+// Grow a dynamic buffer to at least `length` bytes, doubling its capacity. The headroom is kept.
+LB_INLINE LB_WriterError lbWriterGrow(LB_Writer *writer, const size_t length) {
+    if (!(writer->_.mode & LB_WRITER_MODE_DYNAMIC_BUFFER)) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    LB_WriterBuffer *buffer = &writer->_.buffer;
+    size_t new_length = buffer->length ? buffer->length * 2 : length;
+    while(new_length < length) {
+        new_length *= 2;
+    }
+
+    uint8_t *base = (uint8_t *) buffer->data - buffer->headroom;
+#ifdef LB_BUFFER_STATS
+    const uintptr_t old_base = (uintptr_t) base;
+#endif
+    LB_HISTOGRAM_BEGIN(grow_start);
+    void* new_base = realloc(base, buffer->headroom + new_length);
+    LB_HISTOGRAM_END(LB_HISTOGRAM_GROW, grow_start);
+    if(new_base == NULL) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    LB_STATS_ADD(grow_events, 1);
+    LB_PROBE2(writer_grow, buffer->length, new_length);
+#ifdef LB_BUFFER_STATS
+    if ((uintptr_t) new_base != old_base) {
+        LB_STATS_ADD(grow_bytes_copied, buffer->headroom + buffer->length);
+    }
+#endif
+
+    buffer->data = (uint8_t *) new_base + buffer->headroom;
+    buffer->length = new_length;
+    return LB_WRITER_ERROR_NONE;
+}
+
 #ifdef LB_WRITER_SAFETY
-inline LB_WriterError lbWriterCheckSafety(LB_Writer *writer, const void *value, const size_t length) {
+LB_INLINE LB_WriterError lbWriterCheckSafety(LB_Writer *writer, const void *value, const size_t length) {
     LB_WriterError e = LB_WRITER_ERROR_NONE;
     if (writer == NULL) {
         e |= LB_WRITER_ERROR_WRITER_NULL;
     } else if(writer->_.mode & LB_WRITER_MODE_BUFFER) {
         LB_WriterBuffer *buffer = &writer->_.buffer;
         if (buffer->position + length > buffer->length) {
-            if(writer->_.mode & LB_WRITER_MODE_DYNAMIC_BUFFER) {
-                size_t new_length = buffer->length * 2;
-                while(new_length < buffer->position + length) {
-                    new_length *= 2;
-                }
-                void* new_data = realloc(buffer->data, new_length);
-                if(new_data) {
-                    buffer->data = new_data;
-                    buffer->length = new_length;
-                } else {
-                    e |= LB_WRITER_ERROR_FULL;
-                }
-            } else {
-                e |= LB_WRITER_ERROR_FULL;
-            }
+            e |= lbWriterGrow(writer, buffer->position + length);
         }
 
         if (buffer->data == NULL) {
@@ -284,24 +398,15 @@ inline LB_WriterError lbWriterCheckSafety(LB_Writer *writer, const void *value,
 #define lbWriteSafety(writer, length, value) LB_WRITER_WRITE_NONE
 #endif
 
-inline LB_WriterError lbWriterSeek(LB_Writer *writer, const size_t position) {
+LB_INLINE LB_WriterError lbWriterSeek(LB_Writer *writer, const size_t position) {
+    LB_STATS_ADD(writer_seeks, 1);
+    LB_PROBE1(writer_seek, position);
     if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
         LB_WriterBuffer *buffer = &writer->_.buffer;
         if (position >= buffer->length) {
-            if(writer->_.mode & LB_WRITER_MODE_DYNAMIC_BUFFER) {
-                size_t new_length = buffer->length * 2;
-                while(new_length < position) {
-                    new_length *= 2;
-                }
-                void* new_data = realloc(buffer->data, new_length);
-                if(new_data) {
-                    buffer->data = new_data;
-                    buffer->length = new_length;
-                } else {
-                    return LB_WRITER_ERROR_FULL;
-                }
-            } else {
-                return LB_WRITER_ERROR_FULL;
+            const LB_WriterError e = lbWriterGrow(writer, position);
+            if (e) {
+                return e;
             }
         }
 
@@ -310,83 +415,215 @@ inline LB_WriterError lbWriterSeek(LB_Writer *writer, const size_t position) {
     }
 
     FILE *file = writer->_.file;
-    if (fseek(file, position, SEEK_SET) != 0) {
+    LB_STATS_ADD(file_seeks, 1);
+    if (LB_FILE_SEEK(file, position, SEEK_SET) != 0) {
         return LB_WRITER_ERROR_FULL;
     }
 
     return LB_WRITER_ERROR_NONE;
 }
 
-#define lbWriterTell lbWriterPosition
+/**
+ * Move the position by `offset` bytes, backwards if negative. <br>
+ * Buffer writers grow like lbWriterSeek. File writers seek relative to the current position, without a tell.
+ */
+LB_INLINE LB_WriterError lbWriterSeekRelative(LB_Writer *writer, const int64_t offset) {
+    if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+        const size_t position = writer->_.buffer.position;
+        if (offset < 0 && (uint64_t) -offset > position) {
+            return LB_WRITER_ERROR_FULL;
+        }
+
+        return lbWriterSeek(writer, position + (size_t) offset);
+    }
+
+    LB_STATS_ADD(writer_seeks, 1);
+    LB_STATS_ADD(file_seeks, 1);
+    if (LB_FILE_SEEK(writer->_.file, offset, SEEK_CUR) != 0) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
 
-inline size_t lbWriterPosition(const LB_Writer *writer) {
+// Push anything buffered by stdio to the file. Buffer mode writers have nothing to flush.
+LB_INLINE LB_WriterError lbWriterFlush(LB_Writer *writer) {
     if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
-        return writer->_.buffer.position;
+        return LB_WRITER_ERROR_NONE;
     }
 
-    FILE *file = writer->_.file;
-#ifdef _LARGEFILE64_SOURCE
-#ifdef _MSC_VER
-    return _ftelli64(file);
-#else
-    return ftello64(file);
-#endif
+    LB_HISTOGRAM_BEGIN(flush_start);
+    const int result = writer->_.unlocked ? LB_FILE_FLUSH_UNLOCKED(writer->_.file) : LB_FILE_FLUSH(writer->_.file);
+    LB_HISTOGRAM_END(LB_HISTOGRAM_FLUSH, flush_start);
+    if (result != 0) {
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    return LB_WRITER_ERROR_NONE;
+}
+
+/**
+ * Take the FILE lock of a file writer until lbWriterUnlock, so a sequence of writes is not interleaved with other
+ * threads' and each write does not lock again. Required around shared streams after lbWriterSetUnlocked. Does
+ * nothing for buffer writers.
+ */
+LB_INLINE void lbWriterLock(const LB_Writer *writer) {
+    if (!(writer->_.mode & LB_WRITER_MODE_BUFFER)) {
+        LB_FILE_LOCK(writer->_.file);
+    }
+}
+
+LB_INLINE void lbWriterUnlock(const LB_Writer *writer) {
+    if (!(writer->_.mode & LB_WRITER_MODE_BUFFER)) {
+        LB_FILE_UNLOCK(writer->_.file);
+    }
+}
+
+/**
+ * Make the writes of a file writer skip the FILE lock (fwrite_unlocked, _fwrite_nolock...), see lb_file.h. The stream
+ * must then not be used by another thread at the same time, unless every sequence of writes is bracketed by
+ * lbWriterLock / lbWriterUnlock. 0 turns it off, the default. Buffer writers ignore it.
+ */
+LB_INLINE void lbWriterSetUnlocked(LB_Writer *writer, const int unlocked) {
+    if (!(writer->_.mode & LB_WRITER_MODE_BUFFER)) {
+        writer->_.unlocked = unlocked != 0;
+    }
+}
+
+// A threshold for `lbWriterSetStreaming` well above what a cache-friendly write looks like.
+#define LB_WRITER_STREAMING_THRESHOLD (1024 * 1024)
+
+/**
+ * Make writes of at least `threshold` bytes use non-temporal stores, which go to memory without displacing the rest
+ * of the process's working set from the cache. For payloads that will not be read back soon, such as multi-GB
+ * serializations. 0 turns it off, the default. File writers ignore it.
+ */
+LB_INLINE void lbWriterSetStreaming(LB_Writer *writer, const size_t threshold) {
+    if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+        writer->_.buffer.streaming_threshold = threshold;
+    }
+}
+
+/**
+ * memcpy with non-temporal stores where the target has them (SSE2), followed by a store fence so the data is
+ * ordered like after a regular memcpy. Falls back to memcpy elsewhere.
+ */
+LB_INLINE void lbWriterStreamCopy(void *destination, const void *source, size_t length) {
+#ifdef LB_WRITER_STREAMING_SSE2
+    uint8_t *target = (uint8_t *) destination;
+    const uint8_t *from = (const uint8_t *) source;
+
+    // Streaming stores need 16-byte aligned destinations, the unaligned head goes through the cache.
+    size_t head = (16 - ((uintptr_t) target & 15)) & 15;
+    head = head < length ? head : length;
+    memcpy(target, from, head);
+    target += head;
+    from += head;
+    length -= head;
+
+    for (; length >= 64; target += 64, from += 64, length -= 64) {
+        const __m128i a = _mm_loadu_si128((const __m128i *) from);
+        const __m128i b = _mm_loadu_si128((const __m128i *) (from + 16));
+        const __m128i c = _mm_loadu_si128((const __m128i *) (from + 32));
+        const __m128i d = _mm_loadu_si128((const __m128i *) (from + 48));
+        _mm_stream_si128((__m128i *) target, a);
+        _mm_stream_si128((__m128i *) (target + 16), b);
+        _mm_stream_si128((__m128i *) (target + 32), c);
+        _mm_stream_si128((__m128i *) (target + 48), d);
+    }
+
+    for (; length >= 16; target += 16, from += 16, length -= 16) {
+        _mm_stream_si128((__m128i *) target, _mm_loadu_si128((const __m128i *) from));
+    }
+
+    memcpy(target, from, length);
+    _mm_sfence();
 #else
-    return ftell(file);
+    memcpy(destination, source, length);
 #endif
 }
 
-inline size_t lbWriterLength(const LB_Writer *writer) {
+#define lbWriterTell lbWriterPosition
+
+LB_INLINE size_t lbWriterPosition(const LB_Writer *writer) {
+    if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+        return writer->_.buffer.position;
+    }
+
+    return (size_t) LB_FILE_TELL(writer->_.file);
+}
+
+LB_INLINE size_t lbWriterLength(const LB_Writer *writer) {
     if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
         return writer->_.buffer.length;
     }
 
+    // The file grows as it is written, so unlike a file reader the length cannot be cached.
     FILE *file = writer->_.file;
-#ifdef _LARGEFILE64_SOURCE
-#ifdef _MSC_VER
-    const long long position = _ftelli64(file);
-    _fseeki64(file, 0, SEEK_END);
-    const long long end = _ftelli64(file);
-    _fseeki64(file, position, SEEK_SET);
-    return end;
-#else
-    const off64_t position = ftello64(file);
-    fseeko64(file, 0, SEEK_END);
-    const off64_t end = ftello64(file);
-    fseeko64(file, position, SEEK_SET);
-    return end;
-#endif
-#else
-    const long position = ftell(file);
-    fseek(file, 0, SEEK_END);
-    const long end = ftell(file);
-    fseek(file, position, SEEK_SET);
-    return end;
-#endif
+    const LB_FileOffset position = LB_FILE_TELL(file);
+    LB_FILE_SEEK(file, 0, SEEK_END);
+    const LB_FileOffset end = LB_FILE_TELL(file);
+    LB_FILE_SEEK(file, position, SEEK_SET);
+    return (size_t) end;
 }
 
-inline size_t lbWriterRemaining(const LB_Writer *writer) {
+LB_INLINE size_t lbWriterRemaining(const LB_Writer *writer) {
     return lbWriterLength(writer) - lbWriterPosition(writer);
 }
 
-inline LB_WriterError lbWriteUnsafe(LB_Writer *writer, const void *value, const size_t length) {
+// The first byte of a buffer-mode writer, including anything prepended. NULL in file mode.
+LB_INLINE void *lbWriterData(const LB_Writer *writer) {
+    if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+        return writer->_.buffer.data;
+    }
+
+    return NULL;
+}
+
+// The number of bytes that can still be prepended.
+LB_INLINE size_t lbWriterHeadroom(const LB_Writer *writer) {
+    if (writer->_.mode & LB_WRITER_MODE_BUFFER) {
+        return writer->_.buffer.headroom;
+    }
+
+    return 0;
+}
+
+LB_INLINE LB_WriterError lbWriteUnsafe(LB_Writer *writer, const void *value, const size_t length) {
     if(writer->_.mode & LB_WRITER_MODE_BUFFER) {
         LB_WriterBuffer *buffer = &writer->_.buffer;
-        memcpy(((uint8_t *) buffer->data) + buffer->position, value, length);
+        if (buffer->streaming_threshold && length >= buffer->streaming_threshold) {
+            lbWriterStreamCopy(((uint8_t *) buffer->data) + buffer->position, value, length);
+        } else {
+            memcpy(((uint8_t *) buffer->data) + buffer->position, value, length);
+        }
         buffer->position += length;
         return LB_WRITER_ERROR_NONE;
     }
 
-    if (fwrite(value, length, 1, writer->_.file) != 1) {
+    LB_STATS_ADD(file_writes, 1);
+    LB_HISTOGRAM_BEGIN(write_start);
+    const size_t written = writer->_.unlocked ? LB_FILE_WRITE_UNLOCKED(value, length, writer->_.file)
+                                              : LB_FILE_WRITE(value, length, writer->_.file);
+    LB_HISTOGRAM_END(LB_HISTOGRAM_FILE_WRITE, write_start);
+    LB_PROBE2(file_write, length, written);
+    if (written != 1) {
+        LB_STATS_ERRORS(write_errors, LB_WRITER_ERROR_FULL);
+        LB_PROBE2(write_error, LB_WRITER_ERROR_FULL, length);
         return LB_WRITER_ERROR_FULL; // TODO: What?
     }
     return LB_WRITER_ERROR_NONE;
 }
 
-inline LB_WriterError lbWrite(LB_Writer *writer, const void *value, const size_t length) {
+LB_INLINE LB_WriterError lbWrite(LB_Writer *writer, const void *value, const size_t length) {
+    LB_STATS_ADD(write_calls, 1);
+    LB_PROFILE_RECORD(LB_PROFILE_OP_WRITE, length);
+    LB_STATS_ADD(write_bytes, length);
 #ifdef LB_WRITER_SAFETY
     const LB_WriterError e = lbWriterCheckSafety(writer, value, length);
     if (e) {
+        LB_STATS_ERRORS(write_errors, e);
+        LB_PROBE2(write_error, e, length);
         return e;
     }
 #endif
@@ -394,7 +631,7 @@ inline LB_WriterError lbWrite(LB_Writer *writer, const void *value, const size_t
     return lbWriteUnsafe(writer, value, length);
 }
 
-inline LB_WriterError lbWriteReversedUnsafe(LB_Writer *writer, const void *value, const size_t length) {
+LB_INLINE LB_WriterError lbWriteReversedUnsafe(LB_Writer *writer, const void *value, const size_t length) {
     if(writer->_.mode & LB_WRITER_MODE_BUFFER) {
         LB_WriterBuffer *buffer = &writer->_.buffer;
         for (size_t i = 0; i < length; i++) {
@@ -405,20 +642,35 @@ inline LB_WriterError lbWriteReversedUnsafe(LB_Writer *writer, const void *value
         return LB_WRITER_ERROR_NONE;
     }
 
-    // TODO: Do NOT write one byte at a time!
+    // Timed as one file write, the per-byte calls are an implementation detail.
+    LB_HISTOGRAM_BEGIN(write_start);
+    FILE *file = writer->_.file;
     for (size_t i = 0; i < length; i++) {
-        if (fwrite(((uint8_t *) value) + length - 1 - i, 1, 1, writer->_.file) != 1) {
+        LB_STATS_ADD(file_writes, 1);
+        const uint8_t byte = ((const uint8_t *) value)[length - 1 - i];
+        if ((writer->_.unlocked ? LB_FILE_PUTC_UNLOCKED(byte, file) : LB_FILE_PUTC(byte, file)) == EOF) {
+            LB_HISTOGRAM_END(LB_HISTOGRAM_FILE_WRITE, write_start);
+            LB_PROBE2(file_write, length, 0);
+            LB_STATS_ERRORS(write_errors, LB_WRITER_ERROR_FULL);
+            LB_PROBE2(write_error, LB_WRITER_ERROR_FULL, length);
             return LB_WRITER_ERROR_FULL; // TODO: What?
         }
     }
 
+    LB_HISTOGRAM_END(LB_HISTOGRAM_FILE_WRITE, write_start);
+    LB_PROBE2(file_write, length, 1);
     return LB_WRITER_ERROR_NONE;
 }
 
-inline LB_WriterError lbWriteReversed(LB_Writer *writer, const void *value, const size_t length) {
+LB_INLINE LB_WriterError lbWriteReversed(LB_Writer *writer, const void *value, const size_t length) {
+    LB_STATS_ADD(write_calls, 1);
+    LB_PROFILE_RECORD(LB_PROFILE_OP_WRITE, length);
+    LB_STATS_ADD(write_bytes, length);
 #ifdef LB_WRITER_SAFETY
     const LB_WriterError e = lbWriterCheckSafety(writer, value, length);
     if (e) {
+        LB_STATS_ERRORS(write_errors, e);
+        LB_PROBE2(write_error, e, length);
         return e;
     }
 #endif
@@ -426,6 +678,99 @@ inline LB_WriterError lbWriteReversed(LB_Writer *writer, const void *value, cons
     return lbWriteReversedUnsafe(writer, value, length);
 }
 
+/*
+ * Prepend Functions
+ */
+
+/**
+ * Write `value` in front of everything written so far, taking the space from the headroom.   <br>
+ * The data moves back by `length` bytes, the position and everything after it stay in place.
+ *
+ * @return LB_WRITER_ERROR_FULL if the headroom is smaller than `length` or the writer is not a buffer.
+ */
+LB_INLINE LB_WriterError lbWritePrepend(LB_Writer *writer, const void *value, const size_t length) {
+    LB_STATS_ADD(write_calls, 1);
+    LB_PROFILE_RECORD(LB_PROFILE_OP_WRITE, length);
+    LB_STATS_ADD(write_bytes, length);
+#ifdef LB_WRITER_SAFETY
+    if (writer == NULL) {
+        LB_STATS_ERRORS(write_errors, LB_WRITER_ERROR_WRITER_NULL);
+        LB_PROBE2(write_error, LB_WRITER_ERROR_WRITER_NULL, length);
+        return LB_WRITER_ERROR_WRITER_NULL;
+    }
+
+    if (value == NULL) {
+        LB_STATS_ERRORS(write_errors, LB_WRITER_ERROR_INVALID_VALUE);
+        LB_PROBE2(write_error, LB_WRITER_ERROR_INVALID_VALUE, length);
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+#endif
+
+    if (!(writer->_.mode & LB_WRITER_MODE_BUFFER) || writer->_.buffer.headroom < length) {
+        LB_STATS_ERRORS(write_errors, LB_WRITER_ERROR_FULL);
+        LB_PROBE2(write_error, LB_WRITER_ERROR_FULL, length);
+        return LB_WRITER_ERROR_FULL;
+    }
+
+    LB_WriterBuffer *buffer = &writer->_.buffer;
+    buffer->data = (uint8_t *) buffer->data - length;
+    buffer->headroom -= length;
+    buffer->length += length;
+    buffer->position += length;
+    memcpy(buffer->data, value, length);
+    return LB_WRITER_ERROR_NONE;
+}
+
+// Prepends `value` byte-reversed, for single values of up to 16 bytes.
+LB_INLINE LB_WriterError lbWritePrependReversed(LB_Writer *writer, const void *value, const size_t length) {
+    uint8_t reversed[16];
+    if (length > sizeof(reversed)) {
+        return LB_WRITER_ERROR_INVALID_VALUE;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        reversed[i] = *((const uint8_t *) value + length - 1 - i);
+    }
+
+    return lbWritePrepend(writer, reversed, length);
+}
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define lbWritePrependLE lbWritePrepend
+#define lbWritePrependBE lbWritePrependReversed
+#else
+#define lbWritePrependLE lbWritePrependReversed
+#define lbWritePrependBE lbWritePrepend
+#endif
+
+LB_INLINE LB_WriterError lbWritePrependU8(LB_Writer *writer, const uint8_t value) {
+    return lbWritePrepend(writer, &value, sizeof(value));
+}
+
+LB_INLINE LB_WriterError lbWritePrependU16LE(LB_Writer *writer, const uint16_t value) {
+    return lbWritePrependLE(writer, &value, sizeof(value));
+}
+
+LB_INLINE LB_WriterError lbWritePrependU16BE(LB_Writer *writer, const uint16_t value) {
+    return lbWritePrependBE(writer, &value, sizeof(value));
+}
+
+LB_INLINE LB_WriterError lbWritePrependU32LE(LB_Writer *writer, const uint32_t value) {
+    return lbWritePrependLE(writer, &value, sizeof(value));
+}
+
+LB_INLINE LB_WriterError lbWritePrependU32BE(LB_Writer *writer, const uint32_t value) {
+    return lbWritePrependBE(writer, &value, sizeof(value));
+}
+
+LB_INLINE LB_WriterError lbWritePrependU64LE(LB_Writer *writer, const uint64_t value) {
+    return lbWritePrependLE(writer, &value, sizeof(value));
+}
+
+LB_INLINE LB_WriterError lbWritePrependU64BE(LB_Writer *writer, const uint64_t value) {
+    return lbWritePrependBE(writer, &value, sizeof(value));
+}
+
 #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
 #define lbWriteLE lbWrite
 #define lbWriteBE lbWriteReversed
@@ -438,128 +783,128 @@ inline LB_WriterError lbWriteReversed(LB_Writer *writer, const void *value, cons
 #define lbWriterUnsafeBE lbWriteUnsafe
 #endif
 
-inline LB_WriterError lbWriteU8(LB_Writer *writer, const uint8_t value) {
+LB_INLINE LB_WriterError lbWriteU8(LB_Writer *writer, const uint8_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU8LE(LB_Writer *writer, const uint8_t value) {
+LB_INLINE LB_WriterError lbWriteU8LE(LB_Writer *writer, const uint8_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU8BE(LB_Writer *writer, const uint8_t value) {
+LB_INLINE LB_WriterError lbWriteU8BE(LB_Writer *writer, const uint8_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU16(LB_Writer *writer, const uint16_t value) {
+LB_INLINE LB_WriterError lbWriteU16(LB_Writer *writer, const uint16_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU16LE(LB_Writer *writer, const uint16_t value) {
+LB_INLINE LB_WriterError lbWriteU16LE(LB_Writer *writer, const uint16_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU16BE(LB_Writer *writer, const uint16_t value) {
+LB_INLINE LB_WriterError lbWriteU16BE(LB_Writer *writer, const uint16_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU32(LB_Writer *writer, const uint32_t value) {
+LB_INLINE LB_WriterError lbWriteU32(LB_Writer *writer, const uint32_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU32LE(LB_Writer *writer, const uint32_t value) {
+LB_INLINE LB_WriterError lbWriteU32LE(LB_Writer *writer, const uint32_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU32BE(LB_Writer *writer, const uint32_t value) {
+LB_INLINE LB_WriterError lbWriteU32BE(LB_Writer *writer, const uint32_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
 
-inline LB_WriterError lbWriteU64(LB_Writer *writer, const uint64_t value) {
+LB_INLINE LB_WriterError lbWriteU64(LB_Writer *writer, const uint64_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU64LE(LB_Writer *writer, const uint64_t value) {
+LB_INLINE LB_WriterError lbWriteU64LE(LB_Writer *writer, const uint64_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteU64BE(LB_Writer *writer, const uint64_t value) {
+LB_INLINE LB_WriterError lbWriteU64BE(LB_Writer *writer, const uint64_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
 
-inline LB_WriterError lbWriteI8(LB_Writer *writer, const int8_t value) {
+LB_INLINE LB_WriterError lbWriteI8(LB_Writer *writer, const int8_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI8LE(LB_Writer *writer, const int8_t value) {
+LB_INLINE LB_WriterError lbWriteI8LE(LB_Writer *writer, const int8_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI8BE(LB_Writer *writer, const int8_t value) {
+LB_INLINE LB_WriterError lbWriteI8BE(LB_Writer *writer, const int8_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI16(LB_Writer *writer, const int16_t value) {
+LB_INLINE LB_WriterError lbWriteI16(LB_Writer *writer, const int16_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI16LE(LB_Writer *writer, const int16_t value) {
+LB_INLINE LB_WriterError lbWriteI16LE(LB_Writer *writer, const int16_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI16BE(LB_Writer *writer, const int16_t value) {
+LB_INLINE LB_WriterError lbWriteI16BE(LB_Writer *writer, const int16_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI32(LB_Writer *writer, const int32_t value) {
+LB_INLINE LB_WriterError lbWriteI32(LB_Writer *writer, const int32_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI32LE(LB_Writer *writer, const int32_t value) {
+LB_INLINE LB_WriterError lbWriteI32LE(LB_Writer *writer, const int32_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI32BE(LB_Writer *writer, const int32_t value) {
+LB_INLINE LB_WriterError lbWriteI32BE(LB_Writer *writer, const int32_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
 
-inline LB_WriterError lbWriteI64(LB_Writer *writer, const int64_t value) {
+LB_INLINE LB_WriterError lbWriteI64(LB_Writer *writer, const int64_t value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI64LE(LB_Writer *writer, const int64_t value) {
+LB_INLINE LB_WriterError lbWriteI64LE(LB_Writer *writer, const int64_t value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteI64BE(LB_Writer *writer, const int64_t value) {
+LB_INLINE LB_WriterError lbWriteI64BE(LB_Writer *writer, const int64_t value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
 
-inline LB_WriterError lbWriteF32(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteF32(LB_Writer *writer, const float value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteF32LE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteF32LE(LB_Writer *writer, const float value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteF32BE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteF32BE(LB_Writer *writer, const float value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
 
-inline LB_WriterError lbWriteF64(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteF64(LB_Writer *writer, const double value) {
     return lbWrite(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteF64LE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteF64LE(LB_Writer *writer, const double value) {
     return lbWriteLE(writer, &value, sizeof(value));
 }
 
-inline LB_WriterError lbWriteF64BE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteF64BE(LB_Writer *writer, const double value) {
     return lbWriteBE(writer, &value, sizeof(value));
 }
 
@@ -591,122 +936,122 @@ return e; \
 #define LB_WRITER_NORMALIZED_UNSIGNED_SAFETY
 #endif
 
-inline LB_WriterError lbWriteNU8(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNU8(LB_Writer *writer, const float value) {
     const uint8_t normalized = (uint8_t) (value * ((float) UINT8_MAX) + 0.5f);
     LB_WRITER_NORMALIZED_UNSIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNU8LE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNU8LE(LB_Writer *writer, const float value) {
     return lbWriteNU8(writer, value);
 }
 
-inline LB_WriterError lbWriteNU8BE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNU8BE(LB_Writer *writer, const float value) {
     return lbWriteNU8(writer, value);
 }
 
 
-inline LB_WriterError lbWriteNU16(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNU16(LB_Writer *writer, const float value) {
     const uint16_t normalized = (uint16_t) (value * ((float) UINT16_MAX) + 0.5f);
     LB_WRITER_NORMALIZED_UNSIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNU16LE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNU16LE(LB_Writer *writer, const float value) {
     return lbWriteNU16(writer, value);
 }
 
-inline LB_WriterError lbWriteNU16BE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNU16BE(LB_Writer *writer, const float value) {
     return lbWriteNU16(writer, value);
 }
 
 /*  Normalized integers utilizing more than 23 bits can carry more precision than a float.  */
-inline LB_WriterError lbWriteNU32(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNU32(LB_Writer *writer, const double value) {
     const uint32_t normalized = (uint32_t) (value * ((double) UINT32_MAX) + 0.5);
     LB_WRITER_NORMALIZED_UNSIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNU32LE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNU32LE(LB_Writer *writer, const double value) {
     return lbWriteNU32(writer, value);
 }
 
-inline LB_WriterError lbWriteNU32BE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNU32BE(LB_Writer *writer, const double value) {
     return lbWriteNU32(writer, value);
 }
 
 
-inline LB_WriterError lbWriteNU64(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNU64(LB_Writer *writer, const double value) {
     const uint64_t normalized = (uint64_t) (value * ((double) UINT64_MAX) + 0.5);
     LB_WRITER_NORMALIZED_UNSIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNU64LE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNU64LE(LB_Writer *writer, const double value) {
     return lbWriteNU64(writer, value);
 }
 
-inline LB_WriterError lbWriteNU64BE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNU64BE(LB_Writer *writer, const double value) {
     return lbWriteNU64(writer, value);
 }
 
 
-inline LB_WriterError lbWriteNI8(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNI8(LB_Writer *writer, const float value) {
     const int8_t normalized = (int8_t) (value * ((float) INT8_MAX) + 0.5f);
     LB_WRITER_NORMALIZED_SIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNI8LE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNI8LE(LB_Writer *writer, const float value) {
     return lbWriteNI8(writer, value);
 }
 
-inline LB_WriterError lbWriteNI8BE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNI8BE(LB_Writer *writer, const float value) {
     return lbWriteNI8(writer, value);
 }
 
 
-inline LB_WriterError lbWriteNI16(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNI16(LB_Writer *writer, const float value) {
     const int16_t normalized = (int16_t) (value * ((float) INT16_MAX) + 0.5f);
     LB_WRITER_NORMALIZED_SIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNI16LE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNI16LE(LB_Writer *writer, const float value) {
     return lbWriteNI16(writer, value);
 }
 
-inline LB_WriterError lbWriteNI16BE(LB_Writer *writer, const float value) {
+LB_INLINE LB_WriterError lbWriteNI16BE(LB_Writer *writer, const float value) {
     return lbWriteNI16(writer, value);
 }
 
 
-inline LB_WriterError lbWriteNI32(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNI32(LB_Writer *writer, const double value) {
     const int32_t normalized = (int32_t) (value * ((double) INT32_MAX) + 0.5);
     LB_WRITER_NORMALIZED_SIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNI32LE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNI32LE(LB_Writer *writer, const double value) {
     return lbWriteNI32(writer, value);
 }
 
-inline LB_WriterError lbWriteNI32BE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNI32BE(LB_Writer *writer, const double value) {
     return lbWriteNI32(writer, value);
 }
 
 
-inline LB_WriterError lbWriteNI64(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNI64(LB_Writer *writer, const double value) {
     const int64_t normalized = (int64_t) (value * ((double) INT64_MAX) + 0.5);
     LB_WRITER_NORMALIZED_SIGNED_SAFETY
     return lbWriteUnsafe(writer, &normalized, sizeof(normalized));
 }
 
-inline LB_WriterError lbWriteNI64LE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNI64LE(LB_Writer *writer, const double value) {
     return lbWriteNI64(writer, value);
 }
 
-inline LB_WriterError lbWriteNI64BE(LB_Writer *writer, const double value) {
+LB_INLINE LB_WriterError lbWriteNI64BE(LB_Writer *writer, const double value) {
     return lbWriteNI64(writer, value);
 }
 #ifdef __cplusplus
@@ -714,7 +1059,7 @@ inline LB_WriterError lbWriteNI64BE(LB_Writer *writer, const double value) {
 #endif
 #endif
 
-#ifdef LB_WRITER_IMPLEMENTATION
+#if defined(LB_WRITER_IMPLEMENTATION) && !defined(LB_BUFFER_STATIC)
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -727,7 +1072,10 @@ const char* lbWriterErrorMessage(const LB_WriterError e);
 LB_WriterInitError lbWriterInitBuffer(LB_Writer *writer, void *data, size_t length);
 LB_WriterInitError lbWriterInitFile(LB_Writer *writer, FILE *file);
 LB_WriterInitError lbWriterInitDynamicBuffer(LB_Writer *writer, size_t initial_capacity);
+LB_WriterInitError lbWriterInitBufferHeadroom(LB_Writer *writer, void *data, size_t length, size_t headroom);
+LB_WriterInitError lbWriterInitDynamicBufferHeadroom(LB_Writer *writer, size_t initial_capacity, size_t headroom);
 void lbWriterFree(LB_Writer *writer);
+LB_WriterError lbWriterGrow(LB_Writer *writer, size_t length);
 
 #ifdef LB_WRITER_SAFETY
 LB_WriterError lbWriterCheckSafety(LB_Writer *writer, const void *value, size_t length);
@@ -736,13 +1084,33 @@ LB_WriterError lbWriterCheckSafety(LB_Writer *writer, const void *value, size_t
 LB_WriterMode lbWriterGetMode(const LB_Writer *writer);
 
 LB_WriterError lbWriterSeek(LB_Writer *writer, size_t position);
+LB_WriterError lbWriterSeekRelative(LB_Writer *writer, int64_t offset);
+LB_WriterError lbWriterFlush(LB_Writer *writer);
+void lbWriterSetStreaming(LB_Writer *writer, size_t threshold);
+void lbWriterStreamCopy(void *destination, const void *source, size_t length);
+void lbWriterLock(const LB_Writer *writer);
+void lbWriterUnlock(const LB_Writer *writer);
+void lbWriterSetUnlocked(LB_Writer *writer, int unlocked);
 
 size_t lbWriterTell(const LB_Writer *writer);
+size_t lbWriterLength(const LB_Writer *writer);
+size_t lbWriterRemaining(const LB_Writer *writer);
+void *lbWriterData(const LB_Writer *writer);
+size_t lbWriterHeadroom(const LB_Writer *writer);
 
 LB_WriterError lbWriteUnsafe(LB_Writer *writer, const void *value, size_t length);
 LB_WriterError lbWrite(LB_Writer *writer, const void *value, size_t length);
 LB_WriterError lbWriteReversedUnsafe(LB_Writer *writer, const void *value, size_t length);
 LB_WriterError lbWriteReversed(LB_Writer *writer, const void *value, size_t length);
+LB_WriterError lbWritePrepend(LB_Writer *writer, const void *value, size_t length);
+LB_WriterError lbWritePrependReversed(LB_Writer *writer, const void *value, size_t length);
+LB_WriterError lbWritePrependU8(LB_Writer *writer, uint8_t value);
+LB_WriterError lbWritePrependU16LE(LB_Writer *writer, uint16_t value);
+LB_WriterError lbWritePrependU16BE(LB_Writer *writer, uint16_t value);
+LB_WriterError lbWritePrependU32LE(LB_Writer *writer, uint32_t value);
+LB_WriterError lbWritePrependU32BE(LB_Writer *writer, uint32_t value);
+LB_WriterError lbWritePrependU64LE(LB_Writer *writer, uint64_t value);
+LB_WriterError lbWritePrependU64BE(LB_Writer *writer, uint64_t value);
 LB_WriterError lbWriteU8(LB_Writer *writer, uint8_t value);
 LB_WriterError lbWriteU8LE(LB_Writer *writer, uint8_t value);
 LB_WriterError lbWriteU8BE(LB_Writer *writer, uint8_t value);
@@ -797,9 +1165,9 @@ LB_WriterError lbWriteNI32BE(LB_Writer *writer, double value);
 LB_WriterError lbWriteNI64(LB_Writer *writer, double value);
 LB_WriterError lbWriteNI64LE(LB_Writer *writer, double value);
 LB_WriterError lbWriteNI64BE(LB_Writer *writer, double value);
-#endif
 
 #ifdef __cplusplus
 }
 #endif
+#endif
 
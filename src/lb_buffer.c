@@ -0,0 +1,32 @@
+/*
+ * The C API compiled once, for the lb_buffer_static and lb_buffer_shared targets.
+ *
+ * Link one of those instead of defining the *_IMPLEMENTATION macros in a translation unit of your own. They are built
+ * with link-time optimization where the compiler supports it: build your code with LTO too and calls into the library
+ * are inlined across the boundary. For hot paths that must not depend on that, also define LB_BUFFER_STATIC: the inline
+ * functions are then compiled into every translation unit, and the library still provides the others.
+ */
+
+#define LB_BUFFER_IMPLEMENTATION
+#include "lb_buffer.h"
+
+#define LB_BIT_WRITER_IMPLEMENTATION
+#include "lb_bit_writer.h"
+
+#define LB_BIT_READER_IMPLEMENTATION
+#include "lb_bit_reader.h"
+
+#define LB_PAGED_ARENA_IMPLEMENTATION
+#include "lb_paged_arena.h"
+
+#define LB_QUANTIZE_IMPLEMENTATION
+#include "lb_quantize.h"
+
+#define LB_RANS_IMPLEMENTATION
+#include "lb_rans.h"
+
+#define LB_PACKET_IMPLEMENTATION
+#include "lb_packet.h"
+
+#define LB_DEDUP_IMPLEMENTATION
+#include "lb_dedup.h"
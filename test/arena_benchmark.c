@@ -0,0 +1,481 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define LB_BUFFER_IMPLEMENTATION
+#include "lb_buffer.h"
+
+#define LB_PAGED_ARENA_IMPLEMENTATION
+#include "lb_paged_arena.h"
+
+#define LB_BENCH_IMPLEMENTATION
+#include "lb_bench.h"
+
+/*
+ * LB_PagedArena against malloc and a size-class slab allocator.
+ *
+ * Usage: lb_buffer_arena_benchmark [harness options] [--threads n] [--footprint n]
+ *
+ * Every benchmark allocates a batch of sizes drawn from a distribution and writes to each allocation. The arena
+ * either starts from a fresh arena every batch ("fresh") or is cleared and reused ("clear"), which is where the
+ * linear page walk of lbPagedArenaAlloc shows up. malloc and the slab free every allocation after the batch, so
+ * one operation is an allocation and its release for all of them.
+ *
+ * The footprint table allocates --footprint objects without releasing them and reports the bytes requested, the
+ * bytes the allocator reserved, the change of the resident set and the share of the reservation that is wasted.
+ * The thread table runs the uniform distribution on 1 to --threads threads, each with its own arena or slab.
+ */
+
+#define BENCH_SLAB_CLASSES 10
+#define BENCH_SLAB_MIN_SHIFT 3
+#define BENCH_SLAB_CHUNK (64 * 1024)
+
+typedef enum BenchDistribution {
+    BENCH_DISTRIBUTION_FIXED_16,
+    BENCH_DISTRIBUTION_FIXED_64,
+    BENCH_DISTRIBUTION_UNIFORM,
+    BENCH_DISTRIBUTION_SKEWED,
+    BENCH_DISTRIBUTION_COUNT,
+} BenchDistribution;
+
+static const char *bench_distribution_names[BENCH_DISTRIBUTION_COUNT] = {"fixed16", "fixed64", "uniform8-256", "skewed"};
+
+static const size_t bench_page_capacities[] = {4096, 64 * 1024, 1024 * 1024};
+#define BENCH_PAGE_CAPACITY_COUNT (sizeof(bench_page_capacities) / sizeof(bench_page_capacities[0]))
+
+/*
+ * Slab allocator with power of two size classes from 8 to 4096 bytes, carved out of 64 KiB chunks.
+ * Freed blocks go on a per-class free list.
+ */
+typedef struct BenchSlab {
+    void *free_lists[BENCH_SLAB_CLASSES];
+    uint8_t *chunk;
+    size_t chunk_used;
+    void **chunks;
+    size_t chunk_count;
+    size_t chunk_capacity;
+} BenchSlab;
+
+static uint32_t benchSlabClass(const size_t size) {
+    uint32_t class_index = 0;
+    while (((size_t) 1 << (class_index + BENCH_SLAB_MIN_SHIFT)) < size) {
+        class_index++;
+    }
+    return class_index;
+}
+
+static void *benchSlabAlloc(BenchSlab *slab, const size_t size) {
+    const uint32_t class_index = benchSlabClass(size);
+    if (class_index >= BENCH_SLAB_CLASSES) {
+        return NULL;
+    }
+
+    void *block = slab->free_lists[class_index];
+    if (block != NULL) {
+        slab->free_lists[class_index] = *(void **) block;
+        return block;
+    }
+
+    const size_t block_size = (size_t) 1 << (class_index + BENCH_SLAB_MIN_SHIFT);
+    if (slab->chunk == NULL || slab->chunk_used + block_size > BENCH_SLAB_CHUNK) {
+        if (slab->chunk_count == slab->chunk_capacity) {
+            const size_t capacity = slab->chunk_capacity ? slab->chunk_capacity * 2 : 16;
+            void **chunks = (void **) realloc(slab->chunks, capacity * sizeof(void *));
+            if (chunks == NULL) {
+                return NULL;
+            }
+            slab->chunks = chunks;
+            slab->chunk_capacity = capacity;
+        }
+
+        slab->chunk = (uint8_t *) malloc(BENCH_SLAB_CHUNK);
+        if (slab->chunk == NULL) {
+            return NULL;
+        }
+        slab->chunks[slab->chunk_count++] = slab->chunk;
+        slab->chunk_used = 0;
+    }
+
+    block = slab->chunk + slab->chunk_used;
+    slab->chunk_used += block_size;
+    return block;
+}
+
+static void benchSlabFree(BenchSlab *slab, void *block, const size_t size) {
+    const uint32_t class_index = benchSlabClass(size);
+    *(void **) block = slab->free_lists[class_index];
+    slab->free_lists[class_index] = block;
+}
+
+static void benchSlabDestroy(BenchSlab *slab) {
+    for (size_t i = 0; i < slab->chunk_count; i++) {
+        free(slab->chunks[i]);
+    }
+    free(slab->chunks);
+    memset(slab, 0, sizeof(*slab));
+}
+
+static size_t benchArenaReserved(const LB_PagedArena *arena) {
+    size_t reserved = 0;
+    for (const LB_PagedArenaPage *page = arena->head; page != NULL; page = page->next) {
+        reserved += page->capacity;
+    }
+    return reserved;
+}
+
+// Resident set size in bytes, 0 where it cannot be read.
+static size_t benchResident(void) {
+#ifdef __linux__
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == NULL) {
+        return 0;
+    }
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int read = fscanf(file, "%lu %lu", &size, &resident);
+    fclose(file);
+    return read == 2 ? (size_t) resident * (size_t) sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+static size_t benchResidentSince(const size_t before) {
+    const size_t now = benchResident();
+    return now > before ? now - before : 0;
+}
+
+static void benchReleaseFreeMemory(void) {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+// Fill sizes with a fixed sequence drawn from the distribution.
+static void benchFillSizes(size_t *sizes, const size_t count, const BenchDistribution distribution) {
+    uint64_t state = 0x853C49E6748FEA9Bull;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        const uint32_t random = (uint32_t) (state >> 33);
+        switch (distribution) {
+            case BENCH_DISTRIBUTION_FIXED_16:
+                sizes[i] = 16;
+                break;
+            case BENCH_DISTRIBUTION_FIXED_64:
+                sizes[i] = 64;
+                break;
+            case BENCH_DISTRIBUTION_UNIFORM:
+                sizes[i] = 8 + random % 249;
+                break;
+            case BENCH_DISTRIBUTION_SKEWED:
+            default:
+                // Mostly small objects with a one percent tail of buffers up to 4 KiB.
+                sizes[i] = random % 100 == 0 ? 1024 + random % 3073 : 8 + random % 57;
+                break;
+        }
+    }
+}
+
+typedef struct BenchAllocator {
+    const size_t *sizes;
+    size_t page_capacity;
+    LB_PagedArena *arena;
+    BenchSlab slab;
+    void **pointers;
+} BenchAllocator;
+
+static void benchArenaFresh(void *context, const size_t count) {
+    BenchAllocator *bench = (BenchAllocator *) context;
+    LB_PagedArena *arena = lbPagedArenaNew(bench->page_capacity);
+    for (size_t i = 0; i < count; i++) {
+        uint8_t *pointer = (uint8_t *) lbPagedArenaAlloc(arena, bench->sizes[i]);
+        *(volatile uint8_t *) pointer = (uint8_t) i;
+    }
+    lbPagedArenaFree(arena);
+}
+
+static void benchArenaClear(void *context, const size_t count) {
+    BenchAllocator *bench = (BenchAllocator *) context;
+    lbPagedArenaClear(bench->arena);
+    for (size_t i = 0; i < count; i++) {
+        uint8_t *pointer = (uint8_t *) lbPagedArenaAlloc(bench->arena, bench->sizes[i]);
+        *(volatile uint8_t *) pointer = (uint8_t) i;
+    }
+}
+
+static void benchMalloc(void *context, const size_t count) {
+    BenchAllocator *bench = (BenchAllocator *) context;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t *pointer = (uint8_t *) malloc(bench->sizes[i]);
+        *(volatile uint8_t *) pointer = (uint8_t) i;
+        bench->pointers[i] = pointer;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(bench->pointers[i]);
+    }
+}
+
+static void benchSlab(void *context, const size_t count) {
+    BenchAllocator *bench = (BenchAllocator *) context;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t *pointer = (uint8_t *) benchSlabAlloc(&bench->slab, bench->sizes[i]);
+        *(volatile uint8_t *) pointer = (uint8_t) i;
+        bench->pointers[i] = pointer;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        benchSlabFree(&bench->slab, bench->pointers[i], bench->sizes[i]);
+    }
+}
+
+static double benchAverageSize(const size_t *sizes, const size_t count) {
+    double total = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        total += (double) sizes[i];
+    }
+    return total / (double) count;
+}
+
+static void benchRunThroughput(const size_t batch, void **pointers) {
+    size_t *sizes = (size_t *) malloc(batch * sizeof(size_t));
+    if (sizes == NULL) {
+        return;
+    }
+
+    for (int distribution = 0; distribution < BENCH_DISTRIBUTION_COUNT; distribution++) {
+        benchFillSizes(sizes, batch, (BenchDistribution) distribution);
+        const double average = benchAverageSize(sizes, batch);
+        const char *distribution_name = bench_distribution_names[distribution];
+        char name[LB_BENCH_NAME_LENGTH];
+
+        for (size_t i = 0; i < BENCH_PAGE_CAPACITY_COUNT; i++) {
+            BenchAllocator bench = {.sizes = sizes, .page_capacity = bench_page_capacities[i], .pointers = pointers};
+            snprintf(name, sizeof(name), "arena/fresh/%s/%zuK", distribution_name, bench.page_capacity / 1024);
+            lbBenchRun(name, benchArenaFresh, &bench, average);
+
+            bench.arena = lbPagedArenaNew(bench.page_capacity);
+            snprintf(name, sizeof(name), "arena/clear/%s/%zuK", distribution_name, bench.page_capacity / 1024);
+            lbBenchRun(name, benchArenaClear, &bench, average);
+            lbPagedArenaFree(bench.arena);
+        }
+
+        BenchAllocator bench = {.sizes = sizes, .pointers = pointers};
+        snprintf(name, sizeof(name), "malloc/%s", distribution_name);
+        lbBenchRun(name, benchMalloc, &bench, average);
+
+        snprintf(name, sizeof(name), "slab/%s", distribution_name);
+        lbBenchRun(name, benchSlab, &bench, average);
+        benchSlabDestroy(&bench.slab);
+    }
+
+    free(sizes);
+}
+
+static void benchPrintFootprint(const char *name, const size_t requested, const size_t reserved, const size_t resident) {
+    const double mib = 1024.0 * 1024.0;
+    // Without an allocator-side reservation, like for malloc, the resident set stands in for it.
+    const size_t footprint = reserved ? reserved : resident;
+    const double waste = footprint > requested ? 100.0 * (double) (footprint - requested) / (double) footprint : 0.0;
+    printf("%-40s %12.2f %12.2f %12.2f %10.1f%%\n", name, requested / mib, reserved / mib, resident / mib, waste);
+}
+
+static void benchRunFootprint(const size_t count) {
+    size_t *sizes = (size_t *) malloc(count * sizeof(size_t));
+    void **pointers = (void **) malloc(count * sizeof(void *));
+    if (sizes == NULL || pointers == NULL) {
+        free(sizes);
+        free(pointers);
+        return;
+    }
+
+    printf("\n%-40s %12s %12s %12s %11s\n", "footprint", "request MiB", "reserve MiB", "RSS MiB", "waste");
+    for (int distribution = 0; distribution < BENCH_DISTRIBUTION_COUNT; distribution++) {
+        benchFillSizes(sizes, count, (BenchDistribution) distribution);
+        size_t requested = 0;
+        for (size_t i = 0; i < count; i++) {
+            requested += sizes[i];
+        }
+
+        const char *distribution_name = bench_distribution_names[distribution];
+        char name[LB_BENCH_NAME_LENGTH];
+        for (size_t i = 0; i < BENCH_PAGE_CAPACITY_COUNT; i++) {
+            benchReleaseFreeMemory();
+            const size_t before = benchResident();
+            LB_PagedArena *arena = lbPagedArenaNew(bench_page_capacities[i]);
+            for (size_t j = 0; j < count; j++) {
+                memset(lbPagedArenaAlloc(arena, sizes[j]), 0, sizes[j]);
+            }
+
+            const size_t resident = benchResidentSince(before);
+            snprintf(name, sizeof(name), "arena/%s/%zuK", distribution_name, bench_page_capacities[i] / 1024);
+            benchPrintFootprint(name, requested, benchArenaReserved(arena), resident);
+            lbPagedArenaFree(arena);
+        }
+
+        benchReleaseFreeMemory();
+        size_t before = benchResident();
+        for (size_t j = 0; j < count; j++) {
+            pointers[j] = malloc(sizes[j]);
+            memset(pointers[j], 0, sizes[j]);
+        }
+
+        size_t resident = benchResidentSince(before);
+        snprintf(name, sizeof(name), "malloc/%s", distribution_name);
+        benchPrintFootprint(name, requested, 0, resident);
+        for (size_t j = 0; j < count; j++) {
+            free(pointers[j]);
+        }
+
+        benchReleaseFreeMemory();
+        before = benchResident();
+        BenchSlab slab = {0};
+        for (size_t j = 0; j < count; j++) {
+            memset(benchSlabAlloc(&slab, sizes[j]), 0, sizes[j]);
+        }
+
+        resident = benchResidentSince(before);
+        snprintf(name, sizeof(name), "slab/%s", distribution_name);
+        benchPrintFootprint(name, requested, slab.chunk_count * (size_t) BENCH_SLAB_CHUNK, resident);
+        benchSlabDestroy(&slab);
+    }
+
+    free(sizes);
+    free(pointers);
+}
+
+typedef enum BenchThreadAllocator {
+    BENCH_THREAD_ARENA,
+    BENCH_THREAD_MALLOC,
+    BENCH_THREAD_SLAB,
+    BENCH_THREAD_ALLOCATOR_COUNT,
+} BenchThreadAllocator;
+
+static const char *bench_thread_allocator_names[BENCH_THREAD_ALLOCATOR_COUNT] = {"arena/clear/64K", "malloc", "slab"};
+
+typedef struct BenchThread {
+    pthread_t thread;
+    BenchThreadAllocator allocator;
+    const size_t *sizes;
+    size_t batch;
+    uint32_t rounds;
+    pthread_barrier_t *barrier;
+    uint64_t start;
+    uint64_t end;
+} BenchThread;
+
+static void *benchThreadMain(void *argument) {
+    BenchThread *thread = (BenchThread *) argument;
+    BenchAllocator bench = {.sizes = thread->sizes, .page_capacity = 64 * 1024};
+    bench.pointers = (void **) malloc(thread->batch * sizeof(void *));
+    bench.arena = lbPagedArenaNew(bench.page_capacity);
+
+    const LB_BenchFn fn = thread->allocator == BENCH_THREAD_ARENA ? benchArenaClear :
+                          thread->allocator == BENCH_THREAD_MALLOC ? benchMalloc : benchSlab;
+    pthread_barrier_wait(thread->barrier);
+    thread->start = lbBenchNow();
+    for (uint32_t i = 0; i < thread->rounds; i++) {
+        fn(&bench, thread->batch);
+    }
+    thread->end = lbBenchNow();
+
+    lbPagedArenaFree(bench.arena);
+    benchSlabDestroy(&bench.slab);
+    free(bench.pointers);
+    return NULL;
+}
+
+static void benchRunThreads(const uint32_t max_threads, const size_t batch) {
+    size_t *sizes = (size_t *) malloc(batch * sizeof(size_t));
+    BenchThread *threads = (BenchThread *) malloc(max_threads * sizeof(BenchThread));
+    if (sizes == NULL || threads == NULL) {
+        free(sizes);
+        free(threads);
+        return;
+    }
+
+    benchFillSizes(sizes, batch, BENCH_DISTRIBUTION_UNIFORM);
+    printf("\n%-40s %8s %14s %14s\n", "threads (uniform8-256)", "threads", "Mops/s", "Mops/s/thread");
+    for (int allocator = 0; allocator < BENCH_THREAD_ALLOCATOR_COUNT; allocator++) {
+        for (uint32_t count = 1; count <= max_threads; count *= 2) {
+            pthread_barrier_t barrier;
+            pthread_barrier_init(&barrier, NULL, count);
+            for (uint32_t i = 0; i < count; i++) {
+                threads[i] = (BenchThread){
+                    .allocator = (BenchThreadAllocator) allocator,
+                    .sizes = sizes,
+                    .batch = batch,
+                    .rounds = lb_bench_options.repetitions,
+                    .barrier = &barrier,
+                };
+                pthread_create(&threads[i].thread, NULL, benchThreadMain, &threads[i]);
+            }
+
+            // Each thread sets up its allocator before the barrier, so the time from the first thread starting
+            // to the last thread finishing covers only the batches.
+            uint64_t start = UINT64_MAX;
+            uint64_t end = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                pthread_join(threads[i].thread, NULL);
+                start = threads[i].start < start ? threads[i].start : start;
+                end = threads[i].end > end ? threads[i].end : end;
+            }
+            pthread_barrier_destroy(&barrier);
+
+            const double operations = (double) count * (double) batch * (double) lb_bench_options.repetitions;
+            const double mops = operations / ((double) (end - start) / 1000.0);
+            printf("%-40s %8u %14.2f %14.2f\n", bench_thread_allocator_names[allocator], count, mops, mops / count);
+        }
+    }
+
+    free(sizes);
+    free(threads);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t max_threads = 8;
+    size_t footprint = 1 << 18;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            max_threads = (uint32_t) strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--footprint") == 0) {
+            footprint = (size_t) strtoull(argv[i + 1], NULL, 10);
+        }
+    }
+
+    if (!lbBenchParseOptions(argc, argv) || max_threads == 0 || footprint == 0) {
+        fprintf(stderr, "Usage: %s [--filter text] [--warmup n] [--repetitions n] [--batch n] [--counters]\n"
+                        "    [--save baseline] [--compare baseline] [--threshold percent] [--threads n] [--footprint n]\n",
+                argv[0]);
+        return 1;
+    }
+
+    void **pointers = (void **) malloc(lb_bench_options.batch * sizeof(void *));
+    if (pointers == NULL) {
+        return 1;
+    }
+
+    printf("batch: %zu, warmup: %u, repetitions: %u\n", lb_bench_options.batch, lb_bench_options.warmup,
+           lb_bench_options.repetitions);
+    lbBenchPrintHeader();
+    benchRunThroughput(lb_bench_options.batch, pointers);
+    free(pointers);
+
+    if (lb_bench_options.filter == NULL) {
+        benchRunFootprint(footprint);
+        benchRunThreads(max_threads, lb_bench_options.batch);
+    }
+
+    lbBenchCountersClose();
+    return lbBenchFinish();
+}
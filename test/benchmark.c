@@ -1 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+// lb_buffer_benchmark_library links the compiled library instead.
+#ifndef LB_BENCH_LIBRARY
+#define LB_BUFFER_IMPLEMENTATION
+#endif
+#include "lb_buffer.h"
+
+#define LB_BENCH_IMPLEMENTATION
+#include "lb_bench.h"
+
+#define LB_CORPUS_IMPLEMENTATION
+#include "lb_corpus.h"
+
+/*
+ * Throughput of every lbWrite and lbRead primitive, in every mode and byte order.
+ *
+ * Build the lb_buffer_benchmark target for numbers with safety on, and lb_buffer_benchmark_no_safety
+ * for the same suite compiled with LB_BUFFER_NO_SAFETY. lb_buffer_benchmark_library calls into
+ * lb_buffer_static through link-time optimization and lb_buffer_benchmark_static uses LB_BUFFER_STATIC,
+ * compare them to see what crossing the library boundary costs.
+ *
+ * Usage: lb_buffer_benchmark [--filter text] [--warmup n] [--repetitions n] [--batch n] [--counters]
+ *                             [--corpus file] [--save baseline] [--compare baseline] [--threshold percent]
+ * Benchmarks are named "<function>/<mode>", e.g. "lbWriteU32BE/file".
+ * --save writes the results to a baseline file, --compare checks them against one and exits with 1 if any
+ * kernel is slower by more than the threshold (5% by default) with statistical significance.
+ * --corpus replays a corpus file from lb_buffer_corpus instead of the default generated one.
+ * --counters adds cycles, instructions, IPC and branch, cache and TLB misses per operation from
+ * perf_event_open, or only reference cycles from rdtsc where that is unavailable.
+ */
+
+// Size of the largest primitive, used to size the buffers.
+#define BENCH_MAX_SIZE 8
+// Length of each segment for the segmented reader, deliberately not a multiple of any primitive.
+#define BENCH_SEGMENT_LENGTH 1000
+
+typedef enum BenchWriterMode {
+    BENCH_WRITER_BUFFER,
+    BENCH_WRITER_DYNAMIC_BUFFER,
+    BENCH_WRITER_FILE,
+    BENCH_WRITER_MODE_COUNT,
+} BenchWriterMode;
+
+typedef enum BenchReaderMode {
+    BENCH_READER_BUFFER,
+    BENCH_READER_SEGMENTED,
+    BENCH_READER_FILE,
+    BENCH_READER_MODE_COUNT,
+} BenchReaderMode;
+
+static const char *bench_writer_mode_names[BENCH_WRITER_MODE_COUNT] = {"buffer", "dynamic", "file"};
+static const char *bench_reader_mode_names[BENCH_READER_MODE_COUNT] = {"buffer", "segmented", "file"};
+
+typedef struct BenchWriter {
+    BenchWriterMode mode;
+    LB_Writer writer;
+    void *data;
+    FILE *file;
+    size_t capacity;
+} BenchWriter;
+
+typedef struct BenchReader {
+    LB_Reader reader;
+} BenchReader;
+
+// Rewind the writer so every sample writes the same bytes. Dynamic buffers start over from a small
+// capacity so growth is part of the measurement.
+static void benchWriterReset(BenchWriter *bench) {
+    if (bench->mode == BENCH_WRITER_DYNAMIC_BUFFER) {
+        lbWriterFree(&bench->writer);
+#ifdef LB_BUFFER_NO_SAFETY
+        // Without safety a dynamic buffer never grows, so it has to start at full size.
+        lbWriterInitDynamicBuffer(&bench->writer, bench->capacity);
+#else
+        lbWriterInitDynamicBuffer(&bench->writer, 64);
+#endif
+        return;
+    }
+
+    lbWriterSeek(&bench->writer, 0);
+}
+
+static void benchReaderReset(BenchReader *bench) {
+    lbReaderSeek(&bench->reader, 0);
+}
+
+/*
+ * Every primitive: X(name, type, size, value), where value is an expression of the loop index `i`.
+ */
+#define BENCH_PRIMITIVES(X) \
+    X(U8, uint8_t, 1, (uint8_t) i) \
+    X(U16, uint16_t, 2, (uint16_t) i) \
+    X(U32, uint32_t, 4, (uint32_t) i) \
+    X(U64, uint64_t, 8, (uint64_t) i) \
+    X(I8, int8_t, 1, (int8_t) i) \
+    X(I16, int16_t, 2, (int16_t) i) \
+    X(I32, int32_t, 4, (int32_t) i) \
+    X(I64, int64_t, 8, (int64_t) i) \
+    X(F32, float, 4, (float) i) \
+    X(F64, double, 8, (double) i) \
+    X(NU8, float, 1, (float) (i & 0xFF) * (1.0f / 255.0f)) \
+    X(NU16, float, 2, (float) (i & 0xFF) * (1.0f / 255.0f)) \
+    X(NU32, double, 4, (double) (i & 0xFF) * (1.0 / 255.0)) \
+    X(NU64, double, 8, (double) (i & 0xFF) * (1.0 / 255.0)) \
+    X(NI8, float, 1, (float) (i & 0xFF) * (2.0f / 255.0f) - 1.0f) \
+    X(NI16, float, 2, (float) (i & 0xFF) * (2.0f / 255.0f) - 1.0f) \
+    X(NI32, double, 4, (double) (i & 0xFF) * (2.0 / 255.0) - 1.0) \
+    X(NI64, double, 8, (double) (i & 0xFF) * (2.0 / 255.0) - 1.0)
+
+#define BENCH_DEFINE_ORDER(name, order, type, size, value) \
+    static volatile type bench_sink_##name##order; \
+    static void benchWrite##name##order(void *context, const size_t count) { \
+        BenchWriter *bench = (BenchWriter *) context; \
+        benchWriterReset(bench); \
+        for (size_t i = 0; i < count; i++) { \
+            lbWrite##name##order(&bench->writer, value); \
+        } \
+    } \
+    static void benchRead##name##order(void *context, const size_t count) { \
+        BenchReader *bench = (BenchReader *) context; \
+        benchReaderReset(bench); \
+        for (size_t i = 0; i < count; i++) { \
+            bench_sink_##name##order = lbRead##name##order(&bench->reader, NULL); \
+        } \
+    }
+
+#define BENCH_DEFINE(name, type, size, value) \
+    BENCH_DEFINE_ORDER(name, , type, size, value) \
+    BENCH_DEFINE_ORDER(name, LE, type, size, value) \
+    BENCH_DEFINE_ORDER(name, BE, type, size, value)
+
+BENCH_PRIMITIVES(BENCH_DEFINE)
+
+typedef struct BenchPrimitive {
+    const char *write_name;
+    const char *read_name;
+    size_t size;
+    LB_BenchFn write;
+    LB_BenchFn read;
+} BenchPrimitive;
+
+#define BENCH_ENTRY_ORDER(name, order, size) \
+    {"lbWrite" #name #order, "lbRead" #name #order, size, benchWrite##name##order, benchRead##name##order},
+
+#define BENCH_ENTRY(name, type, size, value) \
+    BENCH_ENTRY_ORDER(name, , size) \
+    BENCH_ENTRY_ORDER(name, LE, size) \
+    BENCH_ENTRY_ORDER(name, BE, size)
+
+static const BenchPrimitive bench_primitives[] = {
+    BENCH_PRIMITIVES(BENCH_ENTRY)
+};
+
+#define BENCH_PRIMITIVE_COUNT (sizeof(bench_primitives) / sizeof(bench_primitives[0]))
+
+static int benchWriterInit(BenchWriter *bench, const BenchWriterMode mode, const size_t capacity) {
+    memset(bench, 0, sizeof(*bench));
+    bench->mode = mode;
+    bench->capacity = capacity;
+    switch (mode) {
+        case BENCH_WRITER_BUFFER:
+            bench->data = malloc(capacity);
+            return bench->data != NULL && lbWriterInitBuffer(&bench->writer, bench->data, capacity) == LB_WRITER_INIT_NONE;
+        case BENCH_WRITER_DYNAMIC_BUFFER:
+            return lbWriterInitDynamicBuffer(&bench->writer, capacity) == LB_WRITER_INIT_NONE;
+        case BENCH_WRITER_FILE:
+            bench->file = tmpfile();
+            return bench->file != NULL && lbWriterInitFile(&bench->writer, bench->file) == LB_WRITER_INIT_NONE;
+        default:
+            return 0;
+    }
+}
+
+static void benchWriterFree(BenchWriter *bench) {
+    if (bench->mode == BENCH_WRITER_DYNAMIC_BUFFER) {
+        lbWriterFree(&bench->writer);
+    }
+
+    free(bench->data);
+    if (bench->file != NULL) {
+        fclose(bench->file);
+    }
+}
+
+static void benchRunWriters(const size_t capacity) {
+    for (int mode = 0; mode < BENCH_WRITER_MODE_COUNT; mode++) {
+        BenchWriter bench;
+        if (!benchWriterInit(&bench, (BenchWriterMode) mode, capacity)) {
+            fprintf(stderr, "Failed to initialize the %s writer.\n", bench_writer_mode_names[mode]);
+            benchWriterFree(&bench);
+            continue;
+        }
+
+        for (size_t i = 0; i < BENCH_PRIMITIVE_COUNT; i++) {
+            const BenchPrimitive *primitive = &bench_primitives[i];
+            char name[LB_BENCH_NAME_LENGTH];
+            snprintf(name, sizeof(name), "%s/%s", primitive->write_name, bench_writer_mode_names[mode]);
+            lbBenchRun(name, primitive->write, &bench, (double) primitive->size);
+        }
+
+        benchWriterFree(&bench);
+    }
+}
+
+static void benchRunReaders(const uint8_t *data, const size_t capacity) {
+    const size_t segment_count = (capacity + BENCH_SEGMENT_LENGTH - 1) / BENCH_SEGMENT_LENGTH;
+    LB_ReaderSegment *segments = (LB_ReaderSegment *) malloc(segment_count * sizeof(LB_ReaderSegment));
+    FILE *file = tmpfile();
+    if (segments == NULL || file == NULL || fwrite(data, 1, capacity, file) != capacity) {
+        fprintf(stderr, "Failed to prepare the reader benchmarks.\n");
+        free(segments);
+        if (file != NULL) {
+            fclose(file);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < segment_count; i++) {
+        const size_t offset = i * BENCH_SEGMENT_LENGTH;
+        const size_t remaining = capacity - offset;
+        segments[i] = (LB_ReaderSegment){
+            .data = data + offset,
+            .length = remaining < BENCH_SEGMENT_LENGTH ? remaining : BENCH_SEGMENT_LENGTH,
+        };
+    }
+
+    for (int mode = 0; mode < BENCH_READER_MODE_COUNT; mode++) {
+        BenchReader bench;
+        LB_ReaderInitError error = LB_READER_INIT_NONE;
+        switch (mode) {
+            case BENCH_READER_BUFFER:
+                error = lbReaderInitBuffer(&bench.reader, data, capacity);
+                break;
+            case BENCH_READER_SEGMENTED:
+                error = lbReaderInitSegmented(&bench.reader, segments, segment_count);
+                break;
+            case BENCH_READER_FILE:
+                error = lbReaderInitFile(&bench.reader, file);
+                break;
+            default:
+                break;
+        }
+
+        if (error) {
+            fprintf(stderr, "Failed to initialize the %s reader: %s\n", bench_reader_mode_names[mode],
+                    lbReaderInitErrorMessage(error));
+            continue;
+        }
+
+        for (size_t i = 0; i < BENCH_PRIMITIVE_COUNT; i++) {
+            const BenchPrimitive *primitive = &bench_primitives[i];
+            char name[LB_BENCH_NAME_LENGTH];
+            snprintf(name, sizeof(name), "%s/%s", primitive->read_name, bench_reader_mode_names[mode]);
+            lbBenchRun(name, primitive->read, &bench, (double) primitive->size);
+        }
+    }
+
+    fclose(file);
+    free(segments);
+}
+
+typedef struct BenchReplay {
+    LB_Corpus corpus;
+    LB_CorpusValue *values;
+    // Index of the first value of every message.
+    size_t *starts;
+    size_t cursor;
+    LB_Writer writer;
+    void *data;
+    LB_Reader reader;
+    uint8_t *scratch;
+    uint64_t checksum;
+} BenchReplay;
+
+// Encode one message at a time into the same buffer, like serializing messages for sending.
+static void benchReplayEncode(void *context, const size_t count) {
+    BenchReplay *replay = (BenchReplay *) context;
+    for (size_t i = 0; i < count; i++) {
+        lbWriterSeek(&replay->writer, 0);
+        lbCorpusEncodeMessage(&replay->writer, replay->values + replay->starts[replay->cursor], NULL);
+        replay->cursor = replay->cursor + 1 == replay->corpus.message_count ? 0 : replay->cursor + 1;
+    }
+}
+
+// Decode the corpus message after message, wrapping around at the end.
+static void benchReplayDecode(void *context, const size_t count) {
+    BenchReplay *replay = (BenchReplay *) context;
+    for (size_t i = 0; i < count; i++) {
+        if (replay->cursor == 0) {
+            lbReaderSeek(&replay->reader, 0);
+        }
+
+        lbCorpusDecodeMessage(&replay->reader, replay->scratch, &replay->checksum);
+        replay->cursor = replay->cursor + 1 == replay->corpus.message_count ? 0 : replay->cursor + 1;
+    }
+}
+
+static int benchReplayLoad(BenchReplay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+
+    LB_Reader reader;
+    int loaded;
+    if (path != NULL) {
+        FILE *file = fopen(path, "rb");
+        if (file == NULL) {
+            return 0;
+        }
+
+        lbReaderInitFile(&reader, file);
+        loaded = lbCorpusLoad(&reader, &replay->corpus);
+        fclose(file);
+    } else {
+        LB_Writer writer;
+        const LB_CorpusConfig config = lbCorpusDefaultConfig();
+        lbWriterInitDynamicBuffer(&writer, 1 << 20);
+        const LB_WriterError error = lbCorpusGenerate(&writer, &config);
+        lbReaderInitBuffer(&reader, lbWriterData(&writer), lbWriterPosition(&writer));
+        loaded = !error && lbCorpusLoad(&reader, &replay->corpus);
+        lbWriterFree(&writer);
+    }
+
+    size_t value_count;
+    if (!loaded || replay->corpus.message_count == 0 || !lbCorpusParse(&replay->corpus, &replay->values, &value_count)) {
+        return 0;
+    }
+
+    size_t longest = 0;
+    replay->starts = (size_t *) malloc(replay->corpus.message_count * sizeof(size_t));
+    if (replay->starts == NULL) {
+        return 0;
+    }
+
+    for (size_t i = 0, message = 0; i < value_count; i++) {
+        if (i == 0 || replay->values[i - 1].type == LB_CORPUS_TYPE_MESSAGE_END) {
+            replay->starts[message++] = i;
+        }
+    }
+
+    for (size_t i = 0; i < replay->corpus.message_count; i++) {
+        const size_t length = replay->corpus.offsets[i + 1] - replay->corpus.offsets[i];
+        longest = length > longest ? length : longest;
+    }
+
+    // One spare byte, the backpatching seeks back to the end of the message and lbWriterSeek does not accept the
+    // end of a fixed buffer.
+    replay->data = malloc(longest + 1);
+    replay->scratch = (uint8_t *) malloc(LB_CORPUS_MAX_STRING);
+    return replay->data != NULL && replay->scratch != NULL &&
+           lbWriterInitBuffer(&replay->writer, replay->data, longest + 1) == LB_WRITER_INIT_NONE &&
+           lbReaderInitBuffer(&replay->reader, replay->corpus.data, replay->corpus.length) == LB_READER_INIT_NONE;
+}
+
+// Encoding every parsed message must reproduce the corpus byte for byte.
+static int benchReplayVerify(BenchReplay *replay) {
+    for (size_t i = 0; i < replay->corpus.message_count; i++) {
+        const size_t length = replay->corpus.offsets[i + 1] - replay->corpus.offsets[i];
+        lbWriterSeek(&replay->writer, 0);
+        lbCorpusEncodeMessage(&replay->writer, replay->values + replay->starts[i], NULL);
+        if (lbWriterPosition(&replay->writer) != length ||
+            memcmp(replay->data, replay->corpus.data + replay->corpus.offsets[i], length) != 0) {
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < replay->corpus.message_count; i++) {
+        if (lbCorpusDecodeMessage(&replay->reader, replay->scratch, &replay->checksum) != LB_READER_ERROR_NONE) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void benchReplayFree(BenchReplay *replay) {
+    lbCorpusFree(&replay->corpus);
+    free(replay->values);
+    free(replay->starts);
+    free(replay->data);
+    free(replay->scratch);
+}
+
+static void benchRunReplay(const char *path) {
+    BenchReplay replay;
+    if (!benchReplayLoad(&replay, path) || !benchReplayVerify(&replay)) {
+        fprintf(stderr, "Failed to load the corpus %s.\n", path != NULL ? path : "(generated)");
+        benchReplayFree(&replay);
+        return;
+    }
+
+    const double bytes_per_message = (double) replay.corpus.length / (double) replay.corpus.message_count;
+    replay.cursor = 0;
+    lbBenchRun("replay/encode", benchReplayEncode, &replay, bytes_per_message);
+    replay.cursor = 0;
+    lbBenchRun("replay/decode", benchReplayDecode, &replay, bytes_per_message);
+    benchReplayFree(&replay);
+}
+
+int main(int argc, char *argv[]) {
+    if (!lbBenchParseOptions(argc, argv)) {
+        fprintf(stderr, "Usage: %s [--filter text] [--warmup n] [--repetitions n] [--batch n] [--counters]\n"
+                        "    [--corpus file] [--save baseline] [--compare baseline] [--threshold percent]\n", argv[0]);
+        return 1;
+    }
+
+    const char *corpus_path = NULL;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--corpus") == 0) {
+            corpus_path = argv[i + 1];
+        }
+    }
+
+    const size_t capacity = lb_bench_options.batch * BENCH_MAX_SIZE;
+    uint8_t *data = (uint8_t *) malloc(capacity);
+    if (data == NULL) {
+        fprintf(stderr, "Failed to allocate %zu bytes.\n", capacity);
+        return 1;
+    }
+
+    // Arbitrary but fixed contents for the readers.
+    uint32_t state = 0x9E3779B9u;
+    for (size_t i = 0; i < capacity; i++) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = (uint8_t) (state >> 24);
+    }
+
+#ifdef LB_BUFFER_NO_SAFETY
+    const char *safety = "off";
+#else
+    const char *safety = "on";
+#endif
+    printf("safety: %s, batch: %zu, warmup: %u, repetitions: %u\n", safety, lb_bench_options.batch,
+           lb_bench_options.warmup, lb_bench_options.repetitions);
+#ifndef __OPTIMIZE__
+    printf("warning: built without optimizations, configure with -DCMAKE_BUILD_TYPE=Release\n");
+#endif
+
+    lbBenchPrintHeader();
+    benchRunWriters(capacity);
+    benchRunReaders(data, capacity);
+    benchRunReplay(corpus_path);
+
+    lbBenchCountersClose();
+    free(data);
+    return lbBenchFinish();
+}
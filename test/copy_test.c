@@ -0,0 +1,163 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define HAS_PIPE
+#endif
+
+#include "lb_buffer.h"
+
+#include "lb_test.h"
+
+/*
+ * lbWriterCopyFrom between files, into a pipe and into buffers. Every copy starts with bytes already read from the
+ * source, so its stdio buffer is ahead of the reader, and bytes already written to the destination but not flushed.
+ * On Linux the file copy takes the copy_file_range path, the pipe copy the sendfile path, and the pipe source the
+ * block fallback.
+ */
+
+#define SOURCE_LENGTH 200000
+#define SKIPPED 10
+#define HEADER_LENGTH 7
+
+static uint8_t source[SOURCE_LENGTH];
+static const uint8_t header[HEADER_LENGTH] = {'h', 'e', 'a', 'd', 'e', 'r', '!'};
+
+static FILE *sourceFile(void) {
+    FILE *file = tmpfile();
+    if (file == NULL || fwrite(source, 1, SOURCE_LENGTH, file) != SOURCE_LENGTH) {
+        return NULL;
+    }
+    rewind(file);
+    return file;
+}
+
+// Reads SKIPPED bytes through the reader, so its stream has buffered ahead.
+static void skipHead(LB_Reader *reader) {
+    uint8_t skipped[SKIPPED];
+    LB_CHECK(lbRead(reader, skipped, SKIPPED) == LB_READER_ERROR_NONE);
+    LB_CHECK(memcmp(skipped, source, SKIPPED) == 0);
+}
+
+// Checks that `file`, from its current position, holds the header, `length` source bytes after the skipped ones and
+// the trailer.
+static void checkCopy(FILE *file, const size_t length) {
+    uint8_t *data = (uint8_t *) malloc(HEADER_LENGTH + length + 1 + 1);
+    const size_t read = fread(data, 1, HEADER_LENGTH + length + 1 + 1, file);
+    LB_CHECK(read == HEADER_LENGTH + length + 1);
+    LB_CHECK(memcmp(data, header, HEADER_LENGTH) == 0);
+    LB_CHECK(memcmp(data + HEADER_LENGTH, source + SKIPPED, length) == 0);
+    LB_CHECK(data[HEADER_LENGTH + length] == 0xEE);
+    free(data);
+}
+
+// Copies `length` bytes after the skipped ones, and checks that both streams continue where the copy ended.
+static void copy(LB_Writer *writer, LB_Reader *reader, const size_t length) {
+    skipHead(reader);
+    LB_CHECK(lbWrite(writer, header, HEADER_LENGTH) == LB_WRITER_ERROR_NONE);
+    LB_CHECK(lbWriterCopyFrom(writer, reader, length) == LB_WRITER_ERROR_NONE);
+    LB_CHECK(lbWriteU8(writer, 0xEE) == LB_WRITER_ERROR_NONE);
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    LB_CHECK(lbReadU8(reader, &e) == source[SKIPPED + length] && e == LB_READER_ERROR_NONE);
+}
+
+static void testFileToFile(void) {
+    FILE *in = sourceFile();
+    FILE *out = tmpfile();
+    LB_CHECK(in != NULL && out != NULL);
+    LB_Reader reader;
+    LB_Writer writer;
+    LB_CHECK(lbReaderInitFile(&reader, in) == LB_READER_INIT_NONE);
+    LB_CHECK(lbWriterInitFile(&writer, out) == LB_WRITER_INIT_NONE);
+
+    copy(&writer, &reader, 150000);
+    rewind(out);
+    checkCopy(out, 150000);
+
+    // The reader ends first.
+    LB_CHECK(lbWriterCopyFrom(&writer, &reader, SOURCE_LENGTH) == LB_WRITER_ERROR_INVALID_VALUE);
+    fclose(in);
+    fclose(out);
+}
+
+static void testFileToBuffer(void) {
+    FILE *in = sourceFile();
+    LB_CHECK(in != NULL);
+    LB_Reader reader;
+    LB_Writer writer;
+    LB_CHECK(lbReaderInitFile(&reader, in) == LB_READER_INIT_NONE);
+    LB_CHECK(lbWriterInitDynamicBuffer(&writer, 16) == LB_WRITER_INIT_NONE);
+
+    copy(&writer, &reader, 100000);
+    LB_CHECK(lbWriterPosition(&writer) == HEADER_LENGTH + 100000 + 1);
+    const uint8_t *data = (const uint8_t *) lbWriterData(&writer);
+    LB_CHECK(memcmp(data, header, HEADER_LENGTH) == 0);
+    LB_CHECK(memcmp(data + HEADER_LENGTH, source + SKIPPED, 100000) == 0);
+    LB_CHECK(data[HEADER_LENGTH + 100000] == 0xEE);
+    lbWriterFree(&writer);
+    fclose(in);
+}
+
+#ifdef HAS_PIPE
+// Less than the default pipe capacity, so neither end blocks without a second thread.
+#define PIPE_LENGTH 30000
+
+static void testFileToPipe(void) {
+    int fds[2];
+    LB_CHECK(pipe(fds) == 0);
+    FILE *in = sourceFile();
+    FILE *pipe_in = fdopen(fds[0], "rb");
+    FILE *pipe_out = fdopen(fds[1], "wb");
+    LB_CHECK(in != NULL && pipe_in != NULL && pipe_out != NULL);
+    LB_Reader reader;
+    LB_Writer writer;
+    LB_CHECK(lbReaderInitFile(&reader, in) == LB_READER_INIT_NONE);
+    LB_CHECK(lbWriterInitFile(&writer, pipe_out) == LB_WRITER_INIT_NONE);
+
+    copy(&writer, &reader, PIPE_LENGTH);
+    fclose(pipe_out);
+    checkCopy(pipe_in, PIPE_LENGTH);
+    fclose(pipe_in);
+    fclose(in);
+}
+
+static void testPipeToFile(void) {
+    int fds[2];
+    LB_CHECK(pipe(fds) == 0);
+    LB_CHECK(write(fds[1], source, PIPE_LENGTH) == PIPE_LENGTH);
+    close(fds[1]);
+    FILE *pipe_in = fdopen(fds[0], "rb");
+    FILE *out = tmpfile();
+    LB_CHECK(pipe_in != NULL && out != NULL);
+    LB_Reader reader;
+    LB_Writer writer;
+    LB_CHECK(lbReaderInitFile(&reader, pipe_in) == LB_READER_INIT_NONE);
+    LB_CHECK(lbWriterInitFile(&writer, out) == LB_WRITER_INIT_NONE);
+
+    copy(&writer, &reader, PIPE_LENGTH - SKIPPED - 1);
+    rewind(out);
+    checkCopy(out, PIPE_LENGTH - SKIPPED - 1);
+
+    // The pipe is drained.
+    LB_CHECK(lbWriterCopyFrom(&writer, &reader, 1) == LB_WRITER_ERROR_INVALID_VALUE);
+    fclose(pipe_in);
+    fclose(out);
+}
+#endif
+
+int main(void) {
+    for (size_t i = 0; i < SOURCE_LENGTH; i++) {
+        source[i] = (uint8_t) (i * 131 + (i >> 8));
+    }
+
+    testFileToFile();
+    testFileToBuffer();
+#ifdef HAS_PIPE
+    testFileToPipe();
+    testPipeToFile();
+#endif
+    return lbTestResult();
+}
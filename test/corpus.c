@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LB_BUFFER_IMPLEMENTATION
+#include "lb_buffer.h"
+
+#define LB_CORPUS_IMPLEMENTATION
+#include "lb_corpus.h"
+
+/*
+ * Generates a synthetic message corpus for `lb_buffer_benchmark --corpus`.
+ *
+ * Usage: lb_buffer_corpus <output> [--seed n] [--messages n] [--min-fields n] [--max-fields n] [--depth n]
+ *                         [--string-mean n] [--string-max n] [--ints uniform|small|log] [--floats uniform|normal]
+ *                         [--float-scale x] [--weights u8,u16,u32,u64,i32,i64,f32,f64,string,section]
+ */
+
+static int parseWeights(const char *text, LB_CorpusConfig *config) {
+    for (int type = LB_CORPUS_TYPE_U8; type <= LB_CORPUS_TYPE_SECTION; type++) {
+        char *end;
+        config->type_weights[type] = (uint32_t) strtoul(text, &end, 10);
+        if (end == text) {
+            return 0;
+        }
+
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return 1;
+}
+
+static int parseOptions(const int argc, char **argv, const char **out_path, LB_CorpusConfig *config) {
+    *out_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (arg[0] != '-') {
+            *out_path = arg;
+            continue;
+        }
+
+        if (value == NULL) {
+            return 0;
+        }
+
+        if (strcmp(arg, "--seed") == 0) {
+            config->seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--messages") == 0) {
+            config->message_count = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--min-fields") == 0) {
+            config->min_fields = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--max-fields") == 0) {
+            config->max_fields = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--depth") == 0) {
+            config->max_depth = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--string-mean") == 0) {
+            config->string_mean = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--string-max") == 0) {
+            config->string_max = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--ints") == 0) {
+            if (strcmp(value, "uniform") == 0) {
+                config->int_distribution = LB_CORPUS_INT_UNIFORM;
+            } else if (strcmp(value, "small") == 0) {
+                config->int_distribution = LB_CORPUS_INT_SMALL;
+            } else if (strcmp(value, "log") == 0) {
+                config->int_distribution = LB_CORPUS_INT_LOG;
+            } else {
+                return 0;
+            }
+        } else if (strcmp(arg, "--floats") == 0) {
+            if (strcmp(value, "uniform") == 0) {
+                config->float_distribution = LB_CORPUS_FLOAT_UNIFORM;
+            } else if (strcmp(value, "normal") == 0) {
+                config->float_distribution = LB_CORPUS_FLOAT_NORMAL;
+            } else {
+                return 0;
+            }
+        } else if (strcmp(arg, "--float-scale") == 0) {
+            config->float_scale = strtod(value, NULL);
+        } else if (strcmp(arg, "--weights") == 0) {
+            if (!parseWeights(value, config)) {
+                return 0;
+            }
+        } else {
+            return 0;
+        }
+
+        i++;
+    }
+
+    return *out_path != NULL;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path;
+    LB_CorpusConfig config = lbCorpusDefaultConfig();
+    if (!parseOptions(argc, argv, &path, &config)) {
+        fprintf(stderr, "Usage: %s <output> [--seed n] [--messages n] [--min-fields n] [--max-fields n] [--depth n]\n"
+                        "    [--string-mean n] [--string-max n] [--ints uniform|small|log] [--floats uniform|normal]\n"
+                        "    [--float-scale x] [--weights u8,u16,u32,u64,i32,i64,f32,f64,string,section]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s.\n", path);
+        return 1;
+    }
+
+    LB_Writer writer;
+    lbWriterInitFile(&writer, file);
+    const LB_WriterError error = lbCorpusGenerate(&writer, &config);
+    const size_t length = lbWriterPosition(&writer);
+    if (fclose(file) != 0 || error) {
+        fprintf(stderr, "Failed to write %s: %s\n", path, lbWriterErrorMessage(error));
+        return 1;
+    }
+
+    printf("Wrote %u messages, %zu bytes, to %s.\n", config.message_count, length, path);
+    return 0;
+}
@@ -0,0 +1,686 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_BENCH_H
+#define LB_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Minimal benchmark harness for lb_buffer_benchmark.
+ *
+ * A benchmark is a function that performs `count` operations. It is run `warmup` times untimed,
+ * then `repetitions` times timed, and the per-operation times of those samples are summarized.
+ */
+
+#define LB_BENCH_NAME_LENGTH 96
+
+// "LBBN" read as a little endian u32, the first field of a baseline file.
+#define LB_BENCH_BASELINE_MAGIC 0x4E42424Cu
+#define LB_BENCH_BASELINE_VERSION 1
+
+// Hardware events counted around each sample when counters are enabled.
+typedef enum LB_BenchCounter {
+    LB_BENCH_COUNTER_CYCLES,
+    LB_BENCH_COUNTER_INSTRUCTIONS,
+    LB_BENCH_COUNTER_BRANCH_MISSES,
+    LB_BENCH_COUNTER_L1D_MISSES,
+    LB_BENCH_COUNTER_LLC_MISSES,
+    LB_BENCH_COUNTER_DTLB_MISSES,
+    LB_BENCH_COUNTER_COUNT,
+} LB_BenchCounter;
+
+// Where the counters come from.
+typedef enum LB_BenchCounterSource {
+    // No counters, either disabled or not supported.
+    LB_BENCH_COUNTER_SOURCE_NONE,
+    // perf_event_open, any subset of the events may be available.
+    LB_BENCH_COUNTER_SOURCE_PERF,
+    // Only LB_BENCH_COUNTER_CYCLES, as reference cycles from the time stamp counter.
+    LB_BENCH_COUNTER_SOURCE_RDTSC,
+} LB_BenchCounterSource;
+
+typedef void (*LB_BenchFn)(void *context, size_t count);
+
+typedef struct LB_BenchOptions {
+    // Only benchmarks whose name contains this are run, NULL runs all.
+    const char *filter;
+    uint32_t warmup;
+    uint32_t repetitions;
+    // Operations per sample.
+    size_t batch;
+    // Collect and print hardware counters.
+    int counters;
+    // Write the results of this run as a baseline file, NULL to skip.
+    const char *save_path;
+    // Compare the results of this run against a baseline file, NULL to skip.
+    const char *compare_path;
+    // Relative increase of the median that counts as a regression, 0.05 is 5%.
+    double threshold;
+} LB_BenchOptions;
+
+typedef struct LB_BenchResult {
+    char name[LB_BENCH_NAME_LENGTH];
+    double median_ns;
+    double p99_ns;
+    double mean_ns;
+    double min_ns;
+    double stddev_ns;
+    double bytes_per_op;
+    uint32_t repetitions;
+    LB_BenchCounterSource counter_source;
+    // Bit (1 << LB_BenchCounter) is set for every counter that was collected.
+    uint32_t counters_available;
+    // Per operation, averaged over all repetitions.
+    double counters[LB_BENCH_COUNTER_COUNT];
+} LB_BenchResult;
+
+extern LB_BenchOptions lb_bench_options;
+
+// Parse the harness options from the command line, returns 0 if they are invalid.
+int lbBenchParseOptions(int argc, char **argv);
+
+int lbBenchSelected(const char *name);
+
+uint64_t lbBenchNow(void);
+
+// Open the hardware counters, falling back to rdtsc when perf_event_open is unavailable.
+LB_BenchCounterSource lbBenchCountersOpen(void);
+
+void lbBenchCountersClose(void);
+
+const char *lbBenchCounterName(LB_BenchCounter counter);
+
+/**
+ * Run and report one benchmark, unless it is filtered out.
+ *
+ * @param bytes_per_op The number of payload bytes per operation, used for the GB/s column. 0 hides it.
+ * @return The result, or NULL if the benchmark was not selected.
+ */
+const LB_BenchResult *lbBenchRun(const char *name, LB_BenchFn fn, void *context, double bytes_per_op);
+
+void lbBenchPrintHeader(void);
+
+/**
+ * Write every result recorded so far as a baseline file. <br>
+ * The file is a LB_Writer stream of little endian fields: u32 magic, u16 version, u32 count, then for every result
+ * a u8 name length, the name, f64 median, p99, mean, min and stddev in ns/op and a u32 repetition count.
+ *
+ * @return 1 on success, 0 if the file could not be written.
+ */
+int lbBenchSaveBaseline(const char *path);
+
+/**
+ * Read a baseline file written by lbBenchSaveBaseline.
+ *
+ * @param out_results Set to an array allocated with malloc, which the caller frees.
+ * @return 1 on success, 0 if the file is missing or malformed.
+ */
+int lbBenchLoadBaseline(const char *path, LB_BenchResult **out_results, size_t *out_count);
+
+/**
+ * Compare every result recorded so far against a baseline and print the differences. <br>
+ * A kernel regressed when its median grew by more than lb_bench_options.threshold and the difference of the means
+ * is significant, that is Welch's t statistic is above 3.
+ *
+ * @return The number of regressed kernels.
+ */
+size_t lbBenchCompare(const LB_BenchResult *baseline, size_t baseline_count);
+
+// Save and compare as requested by the options and release the recorded results, returns the process exit code.
+int lbBenchFinish(void);
+
+#endif //LB_BENCH_H
+
+#ifdef LB_BENCH_IMPLEMENTATION
+#include "lb_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define LB_BENCH_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LB_BENCH_RDTSC 1
+#endif
+
+LB_BenchOptions lb_bench_options = {
+    .filter = NULL,
+    .warmup = 3,
+    .repetitions = 51,
+    .batch = 4096,
+    .counters = 0,
+    .save_path = NULL,
+    .compare_path = NULL,
+    .threshold = 0.05,
+};
+
+// Every result of this run, in order, for saving and comparing.
+static LB_BenchResult *lb_bench_results = NULL;
+static size_t lb_bench_result_count = 0;
+static size_t lb_bench_result_capacity = 0;
+
+static LB_BenchCounterSource lb_bench_counter_source = LB_BENCH_COUNTER_SOURCE_NONE;
+static int lb_bench_counters_opened = 0;
+#ifdef __linux__
+// Group leader and the counter each slot of a group read belongs to, in the order they were opened.
+static int lb_bench_perf_leader = -1;
+static int lb_bench_perf_fds[LB_BENCH_COUNTER_COUNT];
+static LB_BenchCounter lb_bench_perf_slots[LB_BENCH_COUNTER_COUNT];
+static uint32_t lb_bench_perf_slot_count = 0;
+#endif
+
+int lbBenchParseOptions(const int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--filter") == 0 && value) {
+            lb_bench_options.filter = value;
+        } else if (strcmp(arg, "--warmup") == 0 && value) {
+            lb_bench_options.warmup = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--repetitions") == 0 && value) {
+            lb_bench_options.repetitions = (uint32_t) strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--batch") == 0 && value) {
+            lb_bench_options.batch = (size_t) strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--save") == 0 && value) {
+            lb_bench_options.save_path = value;
+        } else if (strcmp(arg, "--compare") == 0 && value) {
+            lb_bench_options.compare_path = value;
+        } else if (strcmp(arg, "--threshold") == 0 && value) {
+            lb_bench_options.threshold = strtod(value, NULL) / 100.0;
+        } else if (strcmp(arg, "--counters") == 0) {
+            lb_bench_options.counters = 1;
+            continue;
+        } else {
+            continue;
+        }
+
+        i++;
+    }
+
+    return lb_bench_options.repetitions > 0 && lb_bench_options.batch > 0 && lb_bench_options.threshold >= 0.0;
+}
+
+int lbBenchSelected(const char *name) {
+    return lb_bench_options.filter == NULL || strstr(name, lb_bench_options.filter) != NULL;
+}
+
+uint64_t lbBenchNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+const char *lbBenchCounterName(const LB_BenchCounter counter) {
+    switch (counter) {
+        case LB_BENCH_COUNTER_CYCLES: return "cycles";
+        case LB_BENCH_COUNTER_INSTRUCTIONS: return "instructions";
+        case LB_BENCH_COUNTER_BRANCH_MISSES: return "branch-misses";
+        case LB_BENCH_COUNTER_L1D_MISSES: return "L1d-misses";
+        case LB_BENCH_COUNTER_LLC_MISSES: return "LLC-misses";
+        case LB_BENCH_COUNTER_DTLB_MISSES: return "dTLB-misses";
+        default: return "unknown";
+    }
+}
+
+#ifdef __linux__
+static int lbBenchPerfOpen(const LB_BenchCounter counter, const int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = group == -1;
+    // Only the benchmark itself, which also keeps this usable with perf_event_paranoid=2.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    const uint64_t cache_read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    switch (counter) {
+        case LB_BENCH_COUNTER_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case LB_BENCH_COUNTER_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case LB_BENCH_COUNTER_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case LB_BENCH_COUNTER_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | cache_read_miss;
+            break;
+        case LB_BENCH_COUNTER_LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case LB_BENCH_COUNTER_DTLB_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | cache_read_miss;
+            break;
+        default:
+            return -1;
+    }
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static LB_BenchCounterSource lbBenchPerfOpenAll(void) {
+    for (int counter = 0; counter < LB_BENCH_COUNTER_COUNT; counter++) {
+        const int fd = lbBenchPerfOpen((LB_BenchCounter) counter, lb_bench_perf_leader);
+        if (fd < 0) {
+            continue;
+        }
+
+        if (lb_bench_perf_leader == -1) {
+            lb_bench_perf_leader = fd;
+        }
+
+        lb_bench_perf_fds[lb_bench_perf_slot_count] = fd;
+        lb_bench_perf_slots[lb_bench_perf_slot_count] = (LB_BenchCounter) counter;
+        lb_bench_perf_slot_count++;
+    }
+
+    return lb_bench_perf_leader == -1 ? LB_BENCH_COUNTER_SOURCE_NONE : LB_BENCH_COUNTER_SOURCE_PERF;
+}
+#endif
+
+LB_BenchCounterSource lbBenchCountersOpen(void) {
+    if (lb_bench_counters_opened) {
+        return lb_bench_counter_source;
+    }
+
+    lb_bench_counters_opened = 1;
+#ifdef __linux__
+    lb_bench_counter_source = lbBenchPerfOpenAll();
+#endif
+#ifdef LB_BENCH_RDTSC
+    if (lb_bench_counter_source == LB_BENCH_COUNTER_SOURCE_NONE) {
+        lb_bench_counter_source = LB_BENCH_COUNTER_SOURCE_RDTSC;
+    }
+#endif
+    return lb_bench_counter_source;
+}
+
+void lbBenchCountersClose(void) {
+#ifdef __linux__
+    for (uint32_t i = 0; i < lb_bench_perf_slot_count; i++) {
+        close(lb_bench_perf_fds[i]);
+    }
+
+    lb_bench_perf_leader = -1;
+    lb_bench_perf_slot_count = 0;
+#endif
+    lb_bench_counter_source = LB_BENCH_COUNTER_SOURCE_NONE;
+    lb_bench_counters_opened = 0;
+}
+
+static void lbBenchCountersStart(uint64_t *tsc) {
+#ifdef __linux__
+    if (lb_bench_counter_source == LB_BENCH_COUNTER_SOURCE_PERF) {
+        ioctl(lb_bench_perf_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(lb_bench_perf_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return;
+    }
+#endif
+#ifdef LB_BENCH_RDTSC
+    *tsc = __rdtsc();
+#else
+    (void) tsc;
+#endif
+}
+
+// Stop counting and add the counts of this sample to totals.
+static void lbBenchCountersStop(const uint64_t tsc, uint64_t *totals) {
+#ifdef __linux__
+    if (lb_bench_counter_source == LB_BENCH_COUNTER_SOURCE_PERF) {
+        ioctl(lb_bench_perf_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t values[1 + LB_BENCH_COUNTER_COUNT];
+        const ssize_t length = read(lb_bench_perf_leader, values, sizeof(values));
+        if (length < (ssize_t) sizeof(uint64_t)) {
+            return;
+        }
+
+        for (uint64_t i = 0; i < values[0] && i < lb_bench_perf_slot_count; i++) {
+            totals[lb_bench_perf_slots[i]] += values[1 + i];
+        }
+        return;
+    }
+#endif
+#ifdef LB_BENCH_RDTSC
+    if (lb_bench_counter_source == LB_BENCH_COUNTER_SOURCE_RDTSC) {
+        totals[LB_BENCH_COUNTER_CYCLES] += __rdtsc() - tsc;
+    }
+#else
+    (void) tsc;
+    (void) totals;
+#endif
+}
+
+static uint32_t lbBenchCountersAvailable(void) {
+#ifdef __linux__
+    if (lb_bench_counter_source == LB_BENCH_COUNTER_SOURCE_PERF) {
+        uint32_t available = 0;
+        for (uint32_t i = 0; i < lb_bench_perf_slot_count; i++) {
+            available |= 1u << lb_bench_perf_slots[i];
+        }
+        return available;
+    }
+#endif
+    return lb_bench_counter_source == LB_BENCH_COUNTER_SOURCE_RDTSC ? 1u << LB_BENCH_COUNTER_CYCLES : 0;
+}
+
+static void lbBenchPrintCounters(const LB_BenchResult *result) {
+    if (result->counter_source == LB_BENCH_COUNTER_SOURCE_NONE) {
+        return;
+    }
+
+    printf("    %s", result->counter_source == LB_BENCH_COUNTER_SOURCE_RDTSC ? "rdtsc" : "perf");
+    for (int counter = 0; counter < LB_BENCH_COUNTER_COUNT; counter++) {
+        if (result->counters_available & (1u << counter)) {
+            printf("  %s/op %.3f", lbBenchCounterName((LB_BenchCounter) counter), result->counters[counter]);
+        }
+    }
+
+    const uint32_t ipc = (1u << LB_BENCH_COUNTER_CYCLES) | (1u << LB_BENCH_COUNTER_INSTRUCTIONS);
+    if ((result->counters_available & ipc) == ipc && result->counters[LB_BENCH_COUNTER_CYCLES] > 0.0) {
+        printf("  IPC %.2f", result->counters[LB_BENCH_COUNTER_INSTRUCTIONS] / result->counters[LB_BENCH_COUNTER_CYCLES]);
+    }
+
+    printf("\n");
+}
+
+static int lbBenchCompareDouble(const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples.
+static double lbBenchPercentile(const double *sorted, const uint32_t count, const double percentile) {
+    size_t rank = (size_t) ceil(percentile / 100.0 * count);
+    rank = rank == 0 ? 1 : rank;
+    return sorted[rank - 1];
+}
+
+void lbBenchPrintHeader(void) {
+    printf("%-48s %12s %12s %10s %12s\n", "benchmark", "ns/op", "p99 ns/op", "GB/s", "Mcalls/s");
+}
+
+const LB_BenchResult *lbBenchRun(const char *name, const LB_BenchFn fn, void *context, const double bytes_per_op) {
+    if (!lbBenchSelected(name)) {
+        return NULL;
+    }
+
+    if (lb_bench_result_count == lb_bench_result_capacity) {
+        const size_t capacity = lb_bench_result_capacity ? lb_bench_result_capacity * 2 : 64;
+        LB_BenchResult *results = (LB_BenchResult *) realloc(lb_bench_results, capacity * sizeof(LB_BenchResult));
+        if (results == NULL) {
+            return NULL;
+        }
+
+        lb_bench_results = results;
+        lb_bench_result_capacity = capacity;
+    }
+
+    const size_t batch = lb_bench_options.batch;
+    const uint32_t repetitions = lb_bench_options.repetitions;
+    for (uint32_t i = 0; i < lb_bench_options.warmup; i++) {
+        fn(context, batch);
+    }
+
+    double *samples = (double *) malloc(repetitions * sizeof(double));
+    if (samples == NULL) {
+        return NULL;
+    }
+
+    if (lb_bench_options.counters && lbBenchCountersOpen() == LB_BENCH_COUNTER_SOURCE_NONE) {
+        fprintf(stderr, "Hardware counters are not available, disabling them.\n");
+        lb_bench_options.counters = 0;
+    }
+
+    // The counters are kept outside of the timed region so they do not skew the wall clock.
+    uint64_t totals[LB_BENCH_COUNTER_COUNT] = {0};
+    double sum = 0.0;
+    for (uint32_t i = 0; i < repetitions; i++) {
+        uint64_t tsc = 0;
+        if (lb_bench_options.counters) {
+            lbBenchCountersStart(&tsc);
+        }
+
+        const uint64_t start = lbBenchNow();
+        fn(context, batch);
+        const uint64_t end = lbBenchNow();
+        if (lb_bench_options.counters) {
+            lbBenchCountersStop(tsc, totals);
+        }
+
+        samples[i] = (double) (end - start) / (double) batch;
+        sum += samples[i];
+    }
+
+    qsort(samples, repetitions, sizeof(double), lbBenchCompareDouble);
+
+    const double mean = sum / repetitions;
+    double variance = 0.0;
+    for (uint32_t i = 0; i < repetitions; i++) {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+
+    LB_BenchResult result;
+    memset(&result, 0, sizeof(result));
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    result.median_ns = lbBenchPercentile(samples, repetitions, 50.0);
+    result.p99_ns = lbBenchPercentile(samples, repetitions, 99.0);
+    result.mean_ns = mean;
+    result.min_ns = samples[0];
+    result.stddev_ns = repetitions > 1 ? sqrt(variance / (repetitions - 1)) : 0.0;
+    result.bytes_per_op = bytes_per_op;
+    result.repetitions = repetitions;
+    if (lb_bench_options.counters) {
+        result.counter_source = lb_bench_counter_source;
+        result.counters_available = lbBenchCountersAvailable();
+        for (int counter = 0; counter < LB_BENCH_COUNTER_COUNT; counter++) {
+            result.counters[counter] = (double) totals[counter] / ((double) repetitions * (double) batch);
+        }
+    }
+    free(samples);
+
+    // Bytes per nanosecond are gigabytes per second.
+    if (bytes_per_op > 0.0) {
+        printf("%-48s %12.3f %12.3f %10.3f %12.2f\n", name, result.median_ns, result.p99_ns,
+               bytes_per_op / result.median_ns, 1000.0 / result.median_ns);
+    } else {
+        printf("%-48s %12.3f %12.3f %10s %12.2f\n", name, result.median_ns, result.p99_ns, "-", 1000.0 / result.median_ns);
+    }
+
+    lbBenchPrintCounters(&result);
+    fflush(stdout);
+    lb_bench_results[lb_bench_result_count] = result;
+    return &lb_bench_results[lb_bench_result_count++];
+}
+
+int lbBenchSaveBaseline(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    LB_Writer writer;
+    lbWriterInitFile(&writer, file);
+
+    LB_WriterError e = LB_WRITER_ERROR_NONE;
+    e |= lbWriteU32LE(&writer, LB_BENCH_BASELINE_MAGIC);
+    e |= lbWriteU16LE(&writer, LB_BENCH_BASELINE_VERSION);
+    e |= lbWriteU32LE(&writer, (uint32_t) lb_bench_result_count);
+    for (size_t i = 0; i < lb_bench_result_count; i++) {
+        const LB_BenchResult *result = &lb_bench_results[i];
+        const size_t name_length = strlen(result->name);
+        e |= lbWriteU8(&writer, (uint8_t) name_length);
+        e |= lbWrite(&writer, result->name, name_length);
+        e |= lbWriteF64LE(&writer, result->median_ns);
+        e |= lbWriteF64LE(&writer, result->p99_ns);
+        e |= lbWriteF64LE(&writer, result->mean_ns);
+        e |= lbWriteF64LE(&writer, result->min_ns);
+        e |= lbWriteF64LE(&writer, result->stddev_ns);
+        e |= lbWriteU32LE(&writer, result->repetitions);
+    }
+
+    const int failed = ferror(file);
+    return fclose(file) == 0 && !failed && e == LB_WRITER_ERROR_NONE;
+}
+
+// Read a fixed size little endian field, lbRead reports a short file even with safety compiled out.
+static LB_ReaderError lbBenchReadField(LB_Reader *reader, void *out_value, const size_t length) {
+    return lbReadLE(reader, out_value, length);
+}
+
+int lbBenchLoadBaseline(const char *path, LB_BenchResult **out_results, size_t *out_count) {
+    *out_results = NULL;
+    *out_count = 0;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    LB_Reader reader;
+    lbReaderInitFile(&reader, file);
+
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint32_t count = 0;
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    e |= lbBenchReadField(&reader, &magic, sizeof(magic));
+    e |= lbBenchReadField(&reader, &version, sizeof(version));
+    e |= lbBenchReadField(&reader, &count, sizeof(count));
+
+    // Every record is at least a length byte, five f64 and a u32.
+    const size_t minimum_record = 1 + 5 * sizeof(double) + sizeof(uint32_t);
+    if (e || magic != LB_BENCH_BASELINE_MAGIC || version != LB_BENCH_BASELINE_VERSION ||
+        count > lbReaderRemaining(&reader) / minimum_record) {
+        fclose(file);
+        return 0;
+    }
+
+    LB_BenchResult *results = (LB_BenchResult *) calloc(count ? count : 1, sizeof(LB_BenchResult));
+    if (results == NULL) {
+        fclose(file);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < count && !e; i++) {
+        LB_BenchResult *result = &results[i];
+        uint8_t name_length = 0;
+        e |= lbBenchReadField(&reader, &name_length, sizeof(name_length));
+        if (e || name_length >= LB_BENCH_NAME_LENGTH) {
+            e |= LB_READER_ERROR_INVALID_VALUE;
+            break;
+        }
+
+        e |= lbRead(&reader, result->name, name_length);
+        result->name[name_length] = '\0';
+        e |= lbBenchReadField(&reader, &result->median_ns, sizeof(double));
+        e |= lbBenchReadField(&reader, &result->p99_ns, sizeof(double));
+        e |= lbBenchReadField(&reader, &result->mean_ns, sizeof(double));
+        e |= lbBenchReadField(&reader, &result->min_ns, sizeof(double));
+        e |= lbBenchReadField(&reader, &result->stddev_ns, sizeof(double));
+        e |= lbBenchReadField(&reader, &result->repetitions, sizeof(uint32_t));
+    }
+
+    fclose(file);
+    if (e) {
+        free(results);
+        return 0;
+    }
+
+    *out_results = results;
+    *out_count = count;
+    return 1;
+}
+
+size_t lbBenchCompare(const LB_BenchResult *baseline, const size_t baseline_count) {
+    size_t regressions = 0;
+    printf("%-48s %12s %12s %9s %8s\n", "benchmark", "base ns/op", "ns/op", "change", "t");
+    for (size_t i = 0; i < lb_bench_result_count; i++) {
+        const LB_BenchResult *current = &lb_bench_results[i];
+        const LB_BenchResult *base = NULL;
+        for (size_t j = 0; j < baseline_count; j++) {
+            if (strcmp(baseline[j].name, current->name) == 0) {
+                base = &baseline[j];
+                break;
+            }
+        }
+
+        if (base == NULL) {
+            printf("%-48s %12s %12.3f %9s %8s  new\n", current->name, "-", current->median_ns, "-", "-");
+            continue;
+        }
+
+        const double change = base->median_ns > 0.0 ? current->median_ns / base->median_ns - 1.0 : 0.0;
+        // Welch's t statistic of the means, positive when this run is slower.
+        const double variance = base->stddev_ns * base->stddev_ns / (base->repetitions ? base->repetitions : 1) +
+                                current->stddev_ns * current->stddev_ns / (current->repetitions ? current->repetitions : 1);
+        const double difference = current->mean_ns - base->mean_ns;
+        const double t = variance > 0.0 ? difference / sqrt(variance) : (difference > 0.0 ? INFINITY : difference < 0.0 ? -INFINITY : 0.0);
+
+        const char *verdict = "";
+        if (change > lb_bench_options.threshold && t > 3.0) {
+            verdict = "  REGRESSION";
+            regressions++;
+        } else if (change < -lb_bench_options.threshold && t < -3.0) {
+            verdict = "  improved";
+        }
+
+        printf("%-48s %12.3f %12.3f %+8.1f%% %8.2f%s\n", current->name, base->median_ns, current->median_ns,
+               change * 100.0, t, verdict);
+    }
+
+    printf("%zu of %zu benchmarks regressed by more than %.1f%%\n", regressions, lb_bench_result_count,
+           lb_bench_options.threshold * 100.0);
+    return regressions;
+}
+
+int lbBenchFinish(void) {
+    int status = 0;
+    if (lb_bench_options.compare_path != NULL) {
+        LB_BenchResult *baseline;
+        size_t baseline_count;
+        if (lbBenchLoadBaseline(lb_bench_options.compare_path, &baseline, &baseline_count)) {
+            printf("\n");
+            if (lbBenchCompare(baseline, baseline_count) > 0) {
+                status = 1;
+            }
+            free(baseline);
+        } else {
+            fprintf(stderr, "Failed to read the baseline %s.\n", lb_bench_options.compare_path);
+            status = 1;
+        }
+    }
+
+    if (lb_bench_options.save_path != NULL && !lbBenchSaveBaseline(lb_bench_options.save_path)) {
+        fprintf(stderr, "Failed to write the baseline %s.\n", lb_bench_options.save_path);
+        status = 1;
+    }
+
+    free(lb_bench_results);
+    lb_bench_results = NULL;
+    lb_bench_result_count = 0;
+    lb_bench_result_capacity = 0;
+    return status;
+}
+
+#endif //LB_BENCH_IMPLEMENTATION
@@ -0,0 +1,708 @@
+// ReSharper disable CppNonInlineFunctionDefinitionInHeaderFile
+#ifndef LB_CORPUS_H
+#define LB_CORPUS_H
+
+#include "lb_buffer.h"
+
+/*
+ * Synthetic message corpora for replay benchmarks.
+ *
+ * A corpus is a LB_Writer stream of little endian fields: u32 magic, u16 version, u32 message count, then every
+ * message as a u32 length followed by its fields. A field is a u8 LB_CorpusType tag followed by its value:
+ * fixed size integers and floats, strings as a u16 length and the bytes, and sections as a u32 length followed
+ * by nested fields.
+ */
+
+// "LBCP" read as a little endian u32.
+#define LB_CORPUS_MAGIC 0x5043424Cu
+#define LB_CORPUS_VERSION 1
+// Deepest nesting of sections, not counting the message itself.
+#define LB_CORPUS_MAX_DEPTH 8
+#define LB_CORPUS_MAX_STRING 65535
+
+typedef enum LB_CorpusType {
+    LB_CORPUS_TYPE_U8 = 1,
+    LB_CORPUS_TYPE_U16 = 2,
+    LB_CORPUS_TYPE_U32 = 3,
+    LB_CORPUS_TYPE_U64 = 4,
+    LB_CORPUS_TYPE_I32 = 5,
+    LB_CORPUS_TYPE_I64 = 6,
+    LB_CORPUS_TYPE_F32 = 7,
+    LB_CORPUS_TYPE_F64 = 8,
+    LB_CORPUS_TYPE_STRING = 9,
+    LB_CORPUS_TYPE_SECTION = 10,
+    // Not encoded, marks the end of a section in a parsed value list.
+    LB_CORPUS_TYPE_SECTION_END = 11,
+    // Not encoded, marks the end of a message in a parsed value list.
+    LB_CORPUS_TYPE_MESSAGE_END = 12,
+} LB_CorpusType;
+
+// Number of encoded types, used to size type_weights.
+#define LB_CORPUS_TYPE_COUNT 11
+
+typedef enum LB_CorpusIntDistribution {
+    // Uniform over the whole range of the type.
+    LB_CORPUS_INT_UNIFORM,
+    // Geometric, most values are below 128 like counters and enum values.
+    LB_CORPUS_INT_SMALL,
+    // Log-uniform, every magnitude is equally likely like ids and sizes.
+    LB_CORPUS_INT_LOG,
+} LB_CorpusIntDistribution;
+
+typedef enum LB_CorpusFloatDistribution {
+    // Uniform in [-float_scale, float_scale].
+    LB_CORPUS_FLOAT_UNIFORM,
+    // Normal with a standard deviation of float_scale.
+    LB_CORPUS_FLOAT_NORMAL,
+} LB_CorpusFloatDistribution;
+
+typedef struct LB_CorpusConfig {
+    uint64_t seed;
+    uint32_t message_count;
+    // Fields per message and per section, uniform in [min_fields, max_fields].
+    uint32_t min_fields;
+    uint32_t max_fields;
+    // Deepest nesting of sections, at most LB_CORPUS_MAX_DEPTH.
+    uint32_t max_depth;
+    // Relative frequency of every field type, indexed by LB_CorpusType.
+    uint32_t type_weights[LB_CORPUS_TYPE_COUNT];
+    // Strings are geometric with this mean, with a long tail up to string_max.
+    uint32_t string_mean;
+    uint32_t string_max;
+    LB_CorpusIntDistribution int_distribution;
+    LB_CorpusFloatDistribution float_distribution;
+    double float_scale;
+} LB_CorpusConfig;
+
+// A loaded corpus, every message is data[offsets[i]..offsets[i + 1]] including its length prefix.
+typedef struct LB_Corpus {
+    uint8_t *data;
+    size_t length;
+    size_t *offsets;
+    size_t message_count;
+} LB_Corpus;
+
+// One field of a parsed message. Strings point into the corpus they were parsed from.
+typedef struct LB_CorpusValue {
+    LB_CorpusType type;
+    uint32_t length;
+    union {
+        uint64_t u;
+        int64_t i;
+        double f;
+        const uint8_t *string;
+    };
+} LB_CorpusValue;
+
+// A config that resembles a mixed RPC workload.
+LB_CorpusConfig lbCorpusDefaultConfig(void);
+
+/**
+ * Generate a corpus.
+ *
+ * @param writer Any writer, a file writer produces a corpus file.
+ * @return The accumulated write errors, LB_WRITER_ERROR_NONE on success.
+ */
+LB_WriterError lbCorpusGenerate(LB_Writer *writer, const LB_CorpusConfig *config);
+
+/**
+ * Load a corpus written by lbCorpusGenerate.
+ *
+ * @return 1 on success, 0 if the corpus is malformed or memory could not be allocated.
+ */
+int lbCorpusLoad(LB_Reader *reader, LB_Corpus *out_corpus);
+
+void lbCorpusFree(LB_Corpus *corpus);
+
+/**
+ * Parse every message of a corpus into a flat list of values, each message followed by LB_CORPUS_TYPE_MESSAGE_END
+ * and each section by LB_CORPUS_TYPE_SECTION_END.
+ *
+ * @param out_values Set to an array allocated with malloc, which the caller frees.
+ * @return 1 on success, 0 if the corpus is malformed or memory could not be allocated.
+ */
+int lbCorpusParse(const LB_Corpus *corpus, LB_CorpusValue **out_values, size_t *out_count);
+
+/**
+ * Encode one message of a parsed value list, backpatching the message and section lengths.
+ *
+ * @return The number of values consumed, including the LB_CORPUS_TYPE_MESSAGE_END.
+ */
+size_t lbCorpusEncodeMessage(LB_Writer *writer, const LB_CorpusValue *values, LB_WriterError *out_error);
+
+/**
+ * Decode one message, reading every field by its type.
+ *
+ * @param scratch At least LB_CORPUS_MAX_STRING bytes, strings are copied into it.
+ * @param checksum Every decoded value is mixed into it, so the work cannot be optimized out.
+ */
+LB_ReaderError lbCorpusDecodeMessage(LB_Reader *reader, uint8_t *scratch, uint64_t *checksum);
+
+#endif //LB_CORPUS_H
+
+#ifdef LB_CORPUS_IMPLEMENTATION
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct LB_CorpusRandom {
+    uint64_t state;
+} LB_CorpusRandom;
+
+// splitmix64.
+static uint64_t lbCorpusRandomNext(LB_CorpusRandom *random) {
+    uint64_t z = (random->state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1).
+static double lbCorpusRandomUnit(LB_CorpusRandom *random) {
+    return (double) (lbCorpusRandomNext(random) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Uniform in [min, max].
+static uint32_t lbCorpusRandomRange(LB_CorpusRandom *random, const uint32_t min, const uint32_t max) {
+    return min + (uint32_t) (lbCorpusRandomNext(random) % ((uint64_t) max - min + 1));
+}
+
+LB_CorpusConfig lbCorpusDefaultConfig(void) {
+    LB_CorpusConfig config = {
+        .seed = 1,
+        .message_count = 4096,
+        .min_fields = 2,
+        .max_fields = 16,
+        .max_depth = 3,
+        .string_mean = 12,
+        .string_max = 4096,
+        .int_distribution = LB_CORPUS_INT_SMALL,
+        .float_distribution = LB_CORPUS_FLOAT_NORMAL,
+        .float_scale = 100.0,
+    };
+
+    config.type_weights[LB_CORPUS_TYPE_U8] = 10;
+    config.type_weights[LB_CORPUS_TYPE_U16] = 8;
+    config.type_weights[LB_CORPUS_TYPE_U32] = 15;
+    config.type_weights[LB_CORPUS_TYPE_U64] = 8;
+    config.type_weights[LB_CORPUS_TYPE_I32] = 12;
+    config.type_weights[LB_CORPUS_TYPE_I64] = 5;
+    config.type_weights[LB_CORPUS_TYPE_F32] = 12;
+    config.type_weights[LB_CORPUS_TYPE_F64] = 8;
+    config.type_weights[LB_CORPUS_TYPE_STRING] = 15;
+    config.type_weights[LB_CORPUS_TYPE_SECTION] = 7;
+    return config;
+}
+
+static LB_CorpusType lbCorpusRandomType(LB_CorpusRandom *random, const LB_CorpusConfig *config, const int allow_section) {
+    uint64_t total = 0;
+    for (int type = LB_CORPUS_TYPE_U8; type <= LB_CORPUS_TYPE_SECTION; type++) {
+        if (type != LB_CORPUS_TYPE_SECTION || allow_section) {
+            total += config->type_weights[type];
+        }
+    }
+
+    if (total == 0) {
+        return LB_CORPUS_TYPE_U32;
+    }
+
+    uint64_t pick = lbCorpusRandomNext(random) % total;
+    for (int type = LB_CORPUS_TYPE_U8; type <= LB_CORPUS_TYPE_SECTION; type++) {
+        if (type == LB_CORPUS_TYPE_SECTION && !allow_section) {
+            continue;
+        }
+
+        if (pick < config->type_weights[type]) {
+            return (LB_CorpusType) type;
+        }
+        pick -= config->type_weights[type];
+    }
+
+    return LB_CORPUS_TYPE_U32;
+}
+
+// A magnitude that fits in `bits` bits, following the configured distribution.
+static uint64_t lbCorpusRandomInt(LB_CorpusRandom *random, const LB_CorpusConfig *config, const uint32_t bits) {
+    const uint64_t mask = bits == 64 ? UINT64_MAX : (1ull << bits) - 1;
+    switch (config->int_distribution) {
+        case LB_CORPUS_INT_SMALL: {
+            // Geometric with p = 1/16, capped by the type.
+            const double u = lbCorpusRandomUnit(random);
+            const double value = floor(log1p(-u) / log1p(-1.0 / 16.0));
+            return value >= (double) mask ? mask : (uint64_t) value;
+        }
+        case LB_CORPUS_INT_LOG: {
+            const uint32_t magnitude = lbCorpusRandomRange(random, 0, bits);
+            if (magnitude == 0) {
+                return 0;
+            }
+            const uint64_t top = 1ull << (magnitude - 1);
+            return (top | (lbCorpusRandomNext(random) & (top - 1))) & mask;
+        }
+        case LB_CORPUS_INT_UNIFORM:
+        default:
+            return lbCorpusRandomNext(random) & mask;
+    }
+}
+
+static int64_t lbCorpusRandomSigned(LB_CorpusRandom *random, const LB_CorpusConfig *config, const uint32_t bits) {
+    const uint64_t magnitude = lbCorpusRandomInt(random, config, bits - 1);
+    return lbCorpusRandomNext(random) & 1 ? -(int64_t) magnitude - 1 : (int64_t) magnitude;
+}
+
+static double lbCorpusRandomFloat(LB_CorpusRandom *random, const LB_CorpusConfig *config) {
+    if (config->float_distribution == LB_CORPUS_FLOAT_NORMAL) {
+        // Box-Muller.
+        const double u = 1.0 - lbCorpusRandomUnit(random);
+        const double v = lbCorpusRandomUnit(random);
+        return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v) * config->float_scale;
+    }
+
+    return (lbCorpusRandomUnit(random) * 2.0 - 1.0) * config->float_scale;
+}
+
+static uint32_t lbCorpusRandomStringLength(LB_CorpusRandom *random, const LB_CorpusConfig *config) {
+    uint32_t length;
+    // One string in twenty is drawn from the long tail.
+    if (lbCorpusRandomNext(random) % 20 == 0) {
+        length = lbCorpusRandomRange(random, 0, config->string_max);
+    } else {
+        const double p = 1.0 / (config->string_mean + 1.0);
+        length = (uint32_t) floor(log1p(-lbCorpusRandomUnit(random)) / log1p(-p));
+    }
+
+    return length > config->string_max ? config->string_max : length;
+}
+
+// Write `field_count` random fields, recursing into sections, and backpatch the length at length_position.
+static LB_WriterError lbCorpusGenerateFields(LB_Writer *writer, LB_CorpusRandom *random, const LB_CorpusConfig *config,
+                                             const size_t length_position, const uint32_t depth) {
+    LB_WriterError e = LB_WRITER_ERROR_NONE;
+    const uint32_t field_count = lbCorpusRandomRange(random, config->min_fields, config->max_fields);
+    for (uint32_t i = 0; i < field_count; i++) {
+        const LB_CorpusType type = lbCorpusRandomType(random, config, depth < config->max_depth);
+        e |= lbWriteU8(writer, (uint8_t) type);
+        switch (type) {
+            case LB_CORPUS_TYPE_U8:
+                e |= lbWriteU8(writer, (uint8_t) lbCorpusRandomInt(random, config, 8));
+                break;
+            case LB_CORPUS_TYPE_U16:
+                e |= lbWriteU16LE(writer, (uint16_t) lbCorpusRandomInt(random, config, 16));
+                break;
+            case LB_CORPUS_TYPE_U32:
+                e |= lbWriteU32LE(writer, (uint32_t) lbCorpusRandomInt(random, config, 32));
+                break;
+            case LB_CORPUS_TYPE_U64:
+                e |= lbWriteU64LE(writer, lbCorpusRandomInt(random, config, 64));
+                break;
+            case LB_CORPUS_TYPE_I32:
+                e |= lbWriteI32LE(writer, (int32_t) lbCorpusRandomSigned(random, config, 32));
+                break;
+            case LB_CORPUS_TYPE_I64:
+                e |= lbWriteI64LE(writer, lbCorpusRandomSigned(random, config, 64));
+                break;
+            case LB_CORPUS_TYPE_F32:
+                e |= lbWriteF32LE(writer, (float) lbCorpusRandomFloat(random, config));
+                break;
+            case LB_CORPUS_TYPE_F64:
+                e |= lbWriteF64LE(writer, lbCorpusRandomFloat(random, config));
+                break;
+            case LB_CORPUS_TYPE_STRING: {
+                const uint32_t length = lbCorpusRandomStringLength(random, config);
+                e |= lbWriteU16LE(writer, (uint16_t) length);
+                for (uint32_t j = 0; j < length; j++) {
+                    // Printable ASCII, like most identifiers and text.
+                    e |= lbWriteU8(writer, (uint8_t) (' ' + lbCorpusRandomNext(random) % 95));
+                }
+                break;
+            }
+            case LB_CORPUS_TYPE_SECTION: {
+                const size_t section_position = lbWriterPosition(writer);
+                e |= lbWriteU32LE(writer, 0);
+                e |= lbCorpusGenerateFields(writer, random, config, section_position, depth + 1);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    const size_t end = lbWriterPosition(writer);
+    e |= lbWriterSeek(writer, length_position);
+    e |= lbWriteU32LE(writer, (uint32_t) (end - length_position - sizeof(uint32_t)));
+    e |= lbWriterSeek(writer, end);
+    return e;
+}
+
+LB_WriterError lbCorpusGenerate(LB_Writer *writer, const LB_CorpusConfig *config) {
+    LB_CorpusConfig bounded = *config;
+    bounded.max_depth = bounded.max_depth > LB_CORPUS_MAX_DEPTH ? LB_CORPUS_MAX_DEPTH : bounded.max_depth;
+    bounded.string_max = bounded.string_max > LB_CORPUS_MAX_STRING ? LB_CORPUS_MAX_STRING : bounded.string_max;
+    bounded.max_fields = bounded.max_fields < bounded.min_fields ? bounded.min_fields : bounded.max_fields;
+
+    LB_CorpusRandom random = {bounded.seed};
+    LB_WriterError e = LB_WRITER_ERROR_NONE;
+    e |= lbWriteU32LE(writer, LB_CORPUS_MAGIC);
+    e |= lbWriteU16LE(writer, LB_CORPUS_VERSION);
+    e |= lbWriteU32LE(writer, bounded.message_count);
+    for (uint32_t i = 0; i < bounded.message_count && !e; i++) {
+        const size_t message_position = lbWriterPosition(writer);
+        e |= lbWriteU32LE(writer, 0);
+        e |= lbCorpusGenerateFields(writer, &random, &bounded, message_position, 0);
+    }
+
+    return e;
+}
+
+// Read a fixed size little endian field, lbRead reports the end of a file even with safety compiled out.
+static LB_ReaderError lbCorpusReadField(LB_Reader *reader, void *out_value, const size_t length) {
+    if (lbReaderRemaining(reader) < length) {
+        return LB_READER_ERROR_END;
+    }
+
+    return lbReadLE(reader, out_value, length);
+}
+
+int lbCorpusLoad(LB_Reader *reader, LB_Corpus *out_corpus) {
+    memset(out_corpus, 0, sizeof(*out_corpus));
+
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint32_t count = 0;
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    e |= lbCorpusReadField(reader, &magic, sizeof(magic));
+    e |= lbCorpusReadField(reader, &version, sizeof(version));
+    e |= lbCorpusReadField(reader, &count, sizeof(count));
+
+    const size_t length = lbReaderRemaining(reader);
+    if (e || magic != LB_CORPUS_MAGIC || version != LB_CORPUS_VERSION || count > length / sizeof(uint32_t)) {
+        return 0;
+    }
+
+    out_corpus->data = (uint8_t *) malloc(length ? length : 1);
+    out_corpus->offsets = (size_t *) malloc(((size_t) count + 1) * sizeof(size_t));
+    if (out_corpus->data == NULL || out_corpus->offsets == NULL || (length && lbRead(reader, out_corpus->data, length))) {
+        lbCorpusFree(out_corpus);
+        return 0;
+    }
+
+    out_corpus->length = length;
+    out_corpus->message_count = count;
+
+    LB_Reader messages;
+    if (count > 0 && lbReaderInitBuffer(&messages, out_corpus->data, length) != LB_READER_INIT_NONE) {
+        lbCorpusFree(out_corpus);
+        return 0;
+    }
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t message_length = 0;
+        if (length - offset < sizeof(uint32_t) || lbReaderSeek(&messages, offset) ||
+            lbCorpusReadField(&messages, &message_length, sizeof(message_length)) ||
+            length - offset - sizeof(uint32_t) < message_length) {
+            lbCorpusFree(out_corpus);
+            return 0;
+        }
+
+        out_corpus->offsets[i] = offset;
+        offset += sizeof(uint32_t) + message_length;
+    }
+
+    out_corpus->offsets[count] = offset;
+    return 1;
+}
+
+void lbCorpusFree(LB_Corpus *corpus) {
+    free(corpus->data);
+    free(corpus->offsets);
+    memset(corpus, 0, sizeof(*corpus));
+}
+
+typedef struct LB_CorpusValues {
+    LB_CorpusValue *values;
+    size_t count;
+    size_t capacity;
+} LB_CorpusValues;
+
+static LB_CorpusValue *lbCorpusValuesPush(LB_CorpusValues *values, const LB_CorpusType type) {
+    if (values->count == values->capacity) {
+        const size_t capacity = values->capacity ? values->capacity * 2 : 1024;
+        LB_CorpusValue *grown = (LB_CorpusValue *) realloc(values->values, capacity * sizeof(LB_CorpusValue));
+        if (grown == NULL) {
+            return NULL;
+        }
+
+        values->values = grown;
+        values->capacity = capacity;
+    }
+
+    LB_CorpusValue *value = &values->values[values->count++];
+    memset(value, 0, sizeof(*value));
+    value->type = type;
+    return value;
+}
+
+// Parse fields until `end`, returns 0 if they are malformed.
+static int lbCorpusParseFields(LB_Reader *reader, const uint8_t *data, const size_t end, const uint32_t depth,
+                               uint8_t *scratch, LB_CorpusValues *values) {
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    while (lbReaderPosition(reader) < end && !e) {
+        uint8_t tag = 0;
+        e |= lbCorpusReadField(reader, &tag, sizeof(tag));
+        LB_CorpusValue *value = lbCorpusValuesPush(values, (LB_CorpusType) tag);
+        if (value == NULL) {
+            return 0;
+        }
+
+        switch (tag) {
+            case LB_CORPUS_TYPE_U8: {
+                uint8_t v = 0;
+                e |= lbCorpusReadField(reader, &v, sizeof(v));
+                value->u = v;
+                break;
+            }
+            case LB_CORPUS_TYPE_U16: {
+                uint16_t v = 0;
+                e |= lbCorpusReadField(reader, &v, sizeof(v));
+                value->u = v;
+                break;
+            }
+            case LB_CORPUS_TYPE_U32: {
+                uint32_t v = 0;
+                e |= lbCorpusReadField(reader, &v, sizeof(v));
+                value->u = v;
+                break;
+            }
+            case LB_CORPUS_TYPE_U64:
+                e |= lbCorpusReadField(reader, &value->u, sizeof(value->u));
+                break;
+            case LB_CORPUS_TYPE_I32: {
+                int32_t v = 0;
+                e |= lbCorpusReadField(reader, &v, sizeof(v));
+                value->i = v;
+                break;
+            }
+            case LB_CORPUS_TYPE_I64:
+                e |= lbCorpusReadField(reader, &value->i, sizeof(value->i));
+                break;
+            case LB_CORPUS_TYPE_F32: {
+                float v = 0.0f;
+                e |= lbCorpusReadField(reader, &v, sizeof(v));
+                value->f = v;
+                break;
+            }
+            case LB_CORPUS_TYPE_F64:
+                e |= lbCorpusReadField(reader, &value->f, sizeof(value->f));
+                break;
+            case LB_CORPUS_TYPE_STRING: {
+                uint16_t length = 0;
+                e |= lbCorpusReadField(reader, &length, sizeof(length));
+                const size_t position = lbReaderPosition(reader);
+                if (e || end - position < length) {
+                    return 0;
+                }
+
+                value->length = length;
+                value->string = data + position;
+                // Read rather than seek past it, lbReaderSeek does not accept the end of the buffer.
+                if (length) {
+                    e |= lbRead(reader, scratch, length);
+                }
+                break;
+            }
+            case LB_CORPUS_TYPE_SECTION: {
+                uint32_t length = 0;
+                e |= lbCorpusReadField(reader, &length, sizeof(length));
+                const size_t position = lbReaderPosition(reader);
+                if (e || depth >= LB_CORPUS_MAX_DEPTH || end - position < length ||
+                    !lbCorpusParseFields(reader, data, position + length, depth + 1, scratch, values) ||
+                    lbCorpusValuesPush(values, LB_CORPUS_TYPE_SECTION_END) == NULL) {
+                    return 0;
+                }
+                break;
+            }
+            default:
+                return 0;
+        }
+    }
+
+    return !e && lbReaderPosition(reader) == end;
+}
+
+int lbCorpusParse(const LB_Corpus *corpus, LB_CorpusValue **out_values, size_t *out_count) {
+    *out_values = NULL;
+    *out_count = 0;
+
+    uint8_t *scratch = (uint8_t *) malloc(LB_CORPUS_MAX_STRING);
+    if (scratch == NULL) {
+        return 0;
+    }
+
+    LB_CorpusValues values = {0};
+    for (size_t i = 0; i < corpus->message_count; i++) {
+        const size_t start = corpus->offsets[i] + sizeof(uint32_t);
+        const size_t end = corpus->offsets[i + 1];
+        // A message without fields (--min-fields 0) is just its end marker, and an empty buffer is not a valid reader.
+        LB_Reader reader;
+        if ((end > start && (lbReaderInitBuffer(&reader, corpus->data + start, end - start) != LB_READER_INIT_NONE ||
+                             !lbCorpusParseFields(&reader, corpus->data + start, end - start, 0, scratch, &values))) ||
+            lbCorpusValuesPush(&values, LB_CORPUS_TYPE_MESSAGE_END) == NULL) {
+            free(scratch);
+            free(values.values);
+            return 0;
+        }
+    }
+
+    free(scratch);
+    *out_values = values.values;
+    *out_count = values.count;
+    return 1;
+}
+
+size_t lbCorpusEncodeMessage(LB_Writer *writer, const LB_CorpusValue *values, LB_WriterError *out_error) {
+    size_t stack[LB_CORPUS_MAX_DEPTH + 1];
+    uint32_t depth = 0;
+    LB_WriterError e = LB_WRITER_ERROR_NONE;
+
+    stack[depth++] = lbWriterPosition(writer);
+    e |= lbWriteU32LE(writer, 0);
+
+    size_t i = 0;
+    for (;; i++) {
+        const LB_CorpusValue *value = &values[i];
+        if (value->type == LB_CORPUS_TYPE_SECTION_END || value->type == LB_CORPUS_TYPE_MESSAGE_END) {
+            const size_t end = lbWriterPosition(writer);
+            const size_t position = stack[--depth];
+            e |= lbWriterSeek(writer, position);
+            e |= lbWriteU32LE(writer, (uint32_t) (end - position - sizeof(uint32_t)));
+            e |= lbWriterSeek(writer, end);
+            if (value->type == LB_CORPUS_TYPE_MESSAGE_END || depth == 0) {
+                break;
+            }
+            continue;
+        }
+
+        e |= lbWriteU8(writer, (uint8_t) value->type);
+        switch (value->type) {
+            case LB_CORPUS_TYPE_U8:
+                e |= lbWriteU8(writer, (uint8_t) value->u);
+                break;
+            case LB_CORPUS_TYPE_U16:
+                e |= lbWriteU16LE(writer, (uint16_t) value->u);
+                break;
+            case LB_CORPUS_TYPE_U32:
+                e |= lbWriteU32LE(writer, (uint32_t) value->u);
+                break;
+            case LB_CORPUS_TYPE_U64:
+                e |= lbWriteU64LE(writer, value->u);
+                break;
+            case LB_CORPUS_TYPE_I32:
+                e |= lbWriteI32LE(writer, (int32_t) value->i);
+                break;
+            case LB_CORPUS_TYPE_I64:
+                e |= lbWriteI64LE(writer, value->i);
+                break;
+            case LB_CORPUS_TYPE_F32:
+                e |= lbWriteF32LE(writer, (float) value->f);
+                break;
+            case LB_CORPUS_TYPE_F64:
+                e |= lbWriteF64LE(writer, value->f);
+                break;
+            case LB_CORPUS_TYPE_STRING:
+                e |= lbWriteU16LE(writer, (uint16_t) value->length);
+                if (value->length) {
+                    e |= lbWrite(writer, value->string, value->length);
+                }
+                break;
+            case LB_CORPUS_TYPE_SECTION:
+                if (depth > LB_CORPUS_MAX_DEPTH) {
+                    e |= LB_WRITER_ERROR_INVALID_VALUE;
+                    break;
+                }
+                stack[depth++] = lbWriterPosition(writer);
+                e |= lbWriteU32LE(writer, 0);
+                break;
+            default:
+                e |= LB_WRITER_ERROR_INVALID_VALUE;
+                break;
+        }
+    }
+
+    if (out_error != NULL) {
+        *out_error = e;
+    }
+    return i + 1;
+}
+
+LB_ReaderError lbCorpusDecodeMessage(LB_Reader *reader, uint8_t *scratch, uint64_t *checksum) {
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    const uint32_t length = lbReadU32LE(reader, &e);
+    const size_t end = lbReaderPosition(reader) + length;
+
+    uint64_t sum = *checksum;
+    while (lbReaderPosition(reader) < end && !e) {
+        // The typed reads assign the error rather than or-ing it, so every one is checked before the next.
+        const uint8_t tag = lbReadU8(reader, &e);
+        if (e) {
+            break;
+        }
+
+        switch (tag) {
+            case LB_CORPUS_TYPE_U8:
+                sum += lbReadU8(reader, &e);
+                break;
+            case LB_CORPUS_TYPE_U16:
+                sum += lbReadU16LE(reader, &e);
+                break;
+            case LB_CORPUS_TYPE_U32:
+                sum += lbReadU32LE(reader, &e);
+                break;
+            case LB_CORPUS_TYPE_U64:
+                sum += lbReadU64LE(reader, &e);
+                break;
+            case LB_CORPUS_TYPE_I32:
+                sum += (uint64_t) lbReadI32LE(reader, &e);
+                break;
+            case LB_CORPUS_TYPE_I64:
+                sum += (uint64_t) lbReadI64LE(reader, &e);
+                break;
+            case LB_CORPUS_TYPE_F32: {
+                const float value = lbReadF32LE(reader, &e);
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                sum += bits;
+                break;
+            }
+            case LB_CORPUS_TYPE_F64: {
+                const double value = lbReadF64LE(reader, &e);
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                sum += bits;
+                break;
+            }
+            case LB_CORPUS_TYPE_STRING: {
+                const uint16_t string_length = lbReadU16LE(reader, &e);
+                if (!e && string_length) {
+                    e |= lbRead(reader, scratch, string_length);
+                    sum += scratch[0] + scratch[string_length - 1];
+                }
+                break;
+            }
+            case LB_CORPUS_TYPE_SECTION:
+                // The nested fields follow inline, the length only matters to readers that skip sections.
+                sum += lbReadU32LE(reader, &e);
+                break;
+            default:
+                e |= LB_READER_ERROR_INVALID_VALUE;
+                break;
+        }
+
+        sum = sum * 31 + tag;
+    }
+
+    *checksum = sum;
+    return e;
+}
+
+#endif //LB_CORPUS_IMPLEMENTATION
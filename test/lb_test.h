@@ -0,0 +1,31 @@
+#ifndef LB_TEST_H
+#define LB_TEST_H
+
+#include <stdio.h>
+
+/*
+ * Minimal assertion harness for the lb_buffer_*_test targets run by ctest.
+ *
+ * LB_CHECK reports a failed condition and keeps going, main returns lbTestResult() so that any failure fails the test.
+ */
+
+static int lb_test_failures = 0;
+
+#define LB_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            lb_test_failures++; \
+        } \
+    } while (0)
+
+static int lbTestResult(void) {
+    if (lb_test_failures) {
+        fprintf(stderr, "%d check(s) failed\n", lb_test_failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif //LB_TEST_H
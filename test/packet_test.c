@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lb_buffer.h"
+#include "lb_packet.h"
+
+#include "lb_test.h"
+
+/*
+ * Fragments messages with a LB_PacketWriter, carries the packets over an in-memory loopback and reassembles them,
+ * in order, reordered and with duplicates.
+ */
+
+#define MTU 512
+#define MAX_PACKETS 64
+#define MAX_MESSAGES 16
+
+typedef struct Loopback {
+    uint8_t *packets[MAX_PACKETS];
+    size_t lengths[MAX_PACKETS];
+    size_t count;
+} Loopback;
+
+typedef struct Inbox {
+    uint8_t *messages[MAX_MESSAGES];
+    size_t lengths[MAX_MESSAGES];
+    size_t count;
+} Inbox;
+
+static void loopbackSend(void *user, const void *packet, const size_t length) {
+    Loopback *loopback = (Loopback *) user;
+    LB_CHECK(length <= MTU);
+    if (loopback->count == MAX_PACKETS) {
+        LB_CHECK(!"too many packets");
+        return;
+    }
+
+    loopback->packets[loopback->count] = (uint8_t *) malloc(length);
+    memcpy(loopback->packets[loopback->count], packet, length);
+    loopback->lengths[loopback->count++] = length;
+}
+
+static void inboxReceive(void *user, LB_Reader *message) {
+    Inbox *inbox = (Inbox *) user;
+    if (inbox->count == MAX_MESSAGES) {
+        LB_CHECK(!"too many messages");
+        return;
+    }
+
+    const size_t length = lbReaderRemaining(message);
+    if (length > MAX_PACKETS * MTU) {
+        LB_CHECK(!"message longer than every packet");
+        return;
+    }
+
+    uint8_t *data = (uint8_t *) malloc(length ? length : 1);
+    LB_CHECK(length == 0 || lbRead(message, data, length) == LB_READER_ERROR_NONE);
+    inbox->messages[inbox->count] = data;
+    inbox->lengths[inbox->count++] = length;
+}
+
+static void loopbackFree(Loopback *loopback) {
+    for (size_t i = 0; i < loopback->count; i++) {
+        free(loopback->packets[i]);
+    }
+    loopback->count = 0;
+}
+
+static void inboxFree(Inbox *inbox) {
+    for (size_t i = 0; i < inbox->count; i++) {
+        free(inbox->messages[i]);
+    }
+    inbox->count = 0;
+}
+
+static int inboxHas(const Inbox *inbox, const size_t index, const void *data, const size_t length) {
+    if (index >= inbox->count || inbox->lengths[index] != length) {
+        return 0;
+    }
+
+    return length == 0 || memcmp(inbox->messages[index], data, length) == 0;
+}
+
+static void fill(uint8_t *data, const size_t length, const uint32_t seed) {
+    uint32_t state = seed;
+    for (size_t i = 0; i < length; i++) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = (uint8_t) (state >> 24);
+    }
+}
+
+static void testLoopback(void) {
+    Loopback loopback = {0};
+    Inbox inbox = {0};
+    LB_PacketWriter packet_writer;
+    LB_PacketReassembler reassembler;
+    LB_CHECK(lbPacketWriterInit(&packet_writer, MTU, loopbackSend, &loopback) == LB_PACKET_INIT_NONE);
+    LB_CHECK(lbPacketReassemblerInit(&reassembler, inboxReceive, &inbox) == LB_PACKET_INIT_NONE);
+
+    uint8_t small[40];
+    uint8_t large[5000];
+    fill(small, sizeof(small), 1);
+    fill(large, sizeof(large), 2);
+
+    LB_CHECK(lbPacketWriteMessage(&packet_writer, small, sizeof(small)) == LB_WRITER_ERROR_NONE);
+    LB_CHECK(lbPacketWriteMessage(&packet_writer, small, 0) == LB_WRITER_ERROR_NONE);
+    LB_CHECK(lbPacketWriteMessage(&packet_writer, large, sizeof(large)) == LB_WRITER_ERROR_NONE);
+    LB_Writer *message = lbPacketWriterBeginMessage(&packet_writer, 8);
+    LB_CHECK(message != NULL);
+    lbWriteU32LE(message, 0x12345678);
+    lbPacketWriterEndMessage(&packet_writer);
+    lbPacketWriterFlush(&packet_writer);
+
+    // The large message is split over ceil(5000 / 502) = 10 packets, the small ones share the first and the last.
+    LB_CHECK(loopback.count == 1 + 10);
+
+    for (size_t i = 0; i < loopback.count; i++) {
+        LB_CHECK(lbPacketReceive(&reassembler, loopback.packets[i], loopback.lengths[i]) == LB_READER_ERROR_NONE);
+    }
+
+    const uint8_t word[] = {0x78, 0x56, 0x34, 0x12};
+    LB_CHECK(inbox.count == 4);
+    LB_CHECK(inboxHas(&inbox, 0, small, sizeof(small)));
+    LB_CHECK(inboxHas(&inbox, 1, small, 0));
+    LB_CHECK(inboxHas(&inbox, 2, large, sizeof(large)));
+    LB_CHECK(inboxHas(&inbox, 3, word, sizeof(word)));
+    inboxFree(&inbox);
+
+    // The fragments reversed and every packet twice. Unfragmented messages are not deduplicated, so the one sharing the
+    // last packet arrives twice, the fragmented message once.
+    for (size_t i = loopback.count; i-- > 1;) {
+        LB_CHECK(lbPacketReceive(&reassembler, loopback.packets[i], loopback.lengths[i]) == LB_READER_ERROR_NONE);
+        LB_CHECK(lbPacketReceive(&reassembler, loopback.packets[i], loopback.lengths[i]) == LB_READER_ERROR_NONE);
+    }
+
+    LB_CHECK(inbox.count == 3);
+    LB_CHECK(inboxHas(&inbox, 0, word, sizeof(word)));
+    LB_CHECK(inboxHas(&inbox, 1, word, sizeof(word)));
+    LB_CHECK(inboxHas(&inbox, 2, large, sizeof(large)));
+
+    inboxFree(&inbox);
+    loopbackFree(&loopback);
+    lbPacketReassemblerFree(&reassembler);
+    lbPacketWriterFree(&packet_writer);
+}
+
+static void testLimits(void) {
+    Loopback loopback = {0};
+    Inbox inbox = {0};
+    LB_PacketWriter packet_writer;
+    LB_PacketReassembler reassembler;
+    LB_CHECK(lbPacketWriterInit(&packet_writer, MTU, loopbackSend, &loopback) == LB_PACKET_INIT_NONE);
+    LB_CHECK(lbPacketReassemblerInit(&reassembler, inboxReceive, &inbox) == LB_PACKET_INIT_NONE);
+
+    // One byte more than LB_PACKET_MAX_FRAGMENTS full fragments.
+    const size_t too_long = (size_t) LB_PACKET_MAX_FRAGMENTS * (MTU - LB_PACKET_FRAME_HEADER_SIZE) + 1;
+    uint8_t *data = (uint8_t *) calloc(too_long, 1);
+    LB_CHECK(lbPacketWriteMessage(&packet_writer, data, too_long) == LB_WRITER_ERROR_INVALID_VALUE);
+    LB_CHECK(loopback.count == 0);
+    free(data);
+
+    // A forged header announcing 65535 fragments is dropped without creating a pending message.
+    uint8_t packet[LB_PACKET_FRAME_HEADER_SIZE + 1];
+    LB_Writer writer;
+    lbWriterInitBuffer(&writer, packet, sizeof(packet));
+    lbWriteU32LE(&writer, 7);
+    lbWriteU16LE(&writer, 0);
+    lbWriteU16LE(&writer, UINT16_MAX);
+    lbWriteU16LE(&writer, 1);
+    lbWriteU8(&writer, 0xAB);
+    LB_CHECK(lbPacketReceive(&reassembler, packet, sizeof(packet)) == LB_READER_ERROR_NONE);
+    LB_CHECK(inbox.count == 0);
+    for (size_t i = 0; i < LB_PACKET_MAX_PENDING; i++) {
+        LB_CHECK(reassembler.pending[i].segments == NULL);
+    }
+
+    // A payload longer than the packet is malformed.
+    LB_CHECK(lbPacketReceive(&reassembler, packet, sizeof(packet) - 1) == LB_READER_ERROR_INVALID_VALUE);
+
+    lbPacketReassemblerFree(&reassembler);
+    lbPacketWriterFree(&packet_writer);
+}
+
+int main(void) {
+    testLoopback();
+    testLimits();
+    return lbTestResult();
+}
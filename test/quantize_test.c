@@ -0,0 +1,107 @@
+#include <math.h>
+#include <stdint.h>
+
+#include "lb_buffer.h"
+#include "lb_quantize.h"
+
+#include "lb_test.h"
+
+// Writes `value` through the quantizer and reads it back, returns the write error.
+static LB_WriterError roundTrip(const LB_Quantizer *quantizer, const double value, double *out_value) {
+    uint8_t data[16];
+    LB_Writer writer;
+    lbWriterInitBuffer(&writer, data, sizeof(data));
+    LB_BitWriter bit_writer;
+    lbBitWriterInit(&bit_writer, &writer);
+    const LB_WriterError e = lbWriteQuantizer(&bit_writer, quantizer, value);
+    lbBitWriterFlush(&bit_writer);
+    if (e) {
+        return e;
+    }
+
+    LB_Reader reader;
+    lbReaderInitBuffer(&reader, data, lbWriterPosition(&writer));
+    LB_BitReader bit_reader;
+    lbBitReaderInit(&bit_reader, &reader);
+    LB_ReaderError read_error = LB_READER_ERROR_NONE;
+    *out_value = lbReadQuantizer(&bit_reader, quantizer, &read_error);
+    LB_CHECK(read_error == LB_READER_ERROR_NONE);
+    return LB_WRITER_ERROR_NONE;
+}
+
+static void testClosed(void) {
+    LB_Quantizer quantizer;
+    LB_CHECK(lbQuantizerInitResolution(&quantizer, -4096.0, 4096.0, 1.0 / 64.0) == LB_QUANTIZER_INIT_NONE);
+    LB_CHECK(quantizer.bits == 20);
+
+    double value = 0.0;
+    LB_CHECK(roundTrip(&quantizer, -4096.0, &value) == LB_WRITER_ERROR_NONE && value == -4096.0);
+    LB_CHECK(roundTrip(&quantizer, 4096.0, &value) == LB_WRITER_ERROR_NONE && value == 4096.0);
+    LB_CHECK(roundTrip(&quantizer, 1.5, &value) == LB_WRITER_ERROR_NONE && fabs(value - 1.5) <= quantizer.step / 2);
+#ifdef LB_WRITER_SAFETY
+    LB_CHECK(roundTrip(&quantizer, nextafter(4096.0, INFINITY), &value) == LB_WRITER_ERROR_INVALID_VALUE);
+    LB_CHECK(roundTrip(&quantizer, nextafter(-4096.0, -INFINITY), &value) == LB_WRITER_ERROR_INVALID_VALUE);
+#endif
+}
+
+static void testHalfOpen(void) {
+    LB_Quantizer quantizer;
+    LB_CHECK(lbQuantizerInitHalfOpen(&quantizer, -4096.0, 4096.0, 19) == LB_QUANTIZER_INIT_NONE);
+    LB_CHECK(quantizer.step == 1.0 / 64.0);
+    LB_CHECK(quantizer.max == 4096.0);
+
+    // The lower end is included and exact.
+    double value = 0.0;
+    LB_CHECK(roundTrip(&quantizer, -4096.0, &value) == LB_WRITER_ERROR_NONE && value == -4096.0);
+    LB_CHECK(lbQuantize(&quantizer, -4096.0) == 0);
+
+    // The last code is max - step, every value above it up to max is accepted and clamped to it.
+    const double last = 4096.0 - 1.0 / 64.0;
+    LB_CHECK(roundTrip(&quantizer, last, &value) == LB_WRITER_ERROR_NONE && value == last);
+    LB_CHECK(roundTrip(&quantizer, 4095.99, &value) == LB_WRITER_ERROR_NONE && value == last);
+    LB_CHECK(roundTrip(&quantizer, nextafter(4096.0, 0.0), &value) == LB_WRITER_ERROR_NONE && value == last);
+    LB_CHECK(lbQuantize(&quantizer, 4095.999) == quantizer.max_code);
+    LB_CHECK(lbDequantize(&quantizer, quantizer.max_code) == last);
+
+#ifdef LB_WRITER_SAFETY
+    // The upper end is excluded.
+    LB_CHECK(roundTrip(&quantizer, 4096.0, &value) == LB_WRITER_ERROR_INVALID_VALUE);
+    LB_CHECK(roundTrip(&quantizer, nextafter(-4096.0, -INFINITY), &value) == LB_WRITER_ERROR_INVALID_VALUE);
+#endif
+}
+
+static void testF32Array(void) {
+    LB_Quantizer quantizer;
+    LB_CHECK(lbQuantizerInitHalfOpen(&quantizer, 0.0, 1.0, 8) == LB_QUANTIZER_INIT_NONE);
+
+    const float values[] = {0.0f, 0.25f, 0.5f, 0.99999f};
+    const float expected[] = {0.0f, 0.25f, 0.5f, 255.0f / 256.0f};
+    uint8_t data[16];
+    LB_Writer writer;
+    lbWriterInitBuffer(&writer, data, sizeof(data));
+    LB_BitWriter bit_writer;
+    lbBitWriterInit(&bit_writer, &writer);
+    LB_CHECK(lbWriteQuantizerF32Array(&bit_writer, &quantizer, values, 4) == LB_WRITER_ERROR_NONE);
+#ifdef LB_WRITER_SAFETY
+    const float out_of_range = 1.0f;
+    LB_CHECK(lbWriteQuantizerF32Array(&bit_writer, &quantizer, &out_of_range, 1) == LB_WRITER_ERROR_INVALID_VALUE);
+#endif
+    lbBitWriterFlush(&bit_writer);
+
+    LB_Reader reader;
+    lbReaderInitBuffer(&reader, data, lbWriterPosition(&writer));
+    LB_BitReader bit_reader;
+    lbBitReaderInit(&bit_reader, &reader);
+    float out_values[4];
+    LB_CHECK(lbReadQuantizerF32Array(&bit_reader, &quantizer, out_values, 4) == LB_READER_ERROR_NONE);
+    for (int i = 0; i < 4; i++) {
+        LB_CHECK(out_values[i] == expected[i]);
+    }
+}
+
+int main(void) {
+    testClosed();
+    testHalfOpen();
+    testF32Array();
+    return lbTestResult();
+}
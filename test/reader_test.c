@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define HAS_PIPE
+#endif
+
+#include "lb_buffer.h"
+
+#include "lb_test.h"
+
+/*
+ * File readers: the length is measured once and the position tracked by the reader, for regular files and for
+ * streams without a length, with and without the FILE lock.
+ */
+
+static void testFile(void) {
+    FILE *file = tmpfile();
+    LB_CHECK(file != NULL);
+    for (uint32_t i = 0; i < 100; i++) {
+        fwrite(&i, sizeof(i), 1, file);
+    }
+
+    // Starts from the stream's position.
+    LB_CHECK(LB_FILE_SEEK(file, 8, SEEK_SET) == 0);
+    LB_Reader reader;
+    LB_CHECK(lbReaderInitFile(&reader, file) == LB_READER_INIT_NONE);
+    LB_CHECK(lbReaderLength(&reader) == 400);
+    LB_CHECK(lbReaderPosition(&reader) == 8);
+    LB_CHECK(lbReaderRemaining(&reader) == 392);
+
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    LB_CHECK(lbReadU32(&reader, &e) == 2 && e == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReadU32BE(&reader, &e) == 0x03000000 && e == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReaderPosition(&reader) == 16);
+
+    LB_CHECK(lbReaderSkip(&reader, 8) == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReaderPosition(&reader) == 24);
+    LB_CHECK(lbReadU32(&reader, &e) == 6);
+
+    LB_CHECK(lbReaderSeekRelative(&reader, -8) == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReaderPosition(&reader) == 20);
+    LB_CHECK(lbReadU32(&reader, &e) == 5);
+
+    LB_CHECK(lbReaderSeek(&reader, 396) == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReaderRemaining(&reader) == 4);
+    LB_CHECK(lbReaderSkip(&reader, 5) == LB_READER_ERROR_END);
+    LB_CHECK(lbReaderPosition(&reader) == 396);
+
+    // A read past the end fails after consuming the last bytes, the position follows the stream.
+    uint64_t value;
+    LB_CHECK(lbRead(&reader, &value, sizeof(value)) == LB_READER_ERROR_END);
+    LB_CHECK(lbReaderPosition(&reader) == 400);
+    LB_CHECK(lbReaderRemaining(&reader) == 0);
+    fclose(file);
+}
+
+// lbWriterSetUnlocked and lbReaderSetUnlocked only change which stdio calls are made.
+static void testUnlocked(void) {
+    FILE *file = tmpfile();
+    LB_CHECK(file != NULL);
+    LB_Writer writer;
+    LB_CHECK(lbWriterInitFile(&writer, file) == LB_WRITER_INIT_NONE);
+    lbWriterSetUnlocked(&writer, 1);
+    lbWriterLock(&writer);
+    LB_CHECK(lbWriteU32LE(&writer, 0x01020304) == LB_WRITER_ERROR_NONE);
+    LB_CHECK(lbWriteU32BE(&writer, 0x05060708) == LB_WRITER_ERROR_NONE);
+    LB_CHECK(lbWriterFlush(&writer) == LB_WRITER_ERROR_NONE);
+    lbWriterUnlock(&writer);
+
+    rewind(file);
+    LB_Reader reader;
+    LB_CHECK(lbReaderInitFile(&reader, file) == LB_READER_INIT_NONE);
+    lbReaderSetUnlocked(&reader, 1);
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    LB_CHECK(lbReadU32LE(&reader, &e) == 0x01020304 && e == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReadU32BE(&reader, &e) == 0x05060708 && e == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReaderPosition(&reader) == 8);
+    lbReadU8(&reader, &e);
+    LB_CHECK(e == LB_READER_ERROR_END);
+    fclose(file);
+}
+
+#ifdef HAS_PIPE
+static void testPipe(void) {
+    int fds[2];
+    LB_CHECK(pipe(fds) == 0);
+    const uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+    LB_CHECK(write(fds[1], data, sizeof(data)) == sizeof(data));
+    close(fds[1]);
+
+    FILE *file = fdopen(fds[0], "rb");
+    LB_CHECK(file != NULL);
+    LB_Reader reader;
+    LB_CHECK(lbReaderInitFile(&reader, file) == LB_READER_INIT_NONE);
+    LB_CHECK(lbReaderLength(&reader) == SIZE_MAX);
+    LB_CHECK(lbReaderRemaining(&reader) == SIZE_MAX);
+    LB_CHECK(lbReaderPosition(&reader) == 0);
+
+    LB_ReaderError e = LB_READER_ERROR_NONE;
+    LB_CHECK(lbReadU16LE(&reader, &e) == 0x0201 && e == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReadU32LE(&reader, &e) == 0x06050403 && e == LB_READER_ERROR_NONE);
+    LB_CHECK(lbReaderPosition(&reader) == 6);
+    LB_CHECK(lbReaderRemaining(&reader) == SIZE_MAX);
+
+    lbReadU8(&reader, &e);
+    LB_CHECK(e == LB_READER_ERROR_END);
+    fclose(file);
+}
+#endif
+
+int main(void) {
+    testFile();
+    testUnlocked();
+#ifdef HAS_PIPE
+    testPipe();
+#endif
+    return lbTestResult();
+}